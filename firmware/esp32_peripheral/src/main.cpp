@@ -9,6 +9,8 @@
 #include <Arduino.h>
 #include <Protocol.h>
 #include <ShiftRegisterDMA.h>
+#include <ScanScheduler.h>
+#include <FrameDiff.h>
 #include <EncoderDecoder.h>
 #include <ButtonHandler.h>
 #include <LockFreeQueue.h>
@@ -52,11 +54,17 @@
 #define ENCODER_OFFSET 0
 #define BUTTON_OFFSET 64
 
+// Scan pacing: hardware timer at this rate (latch on the timer edge), or 0
+// to free-run ping-pong DMA at SPI speed (~9.6kHz for 13 chips at 1MHz)
+#define SCAN_RATE_HZ 5000
+
 // ============================================================================
 // GLOBAL OBJECTS
 // ============================================================================
 
 ShiftRegisterDMA shiftReg(VSPI_HOST, SR_MISO_PIN, SR_SCK_PIN, SR_LATCH_PIN, SR_NUM_CHIPS);
+ScanScheduler scheduler;
+FrameDiff frameDiff(SR_NUM_CHIPS);
 EncoderDecoder encoders(NUM_ENCODERS);
 ButtonHandler buttons(NUM_BUTTONS);
 LockFreeQueue<EventMessage> eventQueue(128);
@@ -67,32 +75,32 @@ Diagnostics diagnostics;
 // CORE 0 - SCANNER TASK (High Priority)
 // ============================================================================
 
-void core0_scanner_task(void* param) {
-    TickType_t lastWakeTime = xTaskGetTickCount();
-    const TickType_t scanInterval = pdMS_TO_TICKS(1000 / 5000);  // 5kHz scan rate (32-encoder panel)
-
-    while (1) {
-        uint32_t cycleStart = micros();
-
-        // Start DMA read
-        shiftReg.startDMA();
+// Decode one shift register frame and queue the resulting events
+void processFrame(const uint8_t* data) {
+    // Skip decoding entirely when no input bit changed and no button is
+    // part-way through debouncing (the common idle case)
+    if (!frameDiff.compare(data) && buttons.isSettled()) {
+        diagnostics.recordSkippedScan();
+    } else {
+        const uint8_t* diff = frameDiff.getDiff();
 
-        // Wait for DMA completion
-        while (!shiftReg.isDMAComplete()) {
-            taskYIELD();
-        }
+        // Update encoders (first half of data, changed words only)
+        encoders.update(data, diff);
 
-        // Get shift register data
-        const uint8_t* data = shiftReg.getDMABuffer();
+        // Update buttons (second half of data, changed words only)
+        buttons.update(data + ENCODER_OFFSET, BUTTON_OFFSET, diff + ENCODER_OFFSET);
+    }
 
-        // Update encoders (first half of data)
-        encoders.update(data);
+    // Events carry panel-local IDs (encoders 0..N-1, buttons from N);
+    // the Teensy maps them to global IDs (ControlMap.h)
 
-        // Update buttons (second half of data)
-        buttons.update(data + ENCODER_OFFSET, BUTTON_OFFSET);
+    // Generate encoder events (only encoders that moved)
+    for (uint8_t w = 0; w < encoders.getNumWords(); w++) {
+        uint32_t pending = encoders.getPendingMask(w);
+        while (pending) {
+            uint16_t i = w * 32 + __builtin_ctz(pending);
+            pending &= pending - 1;
 
-        // Generate encoder events
-        for (uint16_t i = 0; i < NUM_ENCODERS; i++) {
             int8_t delta = encoders.getDelta(i);
             if (delta != 0) {
                 EventMessage event;
@@ -106,40 +114,102 @@ void core0_scanner_task(void* param) {
                 }
             }
         }
+    }
 
-        // Generate button events
-        for (uint16_t i = 0; i < NUM_BUTTONS; i++) {
-            if (buttons.isPressed(i)) {
-                EventMessage event;
-                event.globalID = NUM_ENCODERS + i;
-                event.value = 127;
-                event.flags = EVENT_FLAG_BUTTON_PRESSED;
-                event.timestamp = micros();
-
-                if (!eventQueue.push(event)) {
-                    diagnostics.recordEvent(true);
-                }
+    // Generate button events (only buttons with an edge)
+    for (uint8_t w = 0; w < buttons.getNumWords(); w++) {
+        uint32_t pressed = buttons.takePressedMask(w);
+        while (pressed) {
+            uint16_t i = w * 32 + __builtin_ctz(pressed);
+            pressed &= pressed - 1;
+
+            EventMessage event;
+            event.globalID = NUM_ENCODERS + i;
+            event.value = 127;
+            event.flags = EVENT_FLAG_BUTTON_PRESSED;
+            event.timestamp = micros();
+
+            if (!eventQueue.push(event)) {
+                diagnostics.recordEvent(true);
             }
+        }
 
-            if (buttons.isReleased(i)) {
-                EventMessage event;
-                event.globalID = NUM_ENCODERS + i;
-                event.value = 0;
-                event.flags = EVENT_FLAG_BUTTON_RELEASED;
-                event.timestamp = micros();
+        uint32_t released = buttons.takeReleasedMask(w);
+        while (released) {
+            uint16_t i = w * 32 + __builtin_ctz(released);
+            released &= released - 1;
 
-                if (!eventQueue.push(event)) {
-                    diagnostics.recordEvent(true);
-                }
+            EventMessage event;
+            event.globalID = NUM_ENCODERS + i;
+            event.value = 0;
+            event.flags = EVENT_FLAG_BUTTON_RELEASED;
+            event.timestamp = micros();
+
+            if (!eventQueue.push(event)) {
+                diagnostics.recordEvent(true);
             }
         }
+    }
+}
+
+// Timer tick (ISR): sample the inputs on the timer edge, unless an
+// overrun transfer is still shifting (the next startDMA() latches then)
+void IRAM_ATTR latchOnTick(void* arg) {
+    ((ShiftRegisterDMA*)arg)->latchIfIdle();
+}
+
+void core0_scanner_task(void* param) {
+#if SCAN_RATE_HZ > 0
+    // Hardware timer pacing: the latch fires from the gptimer ISR at exactly
+    // SCAN_RATE_HZ, then this task clocks the frame in and decodes it
+    scheduler.setTickCallback(latchOnTick, &shiftReg);
+    if (!scheduler.begin(SCAN_RATE_HZ) || !scheduler.start()) {
+        Serial.println("ERROR: Failed to start scan timer!");
+        vTaskDelete(NULL);
+    }
+
+    while (1) {
+        // Block until the next timer tick (no polling)
+        if (scheduler.waitForTick() == 0) {
+            continue;
+        }
+
+        uint32_t cycleStart = micros();
+
+        // Inputs were already latched on the tick
+        if (shiftReg.startDMA(false) && shiftReg.waitForDMA()) {
+            processFrame(shiftReg.getDMABuffer());
+        }
 
         uint32_t cycleTime = micros() - cycleStart;
         diagnostics.recordScanCycle(cycleTime);
+    }
+#else
+    // Ping-pong DMA: the next frame clocks in while this one is decoded, so
+    // the scan rate is set by the SPI transfer time rather than transfer + decode
+    if (!shiftReg.startContinuous()) {
+        Serial.println("ERROR: Failed to start continuous scanning!");
+        vTaskDelete(NULL);
+    }
+
+    while (1) {
+        // Block until the next frame lands (no polling)
+        const uint8_t* data = shiftReg.waitForFrame();
+        if (!data) {
+            continue;
+        }
 
-        // Wait for next scan cycle
-        vTaskDelayUntil(&lastWakeTime, scanInterval);
+        uint32_t cycleStart = micros();
+
+        processFrame(data);
+
+        // Buffer goes back to the DMA queue for the frame after next
+        shiftReg.releaseFrame();
+
+        uint32_t cycleTime = micros() - cycleStart;
+        diagnostics.recordScanCycle(cycleTime);
     }
+#endif
 }
 
 // ============================================================================
@@ -162,7 +232,8 @@ void setup() {
 
     // Initialize decoders
     encoders.begin();
-    buttons.begin(true);  // Active low
+    buttons.begin(true, ButtonHandler::DEBOUNCE_VERTICAL);  // Active low, 32 buttons per word
+    frameDiff.begin();
     Serial.println("Encoders and buttons initialized");
 
     // Initialize I2C slave
@@ -214,6 +285,12 @@ void loop() {
     static uint32_t lastDiagnostics = 0;
     if (millis() - lastDiagnostics > 5000) {
         diagnostics.printDiagnostics();
+#if SCAN_RATE_HZ > 0
+        ScanSchedulerStats stats = scheduler.getStats();
+        Serial.printf("Scan timer: %.1f Hz, interval %u-%u us (avg %u), jitter %u us, wake %u us, overruns %u\n",
+            scheduler.getActualRateHz(), stats.minInterval, stats.maxInterval, stats.avgInterval,
+            stats.maxJitter, stats.maxWakeLatency, stats.overruns);
+#endif
         lastDiagnostics = millis();
     }
 
@@ -13,11 +13,14 @@
 #include <SPI.h>
 #include <Protocol.h>
 #include <ShiftRegisterDMA.h>
+#include <ScanScheduler.h>
+#include <FrameDiff.h>
 #include <EncoderDecoder.h>
 #include <ButtonHandler.h>
 #include <LockFreeQueue.h>
 #include <I2CSlave.h>
 #include <Diagnostics.h>
+#include <SessionManager.h>
 
 // ============================================================================
 // CONFIGURATION
@@ -56,11 +59,14 @@
 
 WebServer webServer(80);
 ShiftRegisterDMA shiftReg(VSPI_HOST, SR_MISO_PIN, SR_SCK_PIN, SR_LATCH_PIN, SR_NUM_CHIPS);
+ScanScheduler scheduler;
+FrameDiff frameDiff(SR_NUM_CHIPS);
 EncoderDecoder encoders(NUM_ENCODERS);
 ButtonHandler buttons(NUM_BUTTONS);
 LockFreeQueue<EventMessage> eventQueue(128);
 I2CSlave i2cSlave(I2C_ADDRESS, Wire, I2C_EVENT_PIN);
 Diagnostics diagnostics;
+SessionManager sessionManager;
 
 bool sdCardPresent = false;
 
@@ -111,7 +117,18 @@ void handleRoot() {
 }
 
 void handleSessions() {
-    webServer.send(200, "text/html", "<h1>Session Management</h1><p>Coming soon...</p>");
+    // Straight from the session index; no session file is opened
+    String html = "<h1>Session Management</h1><p>" + String(sessionManager.getSessionCount()) + " sessions</p><table>";
+    html += "<tr><th>Slot</th><th>Name</th><th>Modified</th><th>Size</th></tr>";
+    for (uint8_t slot = 0; slot < NUM_SESSIONS; slot++) {
+        const SessionIndexEntry* info = sessionManager.getSessionInfo(slot);
+        if (info) {
+            html += "<tr><td>" + String(slot) + "</td><td>" + String(info->name) + "</td><td>"
+                  + String(info->modifiedTime) + "</td><td>" + String(info->fileLength) + "</td></tr>";
+        }
+    }
+    html += "</table>";
+    webServer.send(200, "text/html", html);
 }
 
 void handleControls() {
@@ -124,8 +141,16 @@ void handleDiagnostics() {
     json += "\"eventsDropped\":" + String(diagnostics.getMetrics().eventsDropped) + ",";
     json += "\"scanCycleTime\":" + String(diagnostics.getMetrics().scanCycleTime) + ",";
     json += "\"avgScanCycleTime\":" + String(diagnostics.getMetrics().avgScanCycleTime) + ",";
-    json += "\"maxScanCycleTime\":" + String(diagnostics.getMetrics().maxScanCycleTime);
-    json += "}";
+    json += "\"maxScanCycleTime\":" + String(diagnostics.getMetrics().maxScanCycleTime) + ",";
+    json += "\"sessionLoadTime\":" + String(sessionManager.getLastLoadUs()) + ",";
+    json += "\"sessionSaveTime\":" + String(sessionManager.getLastSaveUs()) + ",";
+    json += "\"sessionOverBudget\":" + String(sessionManager.getOverBudgetCount()) + ",";
+    json += "\"sectionLoadTime\":[";
+    for (uint8_t s = 0; s < SESSION_SECTION_COUNT; s++) {
+        json += String(sessionManager.getSectionStats((SessionSection)s).lastLoadUs);
+        json += (s + 1 < SESSION_SECTION_COUNT) ? "," : "";
+    }
+    json += "]}";
 
     webServer.send(200, "application/json", json);
 }
@@ -138,38 +163,59 @@ void handleNotFound() {
 // CORE 0 - SCANNER TASK
 // ============================================================================
 
+// Not while an overrun transfer is still shifting (startDMA() latches then)
+void IRAM_ATTR latchOnTick(void* arg) {
+    ((ShiftRegisterDMA*)arg)->latchIfIdle();
+}
+
 void core0_scanner_task(void* param) {
-    TickType_t lastWakeTime = xTaskGetTickCount();
-    const TickType_t scanInterval = pdMS_TO_TICKS(1000 / 3000);  // 3kHz
+    // 3kHz from a hardware timer; inputs are latched in the timer ISR
+    scheduler.setTickCallback(latchOnTick, &shiftReg);
+    if (!scheduler.begin(3000) || !scheduler.start()) {
+        Serial.println("ERROR: Failed to start scan timer!");
+        vTaskDelete(NULL);
+    }
 
     while (1) {
+        if (scheduler.waitForTick() == 0) {
+            continue;
+        }
+
         uint32_t cycleStart = micros();
 
-        shiftReg.startDMA();
-        while (!shiftReg.isDMAComplete()) {
-            taskYIELD();
+        if (!shiftReg.startDMA(false) || !shiftReg.waitForDMA()) {
+            continue;
         }
 
         const uint8_t* data = shiftReg.getDMABuffer();
 
-        encoders.update(data);
-        buttons.update(data, NUM_ENCODERS * 2);
+        // Skip decoding when the frame is unchanged and buttons are settled
+        if (!frameDiff.compare(data) && buttons.isSettled()) {
+            diagnostics.recordSkippedScan();
+        } else {
+            encoders.update(data, frameDiff.getDiff());
+            buttons.update(data, NUM_ENCODERS * 2, frameDiff.getDiff());
+        }
 
         // Generate events (same as peripheral node)
-        for (uint16_t i = 0; i < NUM_ENCODERS; i++) {
-            int8_t delta = encoders.getDelta(i);
-            if (delta != 0) {
-                EventMessage event = {i, (uint8_t)abs(delta),
-                    (uint8_t)((delta > 0) ? EVENT_FLAG_ENCODER_CW : EVENT_FLAG_ENCODER_CCW),
-                    micros()};
-                eventQueue.push(event);
+        for (uint8_t w = 0; w < encoders.getNumWords(); w++) {
+            uint32_t pending = encoders.getPendingMask(w);
+            while (pending) {
+                uint16_t i = w * 32 + __builtin_ctz(pending);
+                pending &= pending - 1;
+
+                int8_t delta = encoders.getDelta(i);
+                if (delta != 0) {
+                    EventMessage event = {i, (uint8_t)delta,
+                        (uint8_t)((delta > 0) ? EVENT_FLAG_ENCODER_CW : EVENT_FLAG_ENCODER_CCW),
+                        micros()};
+                    eventQueue.push(event);
+                }
             }
         }
 
         uint32_t cycleTime = micros() - cycleStart;
         diagnostics.recordScanCycle(cycleTime);
-
-        vTaskDelayUntil(&lastWakeTime, scanInterval);
     }
 }
 
@@ -189,6 +235,12 @@ void setup() {
     if (SD.begin(SD_CS_PIN)) {
         sdCardPresent = true;
         Serial.println("SD card initialized");
+
+        // Session switches should stay well under a quarter second
+        sessionManager.setBudgetUs(250000);
+        if (!sessionManager.begin()) {
+            Serial.println("ERROR: Failed to open session directory!");
+        }
     } else {
         Serial.println("WARNING: SD card not found!");
     }
@@ -203,6 +255,7 @@ void setup() {
     // Initialize decoders
     encoders.begin();
     buttons.begin(true);
+    frameDiff.begin();
     Serial.println("Encoders and buttons initialized");
 
     // Initialize I2C slave
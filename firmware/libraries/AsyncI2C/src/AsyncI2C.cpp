@@ -0,0 +1,286 @@
+#include "AsyncI2C.h"
+
+#if defined(__IMXRT1062__) || defined(NATIVE_BUILD)  // Teensy 4.0/4.1 (or host build)
+
+#if defined(__IMXRT1062__)
+// LPI2C master command words (MTDR[10:8])
+static const uint32_t CMD_TRANSMIT = 0x000;
+static const uint32_t CMD_RECEIVE = 0x100;   // Receive (DATA + 1) bytes
+static const uint32_t CMD_STOP = 0x200;
+static const uint32_t CMD_START = 0x400;     // START + address byte in DATA
+
+static const uint32_t MRDR_RXEMPTY = (1 << 14);
+static const uint32_t MSR_CLEAR_FLAGS = 0x7F00;  // EPF..DMF, write 1 to clear
+static const uint8_t TX_FIFO_SIZE = 4;
+
+static const uint32_t ERROR_FLAGS = LPI2C_MSR_NDF | LPI2C_MSR_ALF | LPI2C_MSR_FEF | LPI2C_MSR_PLTF;
+static const uint32_t ERROR_IRQS = LPI2C_MIER_NDIE | LPI2C_MIER_ALIE | LPI2C_MIER_FEIE | LPI2C_MIER_PLTIE;
+
+AsyncI2CBus* AsyncI2CBus::s_instances[NUM_PORTS] = {nullptr, nullptr, nullptr};
+#endif
+
+AsyncI2CBus::AsyncI2CBus(TwoWire& wire, uint8_t port)
+    : m_wire(wire)
+    , m_port(port)
+    , m_timeoutUs(2000)
+    , m_startTime(0)
+    , m_status(ASYNC_I2C_IDLE)
+    , m_txData(nullptr)
+    , m_txLength(0)
+    , m_txIndex(0)
+    , m_rxBuffer(nullptr)
+    , m_rxLength(0)
+    , m_rxCount(0)
+    , m_transferCount(0)
+    , m_errorCount(0)
+#if defined(__IMXRT1062__)
+    , m_lpi2c(nullptr)
+#endif
+{
+}
+
+bool AsyncI2CBus::begin(uint32_t timeoutUs) {
+    if (m_port >= NUM_PORTS) {
+        return false;
+    }
+
+    m_timeoutUs = timeoutUs;
+    m_status = ASYNC_I2C_IDLE;
+
+#if defined(__IMXRT1062__)
+    // Same port mapping as the Teensy 4 Wire library
+    switch (m_port) {
+        case 0:
+            m_lpi2c = &IMXRT_LPI2C1;
+            attachInterruptVector(IRQ_LPI2C1, isrPort0);
+            NVIC_ENABLE_IRQ(IRQ_LPI2C1);
+            break;
+        case 1:
+            m_lpi2c = &IMXRT_LPI2C3;
+            attachInterruptVector(IRQ_LPI2C3, isrPort1);
+            NVIC_ENABLE_IRQ(IRQ_LPI2C3);
+            break;
+        default:
+            m_lpi2c = &IMXRT_LPI2C4;
+            attachInterruptVector(IRQ_LPI2C4, isrPort2);
+            NVIC_ENABLE_IRQ(IRQ_LPI2C4);
+            break;
+    }
+
+    m_lpi2c->MIER = 0;
+    s_instances[m_port] = this;
+#endif
+
+    return true;
+}
+
+bool AsyncI2CBus::startWrite(uint8_t address, const uint8_t* data, uint8_t length) {
+    if (getStatus() == ASYNC_I2C_BUSY || !data || length == 0) {
+        return false;
+    }
+
+#if defined(__IMXRT1062__)
+    if (m_lpi2c->MSR & LPI2C_MSR_MBF) {
+        return false;  // Previous STOP still on the wire
+    }
+#endif
+
+    m_txData = data;
+    m_txLength = length;
+    m_txIndex = 0;
+    m_rxBuffer = nullptr;
+    m_rxLength = 0;
+    m_rxCount = 0;
+    m_transferCount++;
+
+#if defined(__IMXRT1062__)
+    m_lpi2c->MCR |= LPI2C_MCR_RTF | LPI2C_MCR_RRF;  // Flush FIFOs
+    m_lpi2c->MSR = MSR_CLEAR_FLAGS;
+
+    m_startTime = micros();
+    m_status = ASYNC_I2C_BUSY;
+
+    m_lpi2c->MTDR = CMD_START | (address << 1);
+    fillTxFifo();
+
+    // Transmit FIFO interrupt only while data is still waiting to be loaded
+    uint32_t irqs = LPI2C_MIER_SDIE | ERROR_IRQS;
+    if (m_txIndex <= m_txLength) {
+        irqs |= LPI2C_MIER_TDIE;
+    }
+    m_lpi2c->MIER = irqs;
+#else
+    m_startTime = micros();
+    m_wire.beginTransmission(address);
+    m_wire.write(data, length);
+    finish(m_wire.endTransmission() == 0 ? ASYNC_I2C_DONE : ASYNC_I2C_NACK);
+#endif
+
+    return true;
+}
+
+bool AsyncI2CBus::startRead(uint8_t address, uint8_t* buffer, uint8_t length) {
+    if (getStatus() == ASYNC_I2C_BUSY || !buffer || length == 0) {
+        return false;
+    }
+
+#if defined(__IMXRT1062__)
+    if (m_lpi2c->MSR & LPI2C_MSR_MBF) {
+        return false;  // Previous STOP still on the wire
+    }
+#endif
+
+    m_txData = nullptr;
+    m_txLength = 0;
+    m_txIndex = 1;  // START, RECEIVE and STOP all fit in the FIFO at once
+    m_rxBuffer = buffer;
+    m_rxLength = length;
+    m_rxCount = 0;
+    m_transferCount++;
+
+#if defined(__IMXRT1062__)
+    m_lpi2c->MCR |= LPI2C_MCR_RTF | LPI2C_MCR_RRF;
+    m_lpi2c->MSR = MSR_CLEAR_FLAGS;
+
+    m_startTime = micros();
+    m_status = ASYNC_I2C_BUSY;
+
+    m_lpi2c->MTDR = CMD_START | (address << 1) | 1;
+    m_lpi2c->MTDR = CMD_RECEIVE | (length - 1);
+    m_lpi2c->MTDR = CMD_STOP;
+
+    m_lpi2c->MIER = LPI2C_MIER_RDIE | LPI2C_MIER_SDIE | ERROR_IRQS;
+#else
+    m_startTime = micros();
+    uint8_t received = m_wire.requestFrom(address, length);
+    m_rxCount = (uint8_t)m_wire.readBytes(buffer, received);
+    finish(m_rxCount == length ? ASYNC_I2C_DONE : ASYNC_I2C_NACK);
+#endif
+
+    return true;
+}
+
+AsyncI2CStatus AsyncI2CBus::getStatus() {
+    if (m_status == ASYNC_I2C_BUSY && (micros() - m_startTime) > m_timeoutUs) {
+        abort();
+        m_status = ASYNC_I2C_TIMEOUT;
+    }
+    return m_status;
+}
+
+void AsyncI2CBus::abort() {
+#if defined(__IMXRT1062__)
+    // Mask the interrupt first so the ISR cannot finish the transfer under us
+    m_lpi2c->MIER = 0;
+    if (m_status != ASYNC_I2C_BUSY) {
+        return;
+    }
+
+    m_lpi2c->MCR |= LPI2C_MCR_RTF | LPI2C_MCR_RRF;
+    if (m_lpi2c->MSR & LPI2C_MSR_MBF) {
+        m_lpi2c->MTDR = CMD_STOP;
+    }
+    m_lpi2c->MSR = MSR_CLEAR_FLAGS;
+#else
+    if (m_status != ASYNC_I2C_BUSY) {
+        return;
+    }
+#endif
+
+    finish(ASYNC_I2C_ERROR);
+}
+
+void AsyncI2CBus::finish(AsyncI2CStatus status) {
+    if (status != ASYNC_I2C_DONE) {
+        m_errorCount++;
+    }
+    m_status = status;
+}
+
+#if defined(__IMXRT1062__)
+
+void AsyncI2CBus::fillTxFifo() {
+    // m_txIndex == m_txLength means all data is loaded and only STOP is left
+    while (m_txIndex <= m_txLength && (m_lpi2c->MFSR & 0x7) < TX_FIFO_SIZE) {
+        if (m_txIndex < m_txLength) {
+            m_lpi2c->MTDR = CMD_TRANSMIT | m_txData[m_txIndex];
+        } else {
+            m_lpi2c->MTDR = CMD_STOP;
+        }
+        m_txIndex++;
+    }
+
+    if (m_txIndex > m_txLength) {
+        m_lpi2c->MIER &= ~LPI2C_MIER_TDIE;
+    }
+}
+
+void AsyncI2CBus::drainRxFifo() {
+    while (true) {
+        uint32_t data = m_lpi2c->MRDR;
+        if (data & MRDR_RXEMPTY) {
+            break;
+        }
+        if (m_rxCount < m_rxLength) {
+            m_rxBuffer[m_rxCount++] = (uint8_t)data;
+        }
+    }
+}
+
+void AsyncI2CBus::handleInterrupt() {
+    uint32_t status = m_lpi2c->MSR;
+
+    if (status & ERROR_FLAGS) {
+        m_lpi2c->MIER = 0;
+        m_lpi2c->MCR |= LPI2C_MCR_RTF | LPI2C_MCR_RRF;
+
+        // After a NACK we still own the bus and must release it
+        if ((status & LPI2C_MSR_NDF) && (m_lpi2c->MSR & LPI2C_MSR_MBF)) {
+            m_lpi2c->MTDR = CMD_STOP;
+        }
+        m_lpi2c->MSR = status & MSR_CLEAR_FLAGS;
+
+        finish((status & LPI2C_MSR_NDF) ? ASYNC_I2C_NACK : ASYNC_I2C_ERROR);
+        return;
+    }
+
+    if (status & LPI2C_MSR_RDF) {
+        drainRxFifo();
+    }
+
+    if ((status & LPI2C_MSR_TDF) && (m_lpi2c->MIER & LPI2C_MIER_TDIE)) {
+        fillTxFifo();
+    }
+
+    if (status & LPI2C_MSR_SDF) {
+        drainRxFifo();
+        m_lpi2c->MIER = 0;
+        m_lpi2c->MSR = LPI2C_MSR_SDF;
+        finish(m_rxCount == m_rxLength ? ASYNC_I2C_DONE : ASYNC_I2C_ERROR);
+    }
+}
+
+void AsyncI2CBus::isrPort0() {
+    if (s_instances[0]) {
+        s_instances[0]->handleInterrupt();
+    }
+    asm volatile("dsb");  // Make sure flag clears land before returning
+}
+
+void AsyncI2CBus::isrPort1() {
+    if (s_instances[1]) {
+        s_instances[1]->handleInterrupt();
+    }
+    asm volatile("dsb");
+}
+
+void AsyncI2CBus::isrPort2() {
+    if (s_instances[2]) {
+        s_instances[2]->handleInterrupt();
+    }
+    asm volatile("dsb");
+}
+
+#endif // __IMXRT1062__
+
+#endif // Teensy 4.0 || NATIVE_BUILD
@@ -0,0 +1,173 @@
+#ifndef ASYNC_I2C_H
+#define ASYNC_I2C_H
+
+#include <Arduino.h>
+
+#if defined(__IMXRT1062__) || defined(NATIVE_BUILD)  // Teensy 4.0/4.1 (or host build)
+#include <Wire.h>
+
+/**
+ * Transfer status
+ */
+enum AsyncI2CStatus : uint8_t {
+    ASYNC_I2C_IDLE = 0,         // No transfer started yet
+    ASYNC_I2C_BUSY = 1,         // Transfer in flight
+    ASYNC_I2C_DONE = 2,         // Completed (all bytes transferred, STOP sent)
+    ASYNC_I2C_NACK = 3,         // Address or data byte not acknowledged
+    ASYNC_I2C_ERROR = 4,        // Arbitration lost, FIFO error or short read
+    ASYNC_I2C_TIMEOUT = 5       // No STOP within the timeout (transfer aborted)
+};
+
+/**
+ * AsyncI2CBus - Non-Blocking I2C Master Transfers for Teensy 4.0
+ *
+ * Wire's endTransmission()/requestFrom() spin until the STOP, so polling
+ * slaves on Wire, Wire1 and Wire2 one after another leaves two buses idle
+ * at any time. AsyncI2CBus starts a transfer by loading the LPI2C command
+ * FIFO and returns; the LPI2C interrupt feeds the transmit FIFO, drains
+ * the receive FIFO and flags completion on the STOP. With one AsyncI2CBus
+ * per port, all three buses transfer at the same time.
+ *
+ * Features:
+ * - One outstanding transfer per bus (write or read, each ending in STOP)
+ * - LPI2C interrupt driven, no CPU time while bytes are on the wire
+ * - NACK / arbitration / pin-low errors reported per transfer
+ * - Software timeout aborts a transfer stuck on clock stretching
+ *
+ * Typical usage:
+ *   AsyncI2CBus bus(Wire, 0);
+ *   Wire.begin();
+ *   Wire.setClock(1000000);
+ *   bus.begin();
+ *
+ *   bus.startRead(0x08, buffer, 4);
+ *   // ... other work ...
+ *   if (bus.getStatus() == ASYNC_I2C_DONE) { use(buffer); }
+ *
+ * Wire still does pin muxing and clock setup; AsyncI2CBus only takes over
+ * transfers. Blocking Wire calls on the same port are fine while the bus
+ * is not busy.
+ *
+ * Host builds run each transfer through the Wire shim synchronously, so
+ * the status is final as soon as start*() returns.
+ */
+class AsyncI2CBus {
+public:
+    static const uint8_t NUM_PORTS = 3;
+
+    /**
+     * Constructor
+     * @param wire - Wire instance that owns the port (pins and clock)
+     * @param port - 0 = Wire (LPI2C1), 1 = Wire1 (LPI2C3), 2 = Wire2 (LPI2C4)
+     */
+    AsyncI2CBus(TwoWire& wire, uint8_t port);
+
+    /**
+     * Attach the LPI2C interrupt. Call after wire.begin()/setClock().
+     * @param timeoutUs - Abort a transfer that has not finished after this long
+     * @return true if successful
+     */
+    bool begin(uint32_t timeoutUs = 2000);
+
+    /**
+     * Start a write (START, address+W, data, STOP)
+     * @param address - 7-bit slave address
+     * @param data - Bytes to send (must stay valid until the transfer ends)
+     * @param length - Number of bytes (1-255)
+     * @return true if started, false if the bus is busy
+     */
+    bool startWrite(uint8_t address, const uint8_t* data, uint8_t length);
+
+    /**
+     * Start a read (START, address+R, length bytes, STOP)
+     * @param address - 7-bit slave address
+     * @param buffer - Destination (must stay valid until the transfer ends)
+     * @param length - Number of bytes (1-255)
+     * @return true if started, false if the bus is busy
+     */
+    bool startRead(uint8_t address, uint8_t* buffer, uint8_t length);
+
+    /**
+     * Get status of the current/last transfer (aborts it on timeout)
+     */
+    AsyncI2CStatus getStatus();
+
+    /**
+     * Check if a transfer is in flight
+     */
+    bool isBusy() { return getStatus() == ASYNC_I2C_BUSY; }
+
+    /**
+     * Abort the transfer in flight (sends STOP)
+     */
+    void abort();
+
+    /**
+     * Get number of bytes received by the last read
+     */
+    uint8_t getBytesReceived() const { return m_rxCount; }
+
+    /**
+     * Get the Wire instance for this port
+     */
+    TwoWire& getWire() { return m_wire; }
+
+    /**
+     * Get transfer counters
+     */
+    uint32_t getTransferCount() const { return m_transferCount; }
+    uint32_t getErrorCount() const { return m_errorCount; }
+
+private:
+    TwoWire& m_wire;
+    uint8_t m_port;
+    uint32_t m_timeoutUs;
+    uint32_t m_startTime;
+
+    volatile AsyncI2CStatus m_status;
+
+    const uint8_t* m_txData;
+    uint8_t m_txLength;
+    volatile uint8_t m_txIndex;     // Data bytes loaded into the FIFO (+1 once STOP is queued)
+
+    uint8_t* m_rxBuffer;
+    uint8_t m_rxLength;
+    volatile uint8_t m_rxCount;
+
+    uint32_t m_transferCount;
+    uint32_t m_errorCount;
+
+    /**
+     * Record the end of a transfer
+     */
+    void finish(AsyncI2CStatus status);
+
+#if defined(__IMXRT1062__)
+    IMXRT_LPI2C_t* m_lpi2c;
+
+    static AsyncI2CBus* s_instances[NUM_PORTS];
+
+    /**
+     * Load commands into the transmit FIFO while it has room
+     */
+    void fillTxFifo();
+
+    /**
+     * Move received bytes out of the receive FIFO
+     */
+    void drainRxFifo();
+
+    /**
+     * LPI2C interrupt handler
+     */
+    void handleInterrupt();
+
+    // Interrupt vectors (static for ISR compatibility)
+    static void isrPort0();
+    static void isrPort1();
+    static void isrPort2();
+#endif
+};
+
+#endif // Teensy 4.0 || NATIVE_BUILD
+#endif // ASYNC_I2C_H
@@ -4,28 +4,56 @@ ButtonHandler::ButtonHandler(uint16_t numButtons)
     : m_numButtons(numButtons)
     , m_buttons(nullptr)
     , m_activeLow(true)
+    , m_mode(DEBOUNCE_HISTORY)
+    , m_numWords((numButtons + 31) / 32)
 {
     m_buttons = new ButtonState[m_numButtons];
+    m_state = new uint32_t[m_numWords];
+    m_pressed = new uint32_t[m_numWords];
+    m_released = new uint32_t[m_numWords];
+    m_count0 = new uint32_t[m_numWords];
+    m_count1 = new uint32_t[m_numWords];
+    m_count2 = new uint32_t[m_numWords];
 }
 
 ButtonHandler::~ButtonHandler() {
     delete[] m_buttons;
+    delete[] m_state;
+    delete[] m_pressed;
+    delete[] m_released;
+    delete[] m_count0;
+    delete[] m_count1;
+    delete[] m_count2;
 }
 
-void ButtonHandler::begin(bool activeLow) {
+void ButtonHandler::begin(bool activeLow, DebounceMode mode) {
     m_activeLow = activeLow;
+    m_mode = mode;
 
     for (uint16_t i = 0; i < m_numButtons; i++) {
         m_buttons[i].history = activeLow ? 0xFF : 0x00;
-        m_buttons[i].currentState = false;
-        m_buttons[i].lastState = false;
-        m_buttons[i].pressedFlag = false;
-        m_buttons[i].releasedFlag = false;
         m_buttons[i].pressTime = 0;
     }
+
+    for (uint8_t w = 0; w < m_numWords; w++) {
+        m_state[w] = 0;
+        m_pressed[w] = 0;
+        m_released[w] = 0;
+        m_count0[w] = 0;
+        m_count1[w] = 0;
+        m_count2[w] = 0;
+    }
 }
 
-void ButtonHandler::update(const uint8_t* data, uint16_t offset) {
+void ButtonHandler::update(const uint8_t* data, uint16_t offset, const uint8_t* diff) {
+    if (m_mode == DEBOUNCE_VERTICAL) {
+        updateVertical(data, offset, diff);
+    } else {
+        updateHistory(data, offset);
+    }
+}
+
+void ButtonHandler::updateHistory(const uint8_t* data, uint16_t offset) {
     uint32_t currentTime = millis();
 
     for (uint16_t i = 0; i < m_numButtons; i++) {
@@ -36,23 +64,109 @@ void ButtonHandler::update(const uint8_t* data, uint16_t offset) {
         // Extract bit for this button
         bool rawState = (data[byteIndex] & (1 << bitOffset)) != 0;
 
-        updateButton(&m_buttons[i], rawState);
+        bool currentState = updateButton(&m_buttons[i], rawState);
 
         // Detect edges
-        bool pressed = m_buttons[i].currentState && !m_buttons[i].lastState;
-        bool released = !m_buttons[i].currentState && m_buttons[i].lastState;
+        uint8_t word = i / 32;
+        uint32_t bit = 1UL << (i % 32);
+        bool lastState = (m_state[word] & bit) != 0;
 
-        if (pressed) {
-            m_buttons[i].pressedFlag = true;
+        if (currentState && !lastState) {
+            m_pressed[word] |= bit;
+            m_state[word] |= bit;
             m_buttons[i].pressTime = currentTime;
         }
 
-        if (released) {
-            m_buttons[i].releasedFlag = true;
+        if (!currentState && lastState) {
+            m_released[word] |= bit;
+            m_state[word] &= ~bit;
         }
+    }
+}
+
+bool ButtonHandler::isSettled() const {
+    if (m_mode == DEBOUNCE_VERTICAL) {
+        // Counters are zero exactly when the last sample matched the state
+        for (uint8_t w = 0; w < m_numWords; w++) {
+            if (m_count0[w] | m_count1[w] | m_count2[w]) {
+                return false;
+            }
+        }
+        return true;
+    }
 
-        m_buttons[i].lastState = m_buttons[i].currentState;
+    // History mode: settled once every history is all-0 or all-1
+    for (uint16_t i = 0; i < m_numButtons; i++) {
+        uint8_t history = m_buttons[i].history;
+        if (history != 0x00 && history != 0xFF) {
+            return false;
+        }
     }
+    return true;
+}
+
+void ButtonHandler::updateVertical(const uint8_t* data, uint16_t offset, const uint8_t* diff) {
+    for (uint8_t w = 0; w < m_numWords; w++) {
+        uint16_t first = w * 32;
+        uint8_t numBits = (m_numButtons - first) >= 32 ? 32 : (uint8_t)(m_numButtons - first);
+        uint32_t valid = numBits == 32 ? 0xFFFFFFFF : ((1UL << numBits) - 1);
+
+        // Same input as last sample and no counters running: nothing to do
+        if (diff && (m_count0[w] | m_count1[w] | m_count2[w]) == 0 &&
+            (loadBits(diff, offset + first, numBits) & valid) == 0) {
+            continue;
+        }
+
+        uint32_t raw = loadBits(data, offset + first, numBits);
+        uint32_t sample = (m_activeLow ? ~raw : raw) & valid;  // 1 = pressed
+
+        // Count consecutive samples that disagree with the debounced state;
+        // any agreeing sample resets that button's counter to zero
+        uint32_t delta = sample ^ m_state[w];
+        uint32_t c0 = m_count0[w];
+        uint32_t c1 = m_count1[w];
+        uint32_t c2 = m_count2[w];
+
+        // 8th disagreeing sample (counter already at 7) flips the state
+        uint32_t toggle = delta & c0 & c1 & c2;
+
+        m_count2[w] = (c2 ^ (c1 & c0)) & delta;
+        m_count1[w] = (c1 ^ c0) & delta;
+        m_count0[w] = ~c0 & delta;
+
+        if (toggle == 0) {
+            continue;
+        }
+
+        uint32_t state = m_state[w] ^ toggle;
+        m_state[w] = state;
+
+        uint32_t pressed = toggle & state;
+        m_pressed[w] |= pressed;
+        m_released[w] |= toggle & ~state;
+
+        if (pressed) {
+            uint32_t currentTime = millis();
+            while (pressed) {
+                uint8_t bit = __builtin_ctz(pressed);
+                pressed &= pressed - 1;
+                m_buttons[first + bit].pressTime = currentTime;
+            }
+        }
+    }
+}
+
+uint32_t ButtonHandler::loadBits(const uint8_t* data, uint16_t startBit, uint8_t numBits) {
+    uint16_t byteIndex = startBit / 8;
+    uint8_t shift = startBit % 8;
+    uint8_t numBytes = (shift + numBits + 7) / 8;
+
+    uint64_t bits = 0;
+    for (uint8_t i = 0; i < numBytes; i++) {
+        bits |= (uint64_t)data[byteIndex + i] << (i * 8);
+    }
+
+    return (uint32_t)(bits >> shift);
 }
 
 bool ButtonHandler::isPressed(uint16_t index) {
@@ -60,8 +174,9 @@ bool ButtonHandler::isPressed(uint16_t index) {
         return false;
     }
 
-    bool pressed = m_buttons[index].pressedFlag;
-    m_buttons[index].pressedFlag = false;  // Clear flag after reading
+    uint32_t bit = 1UL << (index % 32);
+    bool pressed = (m_pressed[index / 32] & bit) != 0;
+    m_pressed[index / 32] &= ~bit;  // Clear flag after reading
     return pressed;
 }
 
@@ -70,8 +185,9 @@ bool ButtonHandler::isReleased(uint16_t index) {
         return false;
     }
 
-    bool released = m_buttons[index].releasedFlag;
-    m_buttons[index].releasedFlag = false;  // Clear flag after reading
+    uint32_t bit = 1UL << (index % 32);
+    bool released = (m_released[index / 32] & bit) != 0;
+    m_released[index / 32] &= ~bit;  // Clear flag after reading
     return released;
 }
 
@@ -80,11 +196,11 @@ bool ButtonHandler::isHeld(uint16_t index) {
         return false;
     }
 
-    return m_buttons[index].currentState;
+    return (m_state[index / 32] & (1UL << (index % 32))) != 0;
 }
 
 bool ButtonHandler::isHeldFor(uint16_t index, uint32_t durationMs) {
-    if (index >= m_numButtons || !m_buttons[index].currentState) {
+    if (!isHeld(index)) {
         return false;
     }
 
@@ -93,7 +209,7 @@ bool ButtonHandler::isHeldFor(uint16_t index, uint32_t durationMs) {
 }
 
 uint32_t ButtonHandler::getHoldTime(uint16_t index) {
-    if (index >= m_numButtons || !m_buttons[index].currentState) {
+    if (!isHeld(index)) {
         return 0;
     }
 
@@ -102,17 +218,45 @@ uint32_t ButtonHandler::getHoldTime(uint16_t index) {
 
 void ButtonHandler::clearEvents(uint16_t index) {
     if (index < m_numButtons) {
-        m_buttons[index].pressedFlag = false;
-        m_buttons[index].releasedFlag = false;
+        uint32_t bit = 1UL << (index % 32);
+        m_pressed[index / 32] &= ~bit;
+        m_released[index / 32] &= ~bit;
+    }
+}
+
+uint32_t ButtonHandler::takePressedMask(uint8_t word) {
+    if (word >= m_numWords) {
+        return 0;
+    }
+
+    uint32_t pressed = m_pressed[word];
+    m_pressed[word] = 0;
+    return pressed;
+}
+
+uint32_t ButtonHandler::takeReleasedMask(uint8_t word) {
+    if (word >= m_numWords) {
+        return 0;
+    }
+
+    uint32_t released = m_released[word];
+    m_released[word] = 0;
+    return released;
+}
+
+uint32_t ButtonHandler::getStateMask(uint8_t word) const {
+    if (word >= m_numWords) {
+        return 0;
     }
+    return m_state[word];
 }
 
-void ButtonHandler::updateButton(ButtonState* button, bool rawState) {
+bool ButtonHandler::updateButton(ButtonState* button, bool rawState) {
     // Shift history and add new sample
     button->history = (button->history << 1) | (rawState ? 1 : 0);
 
     // Update debounced state
-    button->currentState = isDebounced(button->history, m_activeLow);
+    return isDebounced(button->history, m_activeLow);
 }
 
 bool ButtonHandler::isDebounced(uint8_t history, bool activeLow) {
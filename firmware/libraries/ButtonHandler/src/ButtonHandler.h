@@ -11,7 +11,8 @@
  *
  * Features:
  * - 8-sample debouncing (stable for 8 consecutive reads)
- * - Press and release detection
+ * - Optional vertical-counter debouncing (32 buttons per machine word)
+ * - Press and release detection (per button or as edge bitmasks)
  * - Hold detection with configurable duration
  * - Active-low or active-high configuration
  *
@@ -21,9 +22,29 @@
  *   buttons.update(shiftRegisterData);
  *   if (buttons.isPressed(buttonIndex)) { ... }
  *   if (buttons.isReleased(buttonIndex)) { ... }
+ *
+ * Debounce modes:
+ * - DEBOUNCE_HISTORY (default): 8-bit shift history per button. A press
+ *   needs 8 identical samples; any single differing sample releases.
+ * - DEBOUNCE_VERTICAL: 3-bit vertical counter held as three bit-planes, so
+ *   32 buttons are debounced with a handful of bitwise ops per word. A
+ *   button changes state after 8 consecutive samples that disagree with its
+ *   debounced state (symmetric for press and release). Edges come out as
+ *   press/release bitmasks; iterate them instead of polling every button:
+ *
+ *   buttons.begin(true, ButtonHandler::DEBOUNCE_VERTICAL);
+ *   for (uint8_t w = 0; w < buttons.getNumWords(); w++) {
+ *       uint32_t pressed = buttons.takePressedMask(w);
+ *       while (pressed) { uint16_t i = w * 32 + __builtin_ctz(pressed); pressed &= pressed - 1; ... }
+ *   }
  */
 class ButtonHandler {
 public:
+    enum DebounceMode : uint8_t {
+        DEBOUNCE_HISTORY = 0,   // 8-sample shift history per button
+        DEBOUNCE_VERTICAL = 1   // Vertical counter, 32 buttons per word
+    };
+
     /**
      * Constructor
      * @param numButtons - Number of buttons to track
@@ -34,15 +55,28 @@ public:
     /**
      * Initialize button handler
      * @param activeLow - true if buttons are active-low (default for most switches)
+     * @param mode - Debounce engine (default 8-sample history)
      */
-    void begin(bool activeLow = true);
+    void begin(bool activeLow = true, DebounceMode mode = DEBOUNCE_HISTORY);
 
     /**
      * Update button states from shift register data
      * @param data - Pointer to shift register buffer
      * @param offset - Bit offset to start reading buttons from
+     * @param diff - Optional XOR of this frame with the previous one (same
+     *               layout as data, see FrameDiff). In DEBOUNCE_VERTICAL
+     *               mode, words with no changed bits and no counters running
+     *               are skipped.
      */
-    void update(const uint8_t* data, uint16_t offset = 0);
+    void update(const uint8_t* data, uint16_t offset = 0, const uint8_t* diff = nullptr);
+
+    /**
+     * Check if every button is debounced and stable
+     * When true and the input frame is unchanged, update() would not change
+     * anything, so the call can be skipped.
+     * @return true if no button is part-way through debouncing
+     */
+    bool isSettled() const;
 
     /**
      * Check if button was just pressed (transition from released to pressed)
@@ -86,26 +120,84 @@ public:
      */
     void clearEvents(uint16_t index);
 
+    /**
+     * Get and clear press edges for 32 buttons
+     * Bit n = button (word * 32 + n)
+     * @param word - Word index (0 to getNumWords()-1)
+     * @return Bitmask of buttons pressed since last read
+     */
+    uint32_t takePressedMask(uint8_t word);
+
+    /**
+     * Get and clear release edges for 32 buttons
+     * @param word - Word index
+     * @return Bitmask of buttons released since last read
+     */
+    uint32_t takeReleasedMask(uint8_t word);
+
+    /**
+     * Get debounced state for 32 buttons (bit set = held)
+     * @param word - Word index
+     */
+    uint32_t getStateMask(uint8_t word) const;
+
+    /**
+     * Get number of 32-button words
+     */
+    uint8_t getNumWords() const { return m_numWords; }
+
+    /**
+     * Get active debounce engine
+     */
+    DebounceMode getDebounceMode() const { return m_mode; }
+
 private:
     struct ButtonState {
-        uint8_t history;        // 8-bit debounce history
-        bool currentState;      // Current debounced state (true = pressed)
-        bool lastState;         // Previous state (for edge detection)
-        bool pressedFlag;       // Set on press, cleared after read
-        bool releasedFlag;      // Set on release, cleared after read
+        uint8_t history;        // 8-bit debounce history (DEBOUNCE_HISTORY)
         uint32_t pressTime;     // Time of last press (ms)
     };
 
     uint16_t m_numButtons;
     ButtonState* m_buttons;
     bool m_activeLow;
+    DebounceMode m_mode;
+    uint8_t m_numWords;
+
+    // Per-word bit state (bit n = button word * 32 + n)
+    uint32_t* m_state;          // Debounced state (1 = pressed)
+    uint32_t* m_pressed;        // Press edges, cleared after read
+    uint32_t* m_released;       // Release edges, cleared after read
+
+    // Vertical counter bit-planes (DEBOUNCE_VERTICAL)
+    uint32_t* m_count0;
+    uint32_t* m_count1;
+    uint32_t* m_count2;
+
+    /**
+     * History debounce for all buttons (one at a time)
+     */
+    void updateHistory(const uint8_t* data, uint16_t offset);
+
+    /**
+     * Vertical-counter debounce for all buttons (32 per word)
+     */
+    void updateVertical(const uint8_t* data, uint16_t offset, const uint8_t* diff);
+
+    /**
+     * Load 32 raw button bits starting at a bit offset
+     * @param data - Shift register buffer
+     * @param startBit - Bit index of first button in word
+     * @param numBits - Buttons in this word (1-32)
+     */
+    static uint32_t loadBits(const uint8_t* data, uint16_t startBit, uint8_t numBits);
 
     /**
      * Update debounce history for one button
      * @param button - Pointer to button state
      * @param rawState - Raw button state from shift register
+     * @return Debounced state (true = pressed)
      */
-    void updateButton(ButtonState* button, bool rawState);
+    bool updateButton(ButtonState* button, bool rawState);
 
     /**
      * Check if button is debounced stable
@@ -0,0 +1,46 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <Arduino.h>
+
+/**
+ * CRC32 - Table-Driven CRC-32 Checksum
+ *
+ * Standard reflected CRC-32 (polynomial 0xEDB88320, as zlib/PNG/Ethernet).
+ * Buffers of 16 bytes or more use slice-by-8 (eight 256-entry tables,
+ * 8 KB in flash): 8 independent lookups per 8 bytes. Shorter buffers use
+ * one table lookup per byte.
+ *
+ * Features:
+ * - Matches zlib crc32() output
+ * - Incremental: checksum data in pieces by passing the previous result
+ *   (session files are checksummed chunk by chunk while streaming)
+ *
+ * Typical usage:
+ *   uint32_t crc = CRC32::calculate(&batch, length);
+ *
+ *   // Incremental (same result as one call over all the data):
+ *   uint32_t crc = CRC32::update(0, header, headerLen);
+ *   crc = CRC32::update(crc, payload, payloadLen);
+ */
+class CRC32 {
+public:
+    /**
+     * Calculate CRC-32 of a buffer
+     * @param data - Data to checksum
+     * @param length - Length in bytes
+     * @return CRC-32 value
+     */
+    static uint32_t calculate(const void* data, size_t length);
+
+    /**
+     * Continue a CRC-32 over more data
+     * @param crc - Result of previous calculate()/update() (0 to start)
+     * @param data - Next data
+     * @param length - Length in bytes
+     * @return CRC-32 of all data so far
+     */
+    static uint32_t update(uint32_t crc, const void* data, size_t length);
+};
+
+#endif // CRC32_H
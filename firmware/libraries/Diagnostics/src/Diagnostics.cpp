@@ -19,6 +19,7 @@ void Diagnostics::update() {
 
 void Diagnostics::recordScanCycle(uint32_t cycleTimeUs) {
     m_metrics.scanCycleTime = cycleTimeUs;
+    m_metrics.scanCycles++;
 
     // Update average (simple moving average)
     if (m_metrics.avgScanCycleTime == 0) {
@@ -33,7 +34,11 @@ void Diagnostics::recordScanCycle(uint32_t cycleTimeUs) {
     }
 }
 
-void Diagnostics::recordI2CTransaction(uint32_t latencyUs, bool success) {
+void Diagnostics::recordSkippedScan() {
+    m_metrics.scansSkipped++;
+}
+
+void Diagnostics::recordI2CTransaction(uint32_t latencyUs, bool /*success*/) {
     m_metrics.i2cLatency = latencyUs;
 }
 
@@ -59,6 +64,16 @@ void Diagnostics::printDiagnostics() {
     Serial.print(m_metrics.maxScanCycleTime);
     Serial.println(" us)");
 
+    if (m_metrics.scanCycles > 0) {
+        Serial.print("Scans skipped: ");
+        Serial.print(m_metrics.scansSkipped);
+        Serial.print(" of ");
+        Serial.print(m_metrics.scanCycles);
+        Serial.print(" (");
+        Serial.print(m_metrics.scansSkipped * 100.0f / m_metrics.scanCycles, 1);
+        Serial.println("% unchanged)");
+    }
+
     Serial.print("I2C latency: ");
     Serial.print(m_metrics.i2cLatency);
     Serial.println(" us");
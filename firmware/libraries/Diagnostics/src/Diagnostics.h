@@ -19,6 +19,9 @@ public:
     // Record scan cycle time
     void recordScanCycle(uint32_t cycleTimeUs);
 
+    // Record scan cycle whose decode was skipped (frame unchanged)
+    void recordSkippedScan();
+
     // Record I2C transaction
     void recordI2CTransaction(uint32_t latencyUs, bool success);
 
@@ -14,15 +14,38 @@ const int8_t EncoderDecoder::STATE_TABLE[4][4] = {
     {  0, -1,  1,  0 }   // To: 00(invalid), 01(CCW), 10(CW), 11(no change)
 };
 
+// Unshuffle 32 interleaved bits: even bits -> low half, odd bits -> high half
+// (Hacker's Delight 7-2, four delta swaps)
+static inline uint32_t unshuffle32(uint32_t x) {
+    uint32_t t;
+    t = (x ^ (x >> 1)) & 0x22222222; x = x ^ t ^ (t << 1);
+    t = (x ^ (x >> 2)) & 0x0C0C0C0C; x = x ^ t ^ (t << 2);
+    t = (x ^ (x >> 4)) & 0x00F000F0; x = x ^ t ^ (t << 4);
+    t = (x ^ (x >> 8)) & 0x0000FF00; x = x ^ t ^ (t << 8);
+    return x;
+}
+
 EncoderDecoder::EncoderDecoder(uint16_t numEncoders)
     : m_numEncoders(numEncoders)
     , m_encoders(nullptr)
+    , m_decodeMode(DECODE_PARALLEL)
+    , m_numWords((numEncoders + 31) / 32)
+    , m_numBytes((numEncoders * 2 + 7) / 8)
+    , m_lastClk(nullptr)
+    , m_lastDt(nullptr)
+    , m_pendingMask(nullptr)
 {
     m_encoders = new EncoderState[m_numEncoders];
+    m_lastClk = new uint32_t[m_numWords];
+    m_lastDt = new uint32_t[m_numWords];
+    m_pendingMask = new uint32_t[m_numWords];
 }
 
 EncoderDecoder::~EncoderDecoder() {
     delete[] m_encoders;
+    delete[] m_lastClk;
+    delete[] m_lastDt;
+    delete[] m_pendingMask;
 }
 
 void EncoderDecoder::begin() {
@@ -33,9 +56,56 @@ void EncoderDecoder::begin() {
         m_encoders[i].lastChangeTime = 0;
         m_encoders[i].deltaTime = 0;
     }
+
+    for (uint8_t w = 0; w < m_numWords; w++) {
+        m_lastClk[w] = 0;
+        m_lastDt[w] = 0;
+        m_pendingMask[w] = 0;
+    }
+}
+
+void EncoderDecoder::update(const uint8_t* data, const uint8_t* diff) {
+    if (m_decodeMode == DECODE_PARALLEL) {
+        updateParallel(data, diff);
+    } else {
+        updateTable(data);
+    }
+}
+
+void EncoderDecoder::setDecodeMode(DecodeMode mode) {
+    if (mode == m_decodeMode) {
+        return;
+    }
+
+    // Carry last Gray state across so switching never produces a false step
+    for (uint16_t i = 0; i < m_numEncoders; i++) {
+        uint8_t word = i / 32;
+        uint32_t bit = 1UL << (i % 32);
+
+        if (mode == DECODE_PARALLEL) {
+            uint8_t state = m_encoders[i].lastState;
+            m_lastClk[word] = (state & 0x01) ? (m_lastClk[word] | bit) : (m_lastClk[word] & ~bit);
+            m_lastDt[word] = (state & 0x02) ? (m_lastDt[word] | bit) : (m_lastDt[word] & ~bit);
+            if (m_encoders[i].delta != 0) {
+                m_pendingMask[word] |= bit;
+            }
+        } else {
+            m_encoders[i].lastState = ((m_lastClk[word] & bit) ? 0x01 : 0) |
+                                      ((m_lastDt[word] & bit) ? 0x02 : 0);
+        }
+    }
+
+    m_decodeMode = mode;
 }
 
-void EncoderDecoder::update(const uint8_t* data) {
+uint32_t EncoderDecoder::getPendingMask(uint8_t word) const {
+    if (word >= m_numWords) {
+        return 0;
+    }
+    return m_pendingMask[word];
+}
+
+void EncoderDecoder::updateTable(const uint8_t* data) {
     uint32_t currentTime = micros();
 
     for (uint16_t i = 0; i < m_numEncoders; i++) {
@@ -62,10 +132,85 @@ void EncoderDecoder::update(const uint8_t* data) {
         if (m_encoders[i].delta != 0) {
             m_encoders[i].deltaTime = currentTime - m_encoders[i].lastChangeTime;
             m_encoders[i].lastChangeTime = currentTime;
+            m_pendingMask[i / 32] |= 1UL << (i % 32);
+        }
+    }
+}
+
+void EncoderDecoder::updateParallel(const uint8_t* data, const uint8_t* diff) {
+    uint32_t currentTime = 0;
+    bool haveTime = false;
+
+    for (uint8_t w = 0; w < m_numWords; w++) {
+        // Unchanged input bits: planes already match, nothing can move
+        if (diff && loadWordBits(diff, w) == 0) {
+            continue;
+        }
+
+        // Split 64 interleaved bits (CLK at even, DT at odd) into two planes
+        uint64_t bits = loadWordBits(data, w);
+        uint32_t lo = unshuffle32((uint32_t)bits);          // Encoders 0-15 of word
+        uint32_t hi = unshuffle32((uint32_t)(bits >> 32));  // Encoders 16-31 of word
+        uint32_t clk = (lo & 0x0000FFFF) | (hi << 16);
+        uint32_t dt = (lo >> 16) | (hi & 0xFFFF0000);
+
+        uint32_t lastClk = m_lastClk[w];
+        uint32_t lastDt = m_lastDt[w];
+        m_lastClk[w] = clk;
+        m_lastDt[w] = dt;
+
+        // Valid Gray step = exactly one of CLK/DT changed (same as STATE_TABLE:
+        // no change and double change both decode to 0).
+        // Direction: CW when new CLK differs from old DT.
+        uint32_t moved = ((clk ^ lastClk) ^ (dt ^ lastDt)) & validMask(w);
+        if (moved == 0) {
+            continue;
+        }
+
+        uint32_t cw = clk ^ lastDt;
+
+        if (!haveTime) {
+            currentTime = micros();
+            haveTime = true;
+        }
+
+        m_pendingMask[w] |= moved;
+
+        while (moved) {
+            uint8_t bit = __builtin_ctz(moved);
+            moved &= moved - 1;
+
+            EncoderState& encoder = m_encoders[w * 32 + bit];
+            int8_t delta = ((cw >> bit) & 1) ? 1 : -1;
+            encoder.delta += delta;
+            encoder.position += delta;
+            encoder.deltaTime = currentTime - encoder.lastChangeTime;
+            encoder.lastChangeTime = currentTime;
         }
     }
 }
 
+uint64_t EncoderDecoder::loadWordBits(const uint8_t* data, uint8_t word) const {
+    uint16_t firstByte = word * 8;
+    uint16_t numBytes = m_numBytes - firstByte;
+    if (numBytes >= 8) {
+        uint64_t bits;
+        memcpy(&bits, data + firstByte, sizeof(bits));  // Little-endian (ESP32, Teensy)
+        return bits;
+    }
+
+    uint64_t bits = 0;
+    for (uint16_t i = 0; i < numBytes; i++) {
+        bits |= (uint64_t)data[firstByte + i] << (i * 8);
+    }
+    return bits;
+}
+
+uint32_t EncoderDecoder::validMask(uint8_t word) const {
+    uint16_t remaining = m_numEncoders - word * 32;
+    return remaining >= 32 ? 0xFFFFFFFF : ((1UL << remaining) - 1);
+}
+
 int8_t EncoderDecoder::getDelta(uint16_t index) {
     if (index >= m_numEncoders) {
         return 0;
@@ -73,6 +218,7 @@ int8_t EncoderDecoder::getDelta(uint16_t index) {
 
     int8_t delta = m_encoders[index].delta;
     m_encoders[index].delta = 0;  // Clear delta after reading
+    m_pendingMask[index / 32] &= ~(1UL << (index % 32));
     return delta;
 }
 
@@ -82,6 +228,7 @@ int8_t EncoderDecoder::getAcceleratedDelta(uint16_t index, uint8_t accelCurve) {
     }
 
     int8_t delta = m_encoders[index].delta;
+    m_pendingMask[index / 32] &= ~(1UL << (index % 32));
     if (delta == 0) {
         return 0;
     }
@@ -90,13 +237,13 @@ int8_t EncoderDecoder::getAcceleratedDelta(uint16_t index, uint8_t accelCurve) {
 
     // Apply acceleration based on rotation speed
     float accel = calculateAcceleration(m_encoders[index].deltaTime, accelCurve);
-    int8_t acceleratedDelta = (int8_t)(delta * accel);
+    int16_t acceleratedDelta = (int16_t)(delta * accel);
 
-    // Clamp to reasonable range
+    // Clamp to reasonable range (before narrowing, or it wraps)
     if (acceleratedDelta > 127) acceleratedDelta = 127;
     if (acceleratedDelta < -127) acceleratedDelta = -127;
 
-    return acceleratedDelta;
+    return (int8_t)acceleratedDelta;
 }
 
 int32_t EncoderDecoder::getPosition(uint16_t index) {
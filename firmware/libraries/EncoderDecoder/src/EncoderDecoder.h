@@ -11,6 +11,7 @@
  *
  * Features:
  * - Gray code state machine (4 valid states)
+ * - Bit-parallel (SWAR) decode of 32 encoders per machine word
  * - Acceleration detection based on timing
  * - Debouncing through state validation
  * - Configurable acceleration curves
@@ -21,9 +22,24 @@
  *   dec.update(shiftRegisterData);
  *   int8_t delta = dec.getDelta(encoderIndex);
  *   int8_t accelDelta = dec.getAcceleratedDelta(encoderIndex, accelCurve);
+ *
+ * Decode modes:
+ * - DECODE_PARALLEL (default): splits each 64-bit group of interleaved
+ *   CLK/DT bits into a CLK plane and a DT plane (32 encoders per word) and
+ *   computes the movement and direction masks for all 32 in a few bitwise
+ *   ops. Only encoders whose movement bit is set are touched, found with
+ *   count-trailing-zeros; micros() is read only when something moved.
+ * - DECODE_TABLE: original per-encoder STATE_TABLE walk (kept as reference
+ *   and for benchmarking). Both modes produce identical deltas.
  */
 class EncoderDecoder {
 public:
+    enum DecodeMode : uint8_t {
+        DECODE_TABLE = 0,     // Per-encoder STATE_TABLE lookup
+        DECODE_PARALLEL = 1   // Bit-sliced, 32 encoders per word
+    };
+
+
     /**
      * Constructor
      * @param numEncoders - Number of encoders to track
@@ -40,8 +56,36 @@ public:
      * Update encoder states from shift register data
      * @param data - Pointer to shift register buffer
      *               Data format: 2 bits per encoder (CLK, DT)
+     * @param diff - Optional XOR of this frame with the previous one (same
+     *               layout, see FrameDiff). The parallel decoder skips any
+     *               32-encoder word whose diff bits are all zero.
      */
-    void update(const uint8_t* data);
+    void update(const uint8_t* data, const uint8_t* diff = nullptr);
+
+    /**
+     * Select decode path (state carries over between modes)
+     * @param mode - DECODE_PARALLEL or DECODE_TABLE
+     */
+    void setDecodeMode(DecodeMode mode);
+
+    /**
+     * Get active decode path
+     */
+    DecodeMode getDecodeMode() const { return m_decodeMode; }
+
+    /**
+     * Get encoders that moved since their delta was last read
+     * Bit n = encoder (word * 32 + n). Iterate with count-trailing-zeros
+     * instead of calling getDelta() for every encoder.
+     * @param word - Word index (0 to getNumWords()-1)
+     * @return Bitmask of encoders with a pending delta
+     */
+    uint32_t getPendingMask(uint8_t word) const;
+
+    /**
+     * Get number of 32-encoder words
+     */
+    uint8_t getNumWords() const { return m_numWords; }
 
     /**
      * Get raw delta for an encoder since last update
@@ -91,6 +135,14 @@ private:
     uint16_t m_numEncoders;
     EncoderState* m_encoders;
 
+    // Bit-parallel state (one bit per encoder, 32 encoders per word)
+    DecodeMode m_decodeMode;
+    uint8_t m_numWords;
+    uint8_t m_numBytes;         // Bytes of shift register data used by encoders
+    uint32_t* m_lastClk;        // Last CLK plane
+    uint32_t* m_lastDt;         // Last DT plane
+    uint32_t* m_pendingMask;    // Moved since delta was last read
+
     // Gray code state machine lookup table
     // Returns -1 (CCW), 0 (invalid/no change), +1 (CW)
     static const int8_t STATE_TABLE[4][4];
@@ -102,6 +154,26 @@ private:
      */
     void decodeEncoder(EncoderState* encoder, uint8_t newBits);
 
+    /**
+     * Table-driven update (one encoder at a time)
+     */
+    void updateTable(const uint8_t* data);
+
+    /**
+     * Bit-parallel update (32 encoders per word)
+     */
+    void updateParallel(const uint8_t* data, const uint8_t* diff);
+
+    /**
+     * Load the 64 interleaved CLK/DT bits of one 32-encoder word
+     */
+    uint64_t loadWordBits(const uint8_t* data, uint8_t word) const;
+
+    /**
+     * Mask of valid encoder bits in a word (last word may be partial)
+     */
+    uint32_t validMask(uint8_t word) const;
+
     /**
      * Calculate acceleration multiplier based on speed
      * @param deltaTime - Time between detents (µs)
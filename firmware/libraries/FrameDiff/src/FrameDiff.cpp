@@ -0,0 +1,65 @@
+#include "FrameDiff.h"
+
+FrameDiff::FrameDiff(uint8_t numBytes)
+    : m_numBytes(numBytes)
+    , m_previous(nullptr)
+    , m_diff(nullptr)
+    , m_havePrevious(false)
+    , m_unchangedCount(0)
+    , m_changedCount(0)
+{
+    // Round up to whole words so compare() never needs a byte tail loop
+    uint8_t paddedBytes = (numBytes + 3) & ~3;
+    m_previous = new uint8_t[paddedBytes];
+    m_diff = new uint8_t[paddedBytes];
+    memset(m_previous, 0, paddedBytes);
+    memset(m_diff, 0, paddedBytes);
+}
+
+FrameDiff::~FrameDiff() {
+    delete[] m_previous;
+    delete[] m_diff;
+}
+
+void FrameDiff::begin() {
+    m_havePrevious = false;
+    m_unchangedCount = 0;
+    m_changedCount = 0;
+}
+
+bool FrameDiff::compare(const uint8_t* frame) {
+    uint32_t any = 0;
+    uint8_t i = 0;
+
+    for (; i + 4 <= m_numBytes; i += 4) {
+        uint32_t now, before;
+        memcpy(&now, frame + i, 4);
+        memcpy(&before, m_previous + i, 4);
+        uint32_t diff = now ^ before;
+        memcpy(m_diff + i, &diff, 4);
+        memcpy(m_previous + i, &now, 4);
+        any |= diff;
+    }
+
+    for (; i < m_numBytes; i++) {
+        uint8_t diff = frame[i] ^ m_previous[i];
+        m_diff[i] = diff;
+        m_previous[i] = frame[i];
+        any |= diff;
+    }
+
+    if (!m_havePrevious) {
+        // First frame: everything counts as changed
+        memset(m_diff, 0xFF, m_numBytes);
+        m_havePrevious = true;
+        any = 1;
+    }
+
+    if (any) {
+        m_changedCount++;
+        return true;
+    }
+
+    m_unchangedCount++;
+    return false;
+}
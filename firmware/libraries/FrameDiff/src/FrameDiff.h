@@ -0,0 +1,76 @@
+#ifndef FRAME_DIFF_H
+#define FRAME_DIFF_H
+
+#include <Arduino.h>
+
+/**
+ * FrameDiff - Shift Register Frame Change Detection
+ *
+ * Sits in front of the scan pipeline. Each new shift register frame is
+ * XORed with the previous one, 32 bits at a time. When nothing changed the
+ * scanner can skip encoder and button decoding entirely; when something
+ * did, the XOR frame (same layout as the data) tells the decoders which
+ * words to look at.
+ *
+ * Features:
+ * - Word-wise XOR compare (4 bytes per step)
+ * - Diff frame for per-word decode skipping
+ * - Changed/unchanged cycle counters
+ *
+ * Typical usage:
+ *   FrameDiff frameDiff(SR_NUM_CHIPS);
+ *   frameDiff.begin();
+ *
+ *   // Each scan:
+ *   if (frameDiff.compare(data) || !buttons.isSettled()) {
+ *       encoders.update(data, frameDiff.getDiff());
+ *       buttons.update(data, BUTTON_OFFSET, frameDiff.getDiff());
+ *   }
+ */
+class FrameDiff {
+public:
+    /**
+     * Constructor
+     * @param numBytes - Frame size in bytes (number of shift register chips)
+     */
+    FrameDiff(uint8_t numBytes);
+    ~FrameDiff();
+
+    /**
+     * Reset previous frame (next compare() always reports a change)
+     */
+    void begin();
+
+    /**
+     * Compare a new frame with the previous one and keep it for next time
+     * @param frame - Shift register buffer (numBytes long)
+     * @return true if any bit changed
+     */
+    bool compare(const uint8_t* frame);
+
+    /**
+     * Get XOR of the last two frames (valid after compare())
+     * Bits set where the input changed; same layout as the frame
+     */
+    const uint8_t* getDiff() const { return m_diff; }
+
+    /**
+     * Get number of compares that found no change
+     */
+    uint32_t getUnchangedCount() const { return m_unchangedCount; }
+
+    /**
+     * Get number of compares that found a change
+     */
+    uint32_t getChangedCount() const { return m_changedCount; }
+
+private:
+    uint8_t m_numBytes;
+    uint8_t* m_previous;
+    uint8_t* m_diff;
+    bool m_havePrevious;
+    uint32_t m_unchangedCount;
+    uint32_t m_changedCount;
+};
+
+#endif // FRAME_DIFF_H
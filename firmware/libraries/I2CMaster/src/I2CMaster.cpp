@@ -1,4 +1,5 @@
 #include "I2CMaster.h"
+#include <CRC32.h>
 
 I2CMaster::I2CMaster(TwoWire& wire)
     : m_wire(wire)
@@ -13,6 +14,7 @@ bool I2CMaster::addSlave(uint8_t address) {
         return false;
     }
 
+    memset(&m_linkStats[m_numSlaves], 0, sizeof(I2CLinkStats));
     m_slaveAddresses[m_numSlaves++] = address;
     return true;
 }
@@ -25,7 +27,7 @@ bool I2CMaster::begin(uint32_t clockSpeed) {
 
 void I2CMaster::poll() {
     for (uint8_t i = 0; i < m_numSlaves; i++) {
-        readEventsFromSlave(m_slaveAddresses[i]);
+        readEventsFromSlave(i);
     }
 }
 
@@ -61,7 +63,20 @@ bool I2CMaster::isSlaveHealthy(uint8_t address) {
     return result == 0;
 }
 
-bool I2CMaster::readEventsFromSlave(uint8_t address) {
+bool I2CMaster::getLinkStats(uint8_t address, I2CLinkStats& stats) {
+    for (uint8_t i = 0; i < m_numSlaves; i++) {
+        if (m_slaveAddresses[i] == address) {
+            stats = m_linkStats[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool I2CMaster::readEventsFromSlave(uint8_t slaveIndex) {
+    uint8_t address = m_slaveAddresses[slaveIndex];
+    I2CLinkStats& link = m_linkStats[slaveIndex];
+
     // Send GET_EVENTS command
     m_wire.beginTransmission(address);
     m_wire.write((uint8_t)CMD_GET_EVENTS);
@@ -71,23 +86,47 @@ bool I2CMaster::readEventsFromSlave(uint8_t address) {
         return false;
     }
 
-    // Request event data
-    uint8_t bytesReceived = m_wire.requestFrom(address, (uint8_t)49);
+    // Phase 1: batch header (numEvents, sequence, backlog)
+    BatchEventMessage batch;
+    if (m_wire.requestFrom(address, (uint8_t)BATCH_HEADER_SIZE) != BATCH_HEADER_SIZE) {
+        return false;
+    }
+    m_wire.readBytes((uint8_t*)&batch, BATCH_HEADER_SIZE);
+    link.bytesRead += BATCH_HEADER_SIZE;
 
-    if (bytesReceived == 0) {
+    if (batch.numEvents > MAX_EVENTS_PER_BATCH) {
+        link.checksumErrors++;  // Corrupt header
         return false;
     }
 
-    // Read event count
-    uint8_t numEvents = m_wire.read();
+    link.backlog = batch.backlog;
 
-    // Read events
-    for (uint8_t i = 0; i < numEvents && i < 6; i++) {
-        if (m_wire.available() >= sizeof(EventMessage)) {
-            EventMessage event;
-            m_wire.readBytes((uint8_t*)&event, sizeof(EventMessage));
-            queueEvent(event);
-        }
+    if (batch.numEvents == 0) {
+        trackBatchSequence(link, batch);
+        return true;
+    }
+
+    // Phase 2: exactly the events in this batch, then CRC32
+    uint8_t payloadSize = batchPayloadSize(batch.numEvents);
+    if (m_wire.requestFrom(address, payloadSize) != payloadSize) {
+        return false;
+    }
+    m_wire.readBytes((uint8_t*)batch.events, batch.numEvents * sizeof(EventMessage));
+    m_wire.readBytes((uint8_t*)&batch.checksum, sizeof(batch.checksum));
+    link.bytesRead += payloadSize;
+
+    uint32_t checksum = CRC32::calculate(&batch, BATCH_HEADER_SIZE + batch.numEvents * sizeof(EventMessage));
+    if (checksum != batch.checksum) {
+        link.checksumErrors++;
+        return false;
+    }
+
+    if (!trackBatchSequence(link, batch)) {
+        return true;  // Duplicate: already queued these events
+    }
+
+    for (uint8_t i = 0; i < batch.numEvents; i++) {
+        queueEvent(batch.events[i]);
     }
 
     return true;
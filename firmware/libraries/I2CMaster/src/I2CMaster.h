@@ -15,6 +15,7 @@
  * - Single I2C bus communication
  * - Sequential slave polling
  * - Event queuing
+ * - Header-first batch reads with CRC32 and sequence checking
  * - Health monitoring
  *
  * Typical usage:
@@ -82,6 +83,14 @@ public:
      */
     bool isSlaveHealthy(uint8_t address);
 
+    /**
+     * Get batch link statistics for a slave
+     * @param address - Slave address
+     * @param stats - Output parameter for statistics
+     * @return true if slave found
+     */
+    bool getLinkStats(uint8_t address, I2CLinkStats& stats);
+
 private:
     TwoWire& m_wire;
 
@@ -89,13 +98,14 @@ private:
     static const uint16_t EVENT_QUEUE_SIZE = 128;
 
     uint8_t m_slaveAddresses[MAX_SLAVES];
+    I2CLinkStats m_linkStats[MAX_SLAVES];
     uint8_t m_numSlaves;
 
     EventMessage m_eventQueue[EVENT_QUEUE_SIZE];
     uint16_t m_queueHead;
     uint16_t m_queueTail;
 
-    bool readEventsFromSlave(uint8_t address);
+    bool readEventsFromSlave(uint8_t slaveIndex);
     bool queueEvent(const EventMessage& event);
 };
 
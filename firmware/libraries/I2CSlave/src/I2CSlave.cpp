@@ -1,6 +1,7 @@
 #include "I2CSlave.h"
+#include <CRC32.h>
 
-#ifdef ESP32
+#if defined(ESP32) || defined(NATIVE_BUILD)
 
 I2CSlave* I2CSlave::s_instance = nullptr;
 
@@ -10,8 +11,12 @@ I2CSlave::I2CSlave(uint8_t address, TwoWire& wire, int eventPin)
     , m_eventPin(eventPin)
     , m_queueHead(0)
     , m_queueTail(0)
+    , m_requestPhase(PHASE_HEADER)
+    , m_batchPending(false)
+    , m_sequence(0)
 {
     s_instance = this;
+    memset(&m_batch, 0, sizeof(m_batch));
     memset(&m_metrics, 0, sizeof(m_metrics));
 }
 
@@ -35,8 +40,8 @@ bool I2CSlave::begin(int sdaPin, int sclPin, uint32_t clockSpeed) {
 }
 
 void I2CSlave::update() {
-    // Signal if events are queued
-    if (m_queueHead != m_queueTail && m_eventPin >= 0) {
+    // Signal while events are queued or a batch is still waiting for its payload read
+    if ((m_queueHead != m_queueTail || m_batchPending) && m_eventPin >= 0) {
         signalEvent();
     } else if (m_eventPin >= 0) {
         clearEventSignal();
@@ -75,6 +80,10 @@ const DiagnosticMetrics& I2CSlave::getMetrics() const {
 void I2CSlave::reset() {
     m_queueHead = 0;
     m_queueTail = 0;
+    memset(&m_batch, 0, sizeof(m_batch));
+    m_requestPhase = PHASE_HEADER;
+    m_batchPending = false;
+    m_sequence = 0;
     memset(&m_metrics, 0, sizeof(m_metrics));
     clearEventSignal();
 }
@@ -92,21 +101,47 @@ void I2CSlave::onReceiveStatic(int numBytes) {
 }
 
 void I2CSlave::onRequest() {
-    // Master is requesting data
-    // Send queued events (up to 6 events, 8 bytes each = 48 bytes)
-    const uint16_t MAX_EVENTS_PER_TRANSACTION = 6;
-    uint8_t numEvents = min(getQueuedEventCount(), MAX_EVENTS_PER_TRANSACTION);
+    // Master is requesting data (batch prepared by CMD_GET_EVENTS)
+    if (m_requestPhase == PHASE_HEADER) {
+        // Phase 1: numEvents, sequenceNumber, backlog (4 bytes)
+        m_wire.write((uint8_t*)&m_batch, BATCH_HEADER_SIZE);
+        if (m_batch.numEvents > 0) {
+            m_requestPhase = PHASE_PAYLOAD;
+        }
+    } else {
+        // Phase 2: only the events in this batch, then CRC32
+        m_wire.write((uint8_t*)m_batch.events, m_batch.numEvents * sizeof(EventMessage));
+        m_wire.write((uint8_t*)&m_batch.checksum, sizeof(m_batch.checksum));
+        m_batchPending = false;
+        m_requestPhase = PHASE_HEADER;
+
+        // Drop the ready line as soon as we are drained, so the master
+        // does not come back for an empty batch before update() runs
+        if (m_queueHead == m_queueTail) {
+            clearEventSignal();
+        }
+    }
+}
 
-    // Send event count first
-    m_wire.write(numEvents);
+void I2CSlave::prepareBatch() {
+    uint8_t numEvents = min(getQueuedEventCount(), (uint16_t)MAX_EVENTS_PER_BATCH);
 
-    // Send events
     for (uint8_t i = 0; i < numEvents; i++) {
-        const EventMessage& event = m_eventQueue[m_queueTail];
-        m_wire.write((uint8_t*)&event, sizeof(EventMessage));
-
+        m_batch.events[i] = m_eventQueue[m_queueTail];
         m_queueTail = (m_queueTail + 1) % MAX_QUEUED_EVENTS;
     }
+
+    // Empty batches repeat the last sequence number, so the master can still
+    // spot a lost batch on an idle poll
+    if (numEvents > 0) {
+        m_sequence++;
+    }
+
+    m_batch.numEvents = numEvents;
+    m_batch.sequenceNumber = m_sequence;
+    m_batch.backlog = getQueuedEventCount();
+    m_batch.checksum = CRC32::calculate(&m_batch, BATCH_HEADER_SIZE + numEvents * sizeof(EventMessage));
+    m_batchPending = numEvents > 0;
 }
 
 void I2CSlave::onReceive(int numBytes) {
@@ -144,7 +179,14 @@ void I2CSlave::onReceive(int numBytes) {
 }
 
 void I2CSlave::handleGetEventsCommand() {
+    // If the master read a header but never the payload, send that batch
+    // again (same sequence number) instead of dropping its events
+    if (!m_batchPending) {
+        prepareBatch();
+    }
+
     // Master will call onRequest() next
+    m_requestPhase = PHASE_HEADER;
 }
 
 void I2CSlave::handleGetStatusCommand() {
@@ -172,4 +214,4 @@ void I2CSlave::clearEventSignal() {
     }
 }
 
-#endif // ESP32
+#endif // ESP32 || NATIVE_BUILD
@@ -4,7 +4,7 @@
 #include <Arduino.h>
 #include <Protocol.h>
 
-#ifdef ESP32
+#if defined(ESP32) || defined(NATIVE_BUILD)
 #include <Wire.h>
 
 /**
@@ -16,6 +16,9 @@
  * Features:
  * - Interrupt-driven (responds to master immediately)
  * - Event queue for batching up to 6 events per transaction
+ * - BatchEventMessage transfer: 4-byte header, then only the events
+ *   present plus a CRC32 (see Protocol.h)
+ * - Sequence numbers so the master can detect lost/duplicate batches
  * - Command-response protocol
  * - Status reporting
  *
@@ -78,6 +81,11 @@ public:
      */
     void reset();
 
+    /**
+     * Get sequence number of the last non-empty batch
+     */
+    uint8_t getSequenceNumber() const { return m_sequence; }
+
 private:
     uint8_t m_address;
     TwoWire& m_wire;
@@ -89,6 +97,17 @@ private:
     volatile uint16_t m_queueHead;
     volatile uint16_t m_queueTail;
 
+    // Batch transfer (CMD_GET_EVENTS -> header read -> payload read)
+    enum RequestPhase : uint8_t {
+        PHASE_HEADER = 0,
+        PHASE_PAYLOAD = 1
+    };
+
+    BatchEventMessage m_batch;
+    volatile RequestPhase m_requestPhase;
+    volatile bool m_batchPending;   // Payload not yet sent; resend as-is
+    uint8_t m_sequence;
+
     // Status
     DiagnosticMetrics m_metrics;
 
@@ -100,6 +119,11 @@ private:
     void onRequest();
     void onReceive(int numBytes);
 
+    /**
+     * Move up to MAX_EVENTS_PER_BATCH queued events into m_batch
+     */
+    void prepareBatch();
+
     void handleGetEventsCommand();
     void handleGetStatusCommand();
     void handlePingCommand();
@@ -109,5 +133,5 @@ private:
     void clearEventSignal();
 };
 
-#endif // ESP32
+#endif // ESP32 || NATIVE_BUILD
 #endif // I2C_SLAVE_H
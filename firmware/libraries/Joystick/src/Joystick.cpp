@@ -133,7 +133,7 @@ uint16_t Joystick::readFiltered(uint8_t pin) {
     return sum / 4;
 }
 
-int16_t Joystick::applyDeadZone(int16_t value, uint8_t deadZone) {
+int16_t Joystick::applyDeadZone(int16_t value, uint8_t deadZone) const {
     if (abs(value) < deadZone) {
         return 0;
     }
@@ -57,7 +57,7 @@ private:
     bool m_pressedFlag, m_releasedFlag;
 
     uint16_t readFiltered(uint8_t pin);
-    int16_t applyDeadZone(int16_t value, uint8_t deadZone);
+    int16_t applyDeadZone(int16_t value, uint8_t deadZone) const;
 };
 
 #endif // JOYSTICK_H
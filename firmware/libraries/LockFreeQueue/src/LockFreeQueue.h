@@ -4,7 +4,7 @@
 #include <Arduino.h>
 #include <Protocol.h>
 
-#ifdef ESP32
+#if defined(ESP32) || defined(NATIVE_BUILD)
 #include <atomic>
 
 /**
@@ -160,5 +160,5 @@ private:
     }
 };
 
-#endif // ESP32
+#endif // ESP32 || NATIVE_BUILD
 #endif // LOCK_FREE_QUEUE_H
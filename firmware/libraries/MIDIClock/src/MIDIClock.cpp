@@ -0,0 +1,139 @@
+#include "MIDIClock.h"
+
+MIDIClock::MIDIClock()
+    : m_running(false)
+    , m_awaitingFirstTick(false)
+    , m_haveLastTick(false)
+    , m_ticks(0)
+    , m_lastTickTime(0)
+    , m_intervalQ8(0)
+    , m_clockCount(0)
+    , m_jitterLimitedCount(0)
+{
+}
+
+void MIDIClock::begin() {
+    m_running = false;
+    m_awaitingFirstTick = false;
+    m_haveLastTick = false;
+    m_ticks = 0;
+    m_lastTickTime = 0;
+    m_intervalQ8 = 0;
+    m_clockCount = 0;
+    m_jitterLimitedCount = 0;
+}
+
+bool MIDIClock::processMessage(uint8_t type, uint8_t data1, uint8_t data2, uint32_t timestampUs) {
+    switch (type) {
+        case 0xF8:
+            handleClock(timestampUs);
+            return true;
+
+        case 0xFA:
+            handleStart();
+            return true;
+
+        case 0xFB:
+            handleContinue();
+            return true;
+
+        case 0xFC:
+            handleStop();
+            return true;
+
+        case 0xF2:
+            handleSongPosition((uint16_t)(data1 & 0x7F) | ((uint16_t)(data2 & 0x7F) << 7));
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+void MIDIClock::handleClock(uint32_t timestampUs) {
+    m_clockCount++;
+
+    if (m_haveLastTick) {
+        uint32_t interval = timestampUs - m_lastTickTime;
+
+        // A gap of many ticks (clock paused without Stop) says nothing about tempo
+        uint32_t maxInterval = m_intervalQ8 ? (m_intervalQ8 >> 8) * TIMEOUT_TICKS : MAX_TICK_INTERVAL_US;
+        if (interval > 0 && interval < maxInterval) {
+            int32_t intervalQ8 = (int32_t)(interval << 8);
+
+            if (m_intervalQ8 == 0) {
+                m_intervalQ8 = intervalQ8;  // Seed
+            } else {
+                int32_t error = intervalQ8 - (int32_t)m_intervalQ8;
+                int32_t limit = (int32_t)(m_intervalQ8 >> 2);
+                if (error > limit || error < -limit) {
+                    error = error > 0 ? limit : -limit;
+                    m_jitterLimitedCount++;
+                }
+                m_intervalQ8 += error / (1 << FILTER_SHIFT);
+            }
+        }
+    }
+
+    m_lastTickTime = timestampUs;
+    m_haveLastTick = true;
+
+    // The first clock after Start/Continue plays the current position;
+    // each later one advances it
+    if (m_awaitingFirstTick) {
+        m_awaitingFirstTick = false;
+    } else if (m_running) {
+        m_ticks++;
+    }
+}
+
+void MIDIClock::handleStart() {
+    m_ticks = 0;
+    handleContinue();
+}
+
+void MIDIClock::handleContinue() {
+    m_running = true;
+    m_awaitingFirstTick = true;
+}
+
+void MIDIClock::handleStop() {
+    m_running = false;
+}
+
+void MIDIClock::handleSongPosition(uint16_t sixteenths) {
+    m_ticks = (uint32_t)sixteenths * 6;
+}
+
+bool MIDIClock::isRunning(uint32_t nowUs) const {
+    if (!m_running || m_intervalQ8 == 0) {
+        return false;
+    }
+    return (nowUs - m_lastTickTime) < (m_intervalQ8 >> 8) * TIMEOUT_TICKS;
+}
+
+uint64_t MIDIClock::getPositionQ16(uint32_t nowUs) const {
+    uint64_t position = (uint64_t)m_ticks << 16;
+
+    if (!m_running || m_awaitingFirstTick || m_intervalQ8 == 0) {
+        return position;
+    }
+
+    // Phase since the last tick, held just short of the next tick until it arrives
+    uint32_t sinceUs = nowUs - m_lastTickTime;
+    if (sinceUs >= (m_intervalQ8 >> 8)) {
+        return position | 0xFFFF;
+    }
+
+    uint32_t phase = (uint32_t)(((uint64_t)sinceUs << 24) / m_intervalQ8);
+    return position | (phase > 0xFFFF ? 0xFFFF : phase);
+}
+
+uint32_t MIDIClock::getBPMx100() const {
+    if (m_intervalQ8 == 0) {
+        return 0;
+    }
+
+    // 60 s * 100 / (24 ticks * interval)
+    return (uint32_t)((60000000ULL * 100 * 256) / ((uint64_t)TICKS_PER_QUARTER * m_intervalQ8));
+}
@@ -0,0 +1,141 @@
+#ifndef MIDI_CLOCK_H
+#define MIDI_CLOCK_H
+
+#include <Arduino.h>
+#include <Protocol.h>
+
+/**
+ * MIDIClock - Incoming MIDI Clock Tracking
+ *
+ * Follows an external MIDI clock (24 PPQN): counts ticks from Start/Continue,
+ * timestamps each tick and estimates the tick interval. The song position is
+ * available at any moment with a sub-tick phase interpolated from the time
+ * since the last tick, so a clock-synced transition can compute its progress
+ * directly instead of waiting for tick messages.
+ *
+ * Tempo filter:
+ * - The first tick-to-tick interval seeds the estimate (ticks keep coming
+ *   while stopped, so the tempo is usually known before Start)
+ * - Each later interval moves the estimate 1/8 of the way toward it, with
+ *   the step limited to +/-25% of the estimate, so USB and loop-timing
+ *   jitter (single late or bunched ticks) barely moves the tempo while a
+ *   real tempo change is followed within about a beat
+ * - Intervals are kept in 1/256 us, so no precision is lost at any tempo
+ *
+ * Messages: 0xF8 clock, 0xFA start, 0xFB continue, 0xFC stop, 0xF2 song
+ * position pointer.
+ *
+ * Typical usage:
+ *   MIDIClock midiClock;
+ *   midiClock.begin();
+ *
+ *   while (usbMIDI.read()) {
+ *       midiClock.processMessage(usbMIDI.getType(), usbMIDI.getData1(),
+ *                                usbMIDI.getData2(), micros());
+ *   }
+ *
+ *   uint64_t position = midiClock.getPositionQ16(micros());  // ticks << 16 | phase
+ */
+class MIDIClock {
+public:
+    static const uint8_t TICKS_PER_QUARTER = 24;
+
+    MIDIClock();
+
+    /**
+     * Initialize (stopped, no tempo)
+     */
+    void begin();
+
+    /**
+     * Handle a received message (ignores non-clock messages)
+     * @param type - Status byte (usbMIDI.getType())
+     * @param data1 - First data byte
+     * @param data2 - Second data byte
+     * @param timestampUs - micros() when it was received
+     * @return true if it was a clock or transport message
+     */
+    bool processMessage(uint8_t type, uint8_t data1, uint8_t data2, uint32_t timestampUs);
+
+    /**
+     * Clock tick (0xF8)
+     */
+    void handleClock(uint32_t timestampUs);
+
+    /**
+     * Start (0xFA): position 0, running from the next tick
+     */
+    void handleStart();
+
+    /**
+     * Continue (0xFB): running from the current position at the next tick
+     */
+    void handleContinue();
+
+    /**
+     * Stop (0xFC): position holds
+     */
+    void handleStop();
+
+    /**
+     * Song position pointer (0xF2)
+     * @param sixteenths - Position in 1/16 notes (6 ticks each)
+     */
+    void handleSongPosition(uint16_t sixteenths);
+
+    /**
+     * Check if the clock is running (started and ticks arriving)
+     * @param nowUs - micros()
+     */
+    bool isRunning(uint32_t nowUs) const;
+
+    /**
+     * Check if a tempo estimate is available
+     */
+    bool hasTempo() const { return m_intervalQ8 != 0; }
+
+    /**
+     * Get song position in ticks since Start
+     */
+    uint32_t getTicks() const { return m_ticks; }
+
+    /**
+     * Get song position with sub-tick phase
+     * @param nowUs - micros()
+     * @return Ticks in the upper bits, phase (0-65535) in the low 16 bits
+     */
+    uint64_t getPositionQ16(uint32_t nowUs) const;
+
+    /**
+     * Get estimated tick interval in microseconds (0 if unknown)
+     */
+    uint32_t getTickIntervalUs() const { return m_intervalQ8 >> 8; }
+
+    /**
+     * Get estimated tempo in BPM x 100 (0 if unknown)
+     */
+    uint32_t getBPMx100() const;
+
+    /**
+     * Get statistics
+     */
+    uint32_t getClockCount() const { return m_clockCount; }
+    uint32_t getJitterLimitedCount() const { return m_jitterLimitedCount; }  // Steps clamped by the filter
+
+private:
+    static const uint8_t FILTER_SHIFT = 3;      // Move 1/8 toward each new interval
+    static const uint8_t TIMEOUT_TICKS = 8;     // Not running after this many missed ticks
+    static const uint32_t MAX_TICK_INTERVAL_US = 1000000;  // Slowest usable clock (2.5 BPM)
+
+    bool m_running;
+    bool m_awaitingFirstTick;   // Start/Continue received, first tick not yet
+    bool m_haveLastTick;
+    uint32_t m_ticks;
+    uint32_t m_lastTickTime;    // micros() of the last tick
+    uint32_t m_intervalQ8;      // Estimated tick interval, 1/256 us
+
+    uint32_t m_clockCount;
+    uint32_t m_jitterLimitedCount;
+};
+
+#endif // MIDI_CLOCK_H
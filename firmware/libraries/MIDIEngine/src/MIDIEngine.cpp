@@ -1,126 +1,233 @@
 #include "MIDIEngine.h"
 
+/**
+ * Delta carried by a relative encoder value (ValueEngine's encodings;
+ * RELATIVE_2's fast 0/127 counts as two detents)
+ */
+static int16_t decodeRelative(uint8_t mode, uint8_t value) {
+    switch (mode) {
+        case ENCODER_RELATIVE_2:
+            if (value == 127) return 2;
+            if (value == 0) return -2;
+            return (int16_t)value - 64;
+
+        case ENCODER_RELATIVE_3:
+            return (value & 0x40) ? (int16_t)value - 128 : (int16_t)value;
+
+        default:  // ENCODER_RELATIVE_1
+            return (int16_t)value - 64;
+    }
+}
+
+/**
+ * Encode as much of a delta as one message carries
+ * @param sent - Output: the part of delta the value represents
+ * @return MIDI value
+ */
+static uint8_t encodeRelative(uint8_t mode, int16_t delta, int16_t& sent) {
+    if (mode == ENCODER_RELATIVE_2) {
+        if (delta == 1 || delta == -1) {
+            sent = delta;
+            return delta > 0 ? 65 : 63;
+        }
+        sent = delta > 0 ? 2 : -2;
+        return delta > 0 ? 127 : 0;
+    }
+
+    sent = delta > 63 ? 63 : (delta < -64 ? -64 : delta);
+    return (mode == ENCODER_RELATIVE_3) ? (uint8_t)(sent & 0x7F) : (uint8_t)(64 + sent);
+}
+
 MIDIEngine::MIDIEngine()
     : m_messagesSent(0)
+    , m_messagesCoalesced(0)
     , m_messagesDropped(0)
     , m_lastRateCalcTime(0)
     , m_messagesInPeriod(0)
-    , m_lastMessageTime(0)
+    , m_slotValues(nullptr)
+    , m_pendingBits(nullptr)
+    , m_pendingCount(0)
+    , m_txCount(0)
+    , m_txFirstTime(0)
+    , m_flushPolicy(MIDI_FLUSH_LOOP)
+    , m_flushDeadlineUs(1000)
+    , m_usbPackets(0)
+    , m_usbTransactions(0)
 {
+    m_slotValues = new uint16_t[NUM_SLOTS];
+    m_pendingBits = new uint32_t[PENDING_WORDS];
+    memset(m_pendingBits, 0, sizeof(uint32_t) * PENDING_WORDS);
+
+    memset(m_buckets, 0, sizeof(m_buckets));
+    setMaxRate(MAX_MESSAGES_PER_SECOND);
+}
+
+MIDIEngine::~MIDIEngine() {
+    delete[] m_slotValues;
+    delete[] m_pendingBits;
 }
 
 void MIDIEngine::begin() {
     m_messagesSent = 0;
+    m_messagesCoalesced = 0;
     m_messagesDropped = 0;
     m_lastRateCalcTime = millis();
-    m_lastMessageTime = micros();
+
+    memset(m_pendingBits, 0, sizeof(uint32_t) * PENDING_WORDS);
+    m_pendingCount = 0;
+
+    // Start every device with a full bucket
+    uint32_t now = micros();
+    for (uint8_t d = 0; d < NUM_DEVICES; d++) {
+        DeviceBucket& bucket = m_buckets[d];
+        bucket.tokens = (int32_t)bucket.burst * TOKEN;
+        bucket.lastRefill = now;
+        bucket.messagesSent = 0;
+        bucket.pending = 0;
+        bucket.cursor = 0;
+    }
+
+    m_txCount = 0;
+    m_usbPackets = 0;
+    m_usbTransactions = 0;
 }
 
-bool MIDIEngine::sendCC(uint8_t device, uint8_t channel, uint8_t ccNumber, uint8_t value) {
-    if (shouldThrottle()) {
-        m_messagesDropped++;
-        return false;
+void MIDIEngine::update() {
+    drain();
+
+    if (m_txCount > 0) {
+        if (m_flushPolicy == MIDI_FLUSH_LOOP ||
+            (m_flushPolicy == MIDI_FLUSH_DEADLINE && micros() - m_txFirstTime >= m_flushDeadlineUs)) {
+            flush();
+        }
     }
+}
 
-    uint8_t status = 0xB0 | (channel & 0x0F);  // Control Change
-#ifdef ARDUINO_TEENSY40
-    sendMIDIMessage(device, status, ccNumber, value);
-#endif
+void MIDIEngine::drain() {
+    uint32_t now = micros();
 
-    recordMessage();
-    return true;
+    // Each device drains only against its own bucket
+    for (uint8_t d = 0; d < NUM_DEVICES; d++) {
+        DeviceBucket& bucket = m_buckets[d];
+        if (bucket.pending == 0) {
+            continue;
+        }
+
+        refillBucket(bucket, now);
+        while (bucket.pending > 0 && bucket.tokens >= TOKEN) {
+            recordMessages(d, sendSlot(takePendingSlot(d)));
+        }
+    }
 }
 
-bool MIDIEngine::sendCC14bit(uint8_t device, uint8_t channel, uint8_t ccNumber, uint16_t value14) {
-    if (ccNumber >= 32) {
-        return false;  // Only CC 0-31 support 14-bit
+void MIDIEngine::setMaxRate(uint32_t messagesPerSecond) {
+    for (uint8_t d = 0; d < NUM_DEVICES; d++) {
+        setDeviceRate(d, messagesPerSecond, m_buckets[d].burst ? m_buckets[d].burst : DEFAULT_BURST);
     }
+}
 
-    if (shouldThrottle()) {
-        m_messagesDropped++;
+bool MIDIEngine::setDeviceRate(uint8_t device, uint32_t messagesPerSecond, uint8_t burst) {
+    if (device >= NUM_DEVICES || messagesPerSecond == 0 || messagesPerSecond > 100000 || burst == 0) {
         return false;
     }
 
-    // Send MSB (CC 0-31)
-    uint8_t msb = (value14 >> 7) & 0x7F;
-    uint8_t lsb = value14 & 0x7F;
+    DeviceBucket& bucket = m_buckets[device];
+    refillBucket(bucket, micros());
 
-    uint8_t status = 0xB0 | (channel & 0x0F);
+    bucket.ratePerSecond = messagesPerSecond;
+    bucket.burst = burst;
 
-#ifdef ARDUINO_TEENSY40
-    sendMIDIMessage(device, status, ccNumber, msb);
-    sendMIDIMessage(device, status, ccNumber + 32, lsb);  // LSB is +32
-#endif
+    // Refill from full debt (-burst) to full (+burst); beyond this the
+    // bucket is simply full, which also keeps elapsed * rate within 32 bits
+    bucket.fillTimeUs = (uint32_t)(2UL * burst * (uint32_t)TOKEN / messagesPerSecond) + 1;
 
-    recordMessage();
-    recordMessage();  // Two messages sent
+    if (bucket.tokens > (int32_t)burst * TOKEN) {
+        bucket.tokens = (int32_t)burst * TOKEN;
+    }
     return true;
 }
 
-bool MIDIEngine::sendPitchBend(uint8_t device, uint8_t channel, uint16_t value14) {
-    if (shouldThrottle()) {
-        m_messagesDropped++;
-        return false;
+uint16_t MIDIEngine::getDevicePendingCount(uint8_t device) const {
+    return device < NUM_DEVICES ? m_buckets[device].pending : 0;
+}
+
+uint32_t MIDIEngine::getDeviceMessagesSent(uint8_t device) const {
+    return device < NUM_DEVICES ? m_buckets[device].messagesSent : 0;
+}
+
+void MIDIEngine::setFlushPolicy(MIDIFlushPolicy policy, uint32_t deadlineUs) {
+    m_flushPolicy = policy;
+    m_flushDeadlineUs = deadlineUs;
+    if (policy == MIDI_FLUSH_IMMEDIATE) {
+        flush();
     }
+}
 
-    uint8_t status = 0xE0 | (channel & 0x0F);  // Pitch Bend
-    uint8_t lsb = value14 & 0x7F;
-    uint8_t msb = (value14 >> 7) & 0x7F;
+void MIDIEngine::flush() {
+    if (m_txCount == 0) {
+        return;
+    }
 
-#ifdef ARDUINO_TEENSY40
-    sendMIDIMessage(device, status, lsb, msb);
+#if defined(ARDUINO_TEENSY40) || defined(NATIVE_BUILD)
+    for (uint8_t i = 0; i < m_txCount; i++) {
+        usb_midi_write_packed(m_txPackets[i]);
+    }
+    usb_midi_flush_output();
 #endif
 
-    recordMessage();
-    return true;
+    m_usbPackets += m_txCount;
+    m_usbTransactions++;
+    m_txCount = 0;
 }
 
-bool MIDIEngine::sendProgramChange(uint8_t device, uint8_t channel, uint8_t program) {
-    if (shouldThrottle()) {
+bool MIDIEngine::sendCC(uint8_t device, uint8_t channel, uint8_t ccNumber, uint8_t value) {
+    if (device >= NUM_DEVICES || ccNumber > 127) {
         m_messagesDropped++;
         return false;
     }
 
-    uint8_t status = 0xC0 | (channel & 0x0F);  // Program Change
-
-#ifdef ARDUINO_TEENSY40
-    sendMIDIMessage(device, status, program);
-#endif
-
-    recordMessage();
+    queueSlot(device, slotIndex(device, channel, ccNumber), value & 0x7F);
+    drain();
     return true;
 }
 
-bool MIDIEngine::sendNoteOn(uint8_t device, uint8_t channel, uint8_t note, uint8_t velocity) {
-    if (shouldThrottle()) {
+bool MIDIEngine::sendCC14bit(uint8_t device, uint8_t channel, uint8_t ccNumber, uint16_t value14) {
+    if (ccNumber >= 32) {
+        return false;  // Only CC 0-31 support 14-bit
+    }
+
+    if (device >= NUM_DEVICES) {
         m_messagesDropped++;
         return false;
     }
 
-    uint8_t status = 0x90 | (channel & 0x0F);  // Note On
-
-#ifdef ARDUINO_TEENSY40
-    sendMIDIMessage(device, status, note, velocity);
-#endif
-
-    recordMessage();
+    // One slot for the pair (keyed on the MSB controller)
+    queueSlot(device, slotIndex(device, channel, ccNumber), (value14 & 0x3FFF) | SLOT_14BIT);
+    drain();
     return true;
 }
 
-bool MIDIEngine::sendNoteOff(uint8_t device, uint8_t channel, uint8_t note) {
-    if (shouldThrottle()) {
+bool MIDIEngine::sendPitchBend(uint8_t device, uint8_t channel, uint16_t value14) {
+    if (device >= NUM_DEVICES) {
         m_messagesDropped++;
         return false;
     }
 
-    uint8_t status = 0x80 | (channel & 0x0F);  // Note Off
+    queueSlot(device, slotIndex(device, channel, SLOT_PITCH_BEND), value14 & 0x3FFF);
+    drain();
+    return true;
+}
 
-#ifdef ARDUINO_TEENSY40
-    sendMIDIMessage(device, status, note, 0);
-#endif
+bool MIDIEngine::sendProgramChange(uint8_t device, uint8_t channel, uint8_t program) {
+    return sendPriority(device, 0xC0 | (channel & 0x0F), program & 0x7F, 0);  // Program Change
+}
 
-    recordMessage();
-    return true;
+bool MIDIEngine::sendNoteOn(uint8_t device, uint8_t channel, uint8_t note, uint8_t velocity) {
+    return sendPriority(device, 0x90 | (channel & 0x0F), note & 0x7F, velocity & 0x7F);  // Note On
+}
+
+bool MIDIEngine::sendNoteOff(uint8_t device, uint8_t channel, uint8_t note) {
+    return sendPriority(device, 0x80 | (channel & 0x0F), note & 0x7F, 0);  // Note Off
 }
 
 bool MIDIEngine::sendAllNotesOff(uint8_t device, uint8_t channel) {
@@ -129,32 +236,43 @@ bool MIDIEngine::sendAllNotesOff(uint8_t device, uint8_t channel) {
     if (channel == 255) {
         // All channels
         for (uint8_t ch = 0; ch < 16; ch++) {
-            success &= sendCC(device, ch, 123, 0);  // CC 123 = All Notes Off
+            success &= sendPriority(device, 0xB0 | ch, 123, 0);  // CC 123 = All Notes Off
         }
     } else {
-        success = sendCC(device, channel, 123, 0);
+        success = sendPriority(device, 0xB0 | (channel & 0x0F), 123, 0);
     }
 
     return success;
 }
 
-bool MIDIEngine::processControl(const ControlConfig& config, uint8_t value) {
-    uint8_t device = config.currentBank == 0 ? config.virtualDevice : config.virtualDeviceB;
-    uint8_t channel = config.currentBank == 0 ? config.midiChannel : config.midiChannelB;
-    uint8_t ccNumber = config.currentBank == 0 ? config.ccNumber : config.ccNumberB;
-    uint8_t resolution = config.currentBank == 0 ? config.resolution : config.resolutionB;
+bool MIDIEngine::processControl(const ControlRoute& route, uint8_t value) {
+    // Value is already in [minValue, maxValue] (or a relative encoding).
+    // On the 14-bit scale the 7 bits repeat in the LSB so 127 reaches 16383.
+    return processControl14bit(route, ((uint16_t)value << 7) | value);
+}
+
+bool MIDIEngine::processControl14bit(const ControlRoute& route, uint16_t value14) {
+    if (route.status == 0) {
+        m_messagesDropped++;  // Device or CC out of range in the config
+        return false;
+    }
 
-    // Apply min/max range
-    uint8_t scaledValue = map(value, 0, 127, config.minValue, config.maxValue);
+    uint16_t slot = slotIndex(route.cable, route.status & 0x0F, route.data1);
 
-    if (resolution == 1) {
-        // 14-bit MIDI
-        uint16_t value14 = map(value, 0, 127, 0, 16383);
-        return sendCC14bit(device, channel, ccNumber, value14);
+    if (route.flags & ROUTE_FLAG_14BIT) {
+        // 14-bit MIDI: one slot for the pair (keyed on the MSB controller)
+        queueSlot(route.cable, slot, (value14 & 0x3FFF) | SLOT_14BIT);
+    } else if (route.flags & ROUTE_FLAG_RELATIVE_MASK) {
+        // Relative encoder: a delta, so coalescing must add rather than replace
+        uint8_t mode = (route.flags & ROUTE_FLAG_RELATIVE_MASK) >> ROUTE_RELATIVE_SHIFT;
+        queueRelative(route.cable, slot, mode, decodeRelative(mode, (value14 >> 7) & 0x7F));
     } else {
         // 7-bit MIDI
-        return sendCC(device, channel, ccNumber, scaledValue);
+        queueSlot(route.cable, slot, (value14 >> 7) & 0x7F);
     }
+
+    drain();
+    return true;
 }
 
 float MIDIEngine::getMessageRate() const {
@@ -166,17 +284,147 @@ float MIDIEngine::getMessageRate() const {
     return (m_messagesInPeriod * 1000.0f) / elapsed;
 }
 
-bool MIDIEngine::shouldThrottle() {
-    uint32_t currentTime = micros();
-    uint32_t elapsed = currentTime - m_lastMessageTime;
+void MIDIEngine::queueSlot(uint8_t device, uint16_t slot, uint16_t value) {
+    uint32_t mask = 1UL << (slot & 31);
+    uint32_t& word = m_pendingBits[slot >> 5];
+
+    if (word & mask) {
+        m_messagesCoalesced++;  // Older value never went out
+    } else {
+        word |= mask;
+        m_pendingCount++;
+        m_buckets[device].pending++;
+    }
 
-    return elapsed < MIN_MESSAGE_INTERVAL_US;
+    m_slotValues[slot] = value;
 }
 
-void MIDIEngine::recordMessage() {
-    m_messagesSent++;
-    m_messagesInPeriod++;
-    m_lastMessageTime = micros();
+void MIDIEngine::queueRelative(uint8_t device, uint16_t slot, uint8_t mode, int16_t delta) {
+    uint16_t tag = SLOT_RELATIVE | ((uint16_t)mode << RELATIVE_MODE_SHIFT);
+    uint16_t held = m_slotValues[slot];
+
+    // Sum with a pending delta of the same encoding; anything else is replaced
+    if ((m_pendingBits[slot >> 5] & (1UL << (slot & 31))) && (held & ~RELATIVE_DELTA_MASK) == tag) {
+        delta += (int16_t)(held & RELATIVE_DELTA_MASK) - RELATIVE_BIAS;
+    }
+    delta = constrain(delta, (int16_t)(1 - RELATIVE_BIAS), (int16_t)(RELATIVE_BIAS - 1));
+
+    queueSlot(device, slot, tag | (uint16_t)(delta + RELATIVE_BIAS));
+}
+
+uint16_t MIDIEngine::takePendingSlot(uint8_t device) {
+    // Caller guarantees pending > 0, so this finds a bit within one lap
+    DeviceBucket& bucket = m_buckets[device];
+    uint16_t base = device * DEVICE_WORDS;
+    uint16_t index = bucket.cursor >> 5;
+    uint32_t bits = m_pendingBits[base + index] & (0xFFFFFFFFUL << (bucket.cursor & 31));
+
+    while (bits == 0) {
+        index = (index + 1 < DEVICE_WORDS) ? index + 1 : 0;
+        bits = m_pendingBits[base + index];
+    }
+
+    uint16_t offset = (index << 5) + __builtin_ctz(bits);
+    m_pendingBits[base + index] &= ~(1UL << (offset & 31));
+    m_pendingCount--;
+    bucket.pending--;
+
+    bucket.cursor = (offset + 1 < DEVICE_SLOTS) ? offset + 1 : 0;
+    return device * DEVICE_SLOTS + offset;
+}
+
+uint8_t MIDIEngine::sendSlot(uint16_t slot) {
+    uint8_t device = slot / DEVICE_SLOTS;
+    uint16_t offset = slot % DEVICE_SLOTS;
+    uint8_t channel = offset / SLOTS_PER_CHANNEL;
+    uint8_t controller = offset % SLOTS_PER_CHANNEL;
+    uint16_t value = m_slotValues[slot];
+
+    if (controller == SLOT_PITCH_BEND) {
+#if defined(ARDUINO_TEENSY40) || defined(NATIVE_BUILD)
+        sendMIDIMessage(device, 0xE0 | channel, value & 0x7F, (value >> 7) & 0x7F);
+#endif
+        return 1;
+    }
+
+    uint8_t status = 0xB0 | channel;  // Control Change
+
+    if (value & SLOT_RELATIVE) {
+        uint8_t mode = (value >> RELATIVE_MODE_SHIFT) & 0x03;
+        int16_t delta = (int16_t)(value & RELATIVE_DELTA_MASK) - RELATIVE_BIAS;
+        if (delta == 0) {
+            return 0;  // Turns cancelled out
+        }
+
+        int16_t sent;
+        uint8_t data2 = encodeRelative(mode, delta, sent);
+#if defined(ARDUINO_TEENSY40) || defined(NATIVE_BUILD)
+        sendMIDIMessage(device, status, controller, data2);
+#endif
+        if (sent != delta) {
+            // Rest goes out on a later token
+            queueSlot(device, slot, (value & ~RELATIVE_DELTA_MASK) | (uint16_t)(delta - sent + RELATIVE_BIAS));
+        }
+        return 1;
+    }
+
+    if (value & SLOT_14BIT) {
+#if defined(ARDUINO_TEENSY40) || defined(NATIVE_BUILD)
+        sendMIDIMessage(device, status, controller, (value >> 7) & 0x7F);
+        sendMIDIMessage(device, status, controller + 32, value & 0x7F);  // LSB is +32
+#endif
+        return 2;
+    }
+
+#if defined(ARDUINO_TEENSY40) || defined(NATIVE_BUILD)
+    sendMIDIMessage(device, status, controller, (uint8_t)value);
+#endif
+    return 1;
+}
+
+void MIDIEngine::refillBucket(DeviceBucket& bucket, uint32_t now) {
+    uint32_t elapsed = now - bucket.lastRefill;
+    bucket.lastRefill = now;
+
+    int32_t full = (int32_t)bucket.burst * TOKEN;
+    if (elapsed >= bucket.fillTimeUs) {
+        bucket.tokens = full;
+        return;
+    }
+
+    bucket.tokens += (int32_t)(elapsed * bucket.ratePerSecond);
+    if (bucket.tokens > full) {
+        bucket.tokens = full;
+    }
+}
+
+bool MIDIEngine::sendPriority(uint8_t device, uint8_t status, uint8_t data1, uint8_t data2) {
+    if (device >= NUM_DEVICES) {
+        m_messagesDropped++;
+        return false;
+    }
+
+#if defined(ARDUINO_TEENSY40) || defined(NATIVE_BUILD)
+    sendMIDIMessage(device, status, data1, data2);
+#endif
+
+    refillBucket(m_buckets[device], micros());
+    recordMessages(device, 1);
+    return true;
+}
+
+void MIDIEngine::recordMessages(uint8_t device, uint8_t count) {
+    DeviceBucket& bucket = m_buckets[device];
+
+    // Priority sends may push the bucket into debt, but never past one burst
+    bucket.tokens -= (int32_t)count * TOKEN;
+    if (bucket.tokens < -(int32_t)bucket.burst * TOKEN) {
+        bucket.tokens = -(int32_t)bucket.burst * TOKEN;
+    }
+    bucket.messagesSent += count;
+
+    m_messagesSent += count;
+    m_messagesInPeriod += count;
 
     // Reset rate calculation every second
     if (millis() - m_lastRateCalcTime >= 1000) {
@@ -185,13 +433,24 @@ void MIDIEngine::recordMessage() {
     }
 }
 
-#ifdef ARDUINO_TEENSY40
+#if defined(ARDUINO_TEENSY40) || defined(NATIVE_BUILD)
 void MIDIEngine::sendMIDIMessage(uint8_t device, uint8_t status, uint8_t data1, uint8_t data2) {
-    // Teensy USB MIDI uses cable number 0-15, we use device number to route
-    usbMIDI.send(status, data1, data2, device + 1, 0);  // Cable = device + 1
-}
+    if (m_txCount == TX_BATCH_PACKETS) {
+        flush();
+    }
+    if (m_txCount == 0) {
+        m_txFirstTime = micros();
+    }
 
-void MIDIEngine::sendMIDIMessage(uint8_t device, uint8_t status, uint8_t data1) {
-    usbMIDI.send(status, data1, 0, device + 1, 0);
+    // USB-MIDI event packet: cable number routes to the virtual device,
+    // code index number = status high nibble for channel messages
+    m_txPackets[m_txCount++] = ((uint32_t)(device & 0x0F) << 4) | (status >> 4)
+                             | ((uint32_t)status << 8)
+                             | ((uint32_t)data1 << 16)
+                             | ((uint32_t)data2 << 24);
+
+    if (m_flushPolicy == MIDI_FLUSH_IMMEDIATE) {
+        flush();
+    }
 }
 #endif
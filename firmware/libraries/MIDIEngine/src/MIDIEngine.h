@@ -3,11 +3,21 @@
 
 #include <Arduino.h>
 #include <Protocol.h>
+#include <ControlRoute.h>
 
-#ifdef ARDUINO_TEENSY40
+#if defined(ARDUINO_TEENSY40) || defined(NATIVE_BUILD)
 #include <usb_midi.h>
 #endif
 
+/**
+ * When batched USB-MIDI packets are handed to the USB stack
+ */
+enum MIDIFlushPolicy : uint8_t {
+    MIDI_FLUSH_IMMEDIATE = 0,   // One USB transaction per message (lowest latency)
+    MIDI_FLUSH_LOOP = 1,        // Once per update() call (default)
+    MIDI_FLUSH_DEADLINE = 2     // When the oldest packet is older than the deadline
+};
+
 /**
  * MIDIEngine - MIDI Message Generation and Transmission
  *
@@ -20,7 +30,29 @@
  * - 14-bit high-resolution MIDI (CC pairs)
  * - Pitch bend (14-bit)
  * - Program change
- * - Message throttling (2,500 msg/sec)
+ * - Coalescing output scheduler with a token bucket per virtual device
+ *   (2,500 msg/sec, burst 8 by default)
+ *
+ * Output scheduling:
+ * CC and pitch bend messages are not sent directly. Each (device, channel,
+ * CC) and (device, channel) pitch bend has one slot holding the latest
+ * value; sending to a slot that is still waiting just replaces its value
+ * (last value wins). update() drains each device's pending slots
+ * round-robin while that device's bucket has tokens, so a fast sweep
+ * collapses to fewer messages but the final position is always sent, and
+ * a flood on one device never delays another.
+ *
+ * Priority messages (program change, notes, all notes off) are events, not
+ * positions: they skip the queue and go out immediately, then are charged
+ * to the device's bucket (it may go into debt, up to one burst), so the
+ * device's queued automation waits instead.
+ *
+ * USB batching:
+ * Messages become 4-byte USB-MIDI event packets (cable = virtual device)
+ * in a 16-packet batch (64 bytes, one full-speed bulk packet). The batch
+ * is handed to the USB stack and flushed as one transaction when it fills
+ * or per the flush policy, so a 14-bit pair or a panic sweep shares a
+ * transaction instead of using one each.
  *
  * Typical usage:
  *   MIDIEngine midi;
@@ -28,23 +60,62 @@
  *   midi.sendCC(virtualDevice, channel, ccNumber, value);
  *   midi.sendCC14bit(virtualDevice, channel, ccNumber, value14bit);
  *   midi.sendPitchBend(virtualDevice, channel, value14bit);
+ *
+ *   // Every loop iteration
+ *   midi.update();
  */
 class MIDIEngine {
 public:
+    static const uint8_t NUM_DEVICES = 4;
+
     MIDIEngine();
+    ~MIDIEngine();
 
     /**
      * Initialize MIDI engine
      */
     void begin();
 
+    /**
+     * Send pending CC / pitch bend slots that are due and apply the flush
+     * policy (call once per loop)
+     */
+    void update();
+
+    /**
+     * Set output rate for all virtual devices
+     * @param messagesPerSecond - Sustained messages per second per device (default 2,500)
+     */
+    void setMaxRate(uint32_t messagesPerSecond);
+
+    /**
+     * Set one virtual device's token bucket
+     * @param device - Virtual device (0-3)
+     * @param messagesPerSecond - Sustained rate (refill)
+     * @param burst - Messages that may go out back to back after idle (1-255)
+     * @return true if successful
+     */
+    bool setDeviceRate(uint8_t device, uint32_t messagesPerSecond, uint8_t burst);
+
+    /**
+     * Set when batched packets are flushed to USB
+     * @param policy - Flush policy
+     * @param deadlineUs - Maximum packet age for MIDI_FLUSH_DEADLINE
+     */
+    void setFlushPolicy(MIDIFlushPolicy policy, uint32_t deadlineUs = 1000);
+
+    /**
+     * Send batched packets now (one USB transaction)
+     */
+    void flush();
+
     /**
      * Send 7-bit Control Change
      * @param device - Virtual device (0-3)
      * @param channel - MIDI channel (0-15)
      * @param ccNumber - CC number (0-127)
      * @param value - CC value (0-127)
-     * @return true if sent successfully
+     * @return true if queued (replaces a pending value for the same CC)
      */
     bool sendCC(uint8_t device, uint8_t channel, uint8_t ccNumber, uint8_t value);
 
@@ -54,7 +125,7 @@ public:
      * @param channel - MIDI channel (0-15)
      * @param ccNumber - CC number (0-31, uses ccNumber and ccNumber+32)
      * @param value14 - 14-bit value (0-16383)
-     * @return true if sent successfully
+     * @return true if queued (MSB and LSB are sent together)
      */
     bool sendCC14bit(uint8_t device, uint8_t channel, uint8_t ccNumber, uint16_t value14);
 
@@ -63,7 +134,7 @@ public:
      * @param device - Virtual device (0-3)
      * @param channel - MIDI channel (0-15)
      * @param value14 - 14-bit value (0-16383, center=8192)
-     * @return true if sent successfully
+     * @return true if queued
      */
     bool sendPitchBend(uint8_t device, uint8_t channel, uint16_t value14);
 
@@ -72,7 +143,7 @@ public:
      * @param device - Virtual device (0-3)
      * @param channel - MIDI channel (0-15)
      * @param program - Program number (0-127)
-     * @return true if sent successfully
+     * @return true if sent successfully (priority, not queued)
      */
     bool sendProgramChange(uint8_t device, uint8_t channel, uint8_t program);
 
@@ -82,7 +153,7 @@ public:
      * @param channel - MIDI channel (0-15)
      * @param note - Note number (0-127)
      * @param velocity - Velocity (1-127, 0 = Note Off)
-     * @return true if sent successfully
+     * @return true if sent successfully (priority, not queued)
      */
     bool sendNoteOn(uint8_t device, uint8_t channel, uint8_t note, uint8_t velocity);
 
@@ -91,7 +162,7 @@ public:
      * @param device - Virtual device (0-3)
      * @param channel - MIDI channel (0-15)
      * @param note - Note number (0-127)
-     * @return true if sent successfully
+     * @return true if sent successfully (priority, not queued)
      */
     bool sendNoteOff(uint8_t device, uint8_t channel, uint8_t note);
 
@@ -99,43 +170,149 @@ public:
      * Send All Notes Off (panic)
      * @param device - Virtual device (0-3)
      * @param channel - MIDI channel (0-15, or 255 for all channels)
-     * @return true if sent successfully
+     * @return true if sent successfully (priority, not queued)
      */
     bool sendAllNotesOff(uint8_t device, uint8_t channel = 255);
 
     /**
      * Process control event and send appropriate MIDI message
-     * @param config - Control configuration
-     * @param value - Control value
-     * @return true if MIDI sent
+     * @param route - Compiled routing (StateManager::getRoute())
+     * @param value - MIDI data byte (from ValueEngine, sent as-is)
+     * @return true if MIDI queued
      */
-    bool processControl(const ControlConfig& config, uint8_t value);
+    bool processControl(const ControlRoute& route, uint8_t value);
+
+    /**
+     * Process a 14-bit control value (7-bit routes send the top 7 bits)
+     * @param route - Compiled routing
+     * @param value14 - 14-bit value (0-16383)
+     * @return true if MIDI queued
+     */
+    bool processControl14bit(const ControlRoute& route, uint16_t value14);
 
     /**
      * Get MIDI message statistics
      */
     uint32_t getMessagesSent() const { return m_messagesSent; }
-    uint32_t getMessagesDropped() const { return m_messagesDropped; }
+    uint32_t getMessagesCoalesced() const { return m_messagesCoalesced; }  // Replaced before sending
+    uint32_t getMessagesDropped() const { return m_messagesDropped; }      // Invalid device / CC
+    uint16_t getPendingCount() const { return m_pendingCount; }
+    uint16_t getDevicePendingCount(uint8_t device) const;
+    uint32_t getDeviceMessagesSent(uint8_t device) const;
+    uint32_t getUsbPackets() const { return m_usbPackets; }
+    uint32_t getUsbTransactions() const { return m_usbTransactions; }
     float getMessageRate() const;  // Messages per second
 
 private:
     uint32_t m_messagesSent;
+    uint32_t m_messagesCoalesced;
     uint32_t m_messagesDropped;
     uint32_t m_lastRateCalcTime;
     uint32_t m_messagesInPeriod;
 
-    // Throttling (max 2,500 messages/second)
+    // Token buckets (default 2,500 messages/second, burst 8, per device)
     static const uint32_t MAX_MESSAGES_PER_SECOND = 2500;
-    static const uint32_t MIN_MESSAGE_INTERVAL_US = 400;  // 1000000 / 2500
-    uint32_t m_lastMessageTime;
+    static const uint8_t DEFAULT_BURST = 8;
+    static const int32_t TOKEN = 1000000;        // One message; refill adds rate per us
+
+    struct DeviceBucket {
+        int32_t tokens;                 // TOKEN units, may be negative after priority sends
+        uint32_t ratePerSecond;
+        uint32_t fillTimeUs;            // Time from empty debt to a full bucket
+        uint32_t lastRefill;            // micros()
+        uint32_t messagesSent;
+        uint16_t pending;               // Pending slots for this device
+        uint16_t cursor;                // Next slot to consider (round-robin)
+        uint8_t burst;
+    };
+
+    DeviceBucket m_buckets[NUM_DEVICES];
 
-    bool shouldThrottle();
-    void recordMessage();
+    // Coalescing slots: per device and channel, CC 0-127 then pitch bend.
+    // Each device's range is padded to whole bitmap words.
+    static const uint16_t SLOTS_PER_CHANNEL = 129;
+    static const uint16_t SLOT_PITCH_BEND = 128;
+    static const uint16_t DEVICE_WORDS = (16 * SLOTS_PER_CHANNEL + 31) / 32;
+    static const uint16_t DEVICE_SLOTS = DEVICE_WORDS * 32;
+    static const uint16_t NUM_SLOTS = NUM_DEVICES * DEVICE_SLOTS;
+    static const uint16_t PENDING_WORDS = NUM_DEVICES * DEVICE_WORDS;
+    static const uint16_t SLOT_14BIT = 0x8000;   // Value flag: send as MSB/LSB pair
+
+    // Relative slots hold the summed delta (biased, bits 0-11) and the
+    // EncoderMode (bits 12-13) it is re-encoded in when sent
+    static const uint16_t SLOT_RELATIVE = 0x4000;
+    static const uint8_t RELATIVE_MODE_SHIFT = 12;
+    static const uint16_t RELATIVE_DELTA_MASK = 0x0FFF;
+    static const int16_t RELATIVE_BIAS = 2048;
+
+    uint16_t* m_slotValues;             // Latest value per slot
+    uint32_t* m_pendingBits;            // 1 bit per slot
+    uint16_t m_pendingCount;
+
+    // USB-MIDI packet batch
+    static const uint8_t TX_BATCH_PACKETS = 16;
+    uint32_t m_txPackets[TX_BATCH_PACKETS];
+    uint8_t m_txCount;
+    uint32_t m_txFirstTime;             // micros() of the oldest batched packet
+    MIDIFlushPolicy m_flushPolicy;
+    uint32_t m_flushDeadlineUs;
+    uint32_t m_usbPackets;
+    uint32_t m_usbTransactions;
+
+    /**
+     * Slot index for a device, channel and controller (or SLOT_PITCH_BEND)
+     */
+    static uint16_t slotIndex(uint8_t device, uint8_t channel, uint8_t controller) {
+        return device * DEVICE_SLOTS + (channel & 0x0F) * SLOTS_PER_CHANNEL + controller;
+    }
+
+    /**
+     * Store the latest value for a slot and mark it pending
+     */
+    void queueSlot(uint8_t device, uint16_t slot, uint16_t value);
+
+    /**
+     * Add a relative encoder delta to a slot (summed while pending)
+     * @param mode - ENCODER_RELATIVE_1/2/3
+     */
+    void queueRelative(uint8_t device, uint16_t slot, uint8_t mode, int16_t delta);
+
+    /**
+     * Take a device's next pending slot at or after its cursor
+     */
+    uint16_t takePendingSlot(uint8_t device);
+
+    /**
+     * Send a slot's value (0-2 messages). A relative delta beyond one
+     * message's range leaves the remainder pending.
+     * @return Number of messages sent
+     */
+    uint8_t sendSlot(uint16_t slot);
+
+    /**
+     * Send pending slots each device's bucket allows (batched, not flushed;
+     * the flush policy is applied by update() only)
+     */
+    void drain();
+
+    /**
+     * Add tokens for the time since the last refill
+     */
+    void refillBucket(DeviceBucket& bucket, uint32_t now);
+
+    /**
+     * Send a priority message now and charge it to the device's bucket
+     */
+    bool sendPriority(uint8_t device, uint8_t status, uint8_t data1, uint8_t data2);
+
+    /**
+     * Account for messages sent on a device
+     */
+    void recordMessages(uint8_t device, uint8_t count);
 
-#ifdef ARDUINO_TEENSY40
-    // Teensy-specific MIDI sending
+#if defined(ARDUINO_TEENSY40) || defined(NATIVE_BUILD)
+    // Teensy-specific MIDI sending (into the USB packet batch)
     void sendMIDIMessage(uint8_t device, uint8_t status, uint8_t data1, uint8_t data2);
-    void sendMIDIMessage(uint8_t device, uint8_t status, uint8_t data1);
 #endif
 };
 
@@ -1,14 +1,40 @@
 #include "MultiI2CMaster.h"
+#include <CRC32.h>
+#include <ControlMap.h>
 
-#if defined(__IMXRT1062__)  // Teensy 4.0/4.1
+#if defined(__IMXRT1062__) || defined(NATIVE_BUILD)  // Teensy 4.0/4.1 (or host build)
+
+MultiI2CMaster* MultiI2CMaster::s_instance = nullptr;
+
+void (* const MultiI2CMaster::s_eventPinHandlers[NUM_SLAVES])() = {
+    onEventPin<0>, onEventPin<1>, onEventPin<2>,
+    onEventPin<3>, onEventPin<4>, onEventPin<5>,
+    onEventPin<6>, onEventPin<7>, onEventPin<8>
+};
 
 MultiI2CMaster::MultiI2CMaster()
-    : m_queueHead(0)
+    : m_async{{Wire, 0}, {Wire1, 1}, {Wire2, 2}}
+    , m_queueHead(0)
     , m_queueTail(0)
     , m_lastPollTime(0)
-    , m_currentSlave(0)
+    , m_pollCount(0)
+    , m_pendingMask(0)
+    , m_sharedEventPin(-1)
+    , m_sharedMask(0)
+    , m_pollIntervalUs(0)
 {
+    s_instance = this;
     initSlaves();
+
+    for (uint8_t i = 0; i < NUM_SLAVES; i++) {
+        m_eventPins[i] = -1;
+    }
+
+    for (uint8_t b = 0; b < NUM_BUSES; b++) {
+        memset(&m_buses[b], 0, sizeof(BusState));
+        m_buses[b].firstSlave = b * SLAVES_PER_BUS;
+        m_buses[b].phase = BUS_IDLE;
+    }
 }
 
 bool MultiI2CMaster::begin(uint32_t clockSpeed) {
@@ -24,41 +50,71 @@ bool MultiI2CMaster::begin(uint32_t clockSpeed) {
     Wire2.begin();
     Wire2.setClock(clockSpeed);
 
-    // Health check all slaves
+    // Health check all slaves (blocking, before the async engines start)
     for (uint8_t i = 0; i < NUM_SLAVES; i++) {
         m_slaves[i].healthy = pingSlave(i);
     }
 
-    return true;
-}
+    // Hand transfers over to the interrupt-driven engines
+    bool success = true;
+    for (uint8_t b = 0; b < NUM_BUSES; b++) {
+        success &= m_async[b].begin();
+    }
 
-void MultiI2CMaster::attachInterrupt(int pin, void (*handler)()) {
-    pinMode(pin, INPUT);
-    ::attachInterrupt(digitalPinToInterrupt(pin), handler, RISING);
+    return success;
 }
 
-void MultiI2CMaster::poll() {
-    uint32_t currentTime = micros();
+bool MultiI2CMaster::setEventPin(uint8_t address, int pin) {
+    int8_t slaveIndex = findSlave(address);
+    if (slaveIndex < 0 || pin < 0) {
+        return false;
+    }
 
-    // Poll next slave in round-robin
-    bool success = pollSlave(m_currentSlave);
+    m_eventPins[slaveIndex] = pin;
+    m_sharedMask &= ~(1 << slaveIndex);
 
-    if (!success) {
-        m_slaves[m_currentSlave].failCount++;
-        if (m_slaves[m_currentSlave].failCount > 10) {
-            m_slaves[m_currentSlave].healthy = false;
+    pinMode(pin, INPUT_PULLDOWN);  // Absent panel reads idle
+    ::attachInterrupt(digitalPinToInterrupt(pin), s_eventPinHandlers[slaveIndex], RISING);
+
+    // Line may already be high (no edge will come)
+    if (digitalRead(pin)) {
+        setPending(slaveIndex);
+    }
+    return true;
+}
+
+void MultiI2CMaster::setSharedEventPin(int pin) {
+    m_sharedEventPin = pin;
+
+    m_sharedMask = 0;
+    for (uint8_t i = 0; i < NUM_SLAVES; i++) {
+        if (m_eventPins[i] < 0) {
+            m_sharedMask |= (1 << i);
         }
-    } else {
-        m_slaves[m_currentSlave].failCount = 0;
-        m_slaves[m_currentSlave].healthy = true;
     }
 
-    m_slaves[m_currentSlave].lastPollTime = currentTime;
+    pinMode(pin, INPUT_PULLDOWN);
+    ::attachInterrupt(digitalPinToInterrupt(pin), onSharedEventPin, RISING);
 
-    // Move to next slave
-    m_currentSlave = (m_currentSlave + 1) % NUM_SLAVES;
+    if (digitalRead(pin)) {
+        noInterrupts();
+        m_pendingMask |= m_sharedMask;
+        interrupts();
+    }
+}
 
-    m_lastPollTime = currentTime;
+void MultiI2CMaster::setPollInterval(uint32_t intervalUs) {
+    m_pollIntervalUs = intervalUs;
+}
+
+void MultiI2CMaster::poll() {
+    // Each bus advances independently: a slow or busy slave on one bus
+    // never holds up the other two
+    for (uint8_t b = 0; b < NUM_BUSES; b++) {
+        serviceBus(b, true);
+    }
+
+    m_lastPollTime = micros();
 }
 
 bool MultiI2CMaster::getEvent(EventMessage& event) {
@@ -80,11 +136,15 @@ uint16_t MultiI2CMaster::getQueuedEventCount() const {
 }
 
 bool MultiI2CMaster::sendCommand(uint8_t address, I2CCommand command, const uint8_t* data, uint8_t dataLen) {
-    TwoWire* wire = getWireForSlave(address);
-    if (!wire) {
+    int8_t slaveIndex = findSlave(address);
+    if (slaveIndex < 0) {
         return false;
     }
 
+    // Blocking Wire transfer: let the bus's async poll finish first
+    waitForBus(slaveIndex / SLAVES_PER_BUS);
+    TwoWire* wire = m_slaves[slaveIndex].wire;
+
     wire->beginTransmission(address);
     wire->write((uint8_t)command);
 
@@ -97,15 +157,7 @@ bool MultiI2CMaster::sendCommand(uint8_t address, I2CCommand command, const uint
 }
 
 bool MultiI2CMaster::getSlaveStatus(uint8_t address, DiagnosticMetrics& status) {
-    // Find slave index
-    int8_t slaveIndex = -1;
-    for (uint8_t i = 0; i < NUM_SLAVES; i++) {
-        if (m_slaves[i].address == address) {
-            slaveIndex = i;
-            break;
-        }
-    }
-
+    int8_t slaveIndex = findSlave(address);
     if (slaveIndex < 0) {
         return false;
     }
@@ -139,75 +191,259 @@ SystemStatus MultiI2CMaster::getSystemStatus() {
 }
 
 bool MultiI2CMaster::resetSlave(uint8_t address) {
-    return sendCommand(address, CMD_RESET);
+    if (!sendCommand(address, CMD_RESET)) {
+        return false;
+    }
+
+    // Slave restarts its sequence numbers
+    for (uint8_t i = 0; i < NUM_SLAVES; i++) {
+        if (m_slaves[i].address == address) {
+            m_slaves[i].link.haveSequence = false;
+        }
+    }
+    return true;
+}
+
+bool MultiI2CMaster::getLinkStats(uint8_t address, I2CLinkStats& stats) {
+    for (uint8_t i = 0; i < NUM_SLAVES; i++) {
+        if (m_slaves[i].address == address) {
+            stats = m_slaves[i].link;
+            return true;
+        }
+    }
+    return false;
 }
 
 void MultiI2CMaster::initSlaves() {
     // Bus 0 (Wire): ESP32 #1, #2, #3 (Synth panels)
-    m_slaves[0] = {0x08, &Wire, false, 0, 0, {}};
-    m_slaves[1] = {0x09, &Wire, false, 0, 0, {}};
-    m_slaves[2] = {0x0A, &Wire, false, 0, 0, {}};
+    m_slaves[0] = {0x08, &Wire, false, 0, 0, {}, {}};
+    m_slaves[1] = {0x09, &Wire, false, 0, 0, {}, {}};
+    m_slaves[2] = {0x0A, &Wire, false, 0, 0, {}, {}};
 
     // Bus 1 (Wire1): ESP32 #4, #5, #6 (Synth panels)
-    m_slaves[3] = {0x0B, &Wire1, false, 0, 0, {}};
-    m_slaves[4] = {0x0C, &Wire1, false, 0, 0, {}};
-    m_slaves[5] = {0x0D, &Wire1, false, 0, 0, {}};
+    m_slaves[3] = {0x0B, &Wire1, false, 0, 0, {}, {}};
+    m_slaves[4] = {0x0C, &Wire1, false, 0, 0, {}, {}};
+    m_slaves[5] = {0x0D, &Wire1, false, 0, 0, {}, {}};
 
     // Bus 2 (Wire2): ESP32 #7, #8, #9 (Synth #7-8, FX #9)
-    m_slaves[6] = {0x0E, &Wire2, false, 0, 0, {}};
-    m_slaves[7] = {0x0F, &Wire2, false, 0, 0, {}};
-    m_slaves[8] = {0x10, &Wire2, false, 0, 0, {}};
+    m_slaves[6] = {0x0E, &Wire2, false, 0, 0, {}, {}};
+    m_slaves[7] = {0x0F, &Wire2, false, 0, 0, {}, {}};
+    m_slaves[8] = {0x10, &Wire2, false, 0, 0, {}, {}};
 }
 
-TwoWire* MultiI2CMaster::getWireForSlave(uint8_t address) {
-    for (uint8_t i = 0; i < NUM_SLAVES; i++) {
-        if (m_slaves[i].address == address) {
-            return m_slaves[i].wire;
+void MultiI2CMaster::serviceBus(uint8_t busIndex, bool startNext) {
+    BusState& bus = m_buses[busIndex];
+    AsyncI2CBus& async = m_async[busIndex];
+
+    if (bus.phase != BUS_IDLE) {
+        AsyncI2CStatus status = async.getStatus();
+        if (status == ASYNC_I2C_BUSY) {
+            return;  // Still on the wire
         }
+        advanceBus(bus, status == ASYNC_I2C_DONE);
     }
-    return nullptr;
-}
 
-bool MultiI2CMaster::pollSlave(uint8_t slaveIndex) {
-    if (slaveIndex >= NUM_SLAVES) {
-        return false;
+    if (bus.phase != BUS_IDLE || !startNext) {
+        return;
+    }
+
+    // Start polling the slave that needs it most; nothing pending = bus idle
+    int8_t slaveIndex = selectSlave(bus);
+    if (slaveIndex < 0) {
+        return;
     }
 
-    return readEventsFromSlave(slaveIndex);
+    bus.slaveIndex = slaveIndex;
+    bus.command = CMD_GET_EVENTS;
+
+    if (async.startWrite(m_slaves[slaveIndex].address, &bus.command, 1)) {
+        clearPending(slaveIndex);
+        bus.phase = BUS_COMMAND;
+        m_pollCount++;
+    }
 }
 
-bool MultiI2CMaster::readEventsFromSlave(uint8_t slaveIndex) {
-    SlaveInfo& slave = m_slaves[slaveIndex];
+void MultiI2CMaster::advanceBus(BusState& bus, bool transferOk) {
+    SlaveInfo& slave = m_slaves[bus.slaveIndex];
+    AsyncI2CBus& async = m_async[bus.firstSlave / SLAVES_PER_BUS];
+    BatchEventMessage& batch = bus.batch;
 
-    // Send GET_EVENTS command
-    slave.wire->beginTransmission(slave.address);
-    slave.wire->write((uint8_t)CMD_GET_EVENTS);
-    uint8_t result = slave.wire->endTransmission();
+    if (!transferOk) {
+        finishSlave(bus, false);
+        return;
+    }
 
-    if (result != 0) {
-        return false;
+    switch (bus.phase) {
+        case BUS_COMMAND:
+            // Phase 1: batch header (numEvents, sequence, backlog)
+            if (async.startRead(slave.address, (uint8_t*)&batch, BATCH_HEADER_SIZE)) {
+                bus.phase = BUS_HEADER;
+            } else {
+                finishSlave(bus, false);
+            }
+            break;
+
+        case BUS_HEADER: {
+            slave.link.bytesRead += BATCH_HEADER_SIZE;
+
+            if (batch.numEvents > MAX_EVENTS_PER_BATCH) {
+                slave.link.checksumErrors++;  // Corrupt header
+                finishSlave(bus, false);
+                break;
+            }
+
+            slave.link.backlog = batch.backlog;
+
+            // Idle poll ends here
+            if (batch.numEvents == 0) {
+                trackBatchSequence(slave.link, batch);
+                finishSlave(bus, true);
+                break;
+            }
+
+            // Phase 2: exactly the events in this batch, then CRC32. The
+            // checksum lands right after the last event in the buffer.
+            if (async.startRead(slave.address, (uint8_t*)batch.events, batchPayloadSize(batch.numEvents))) {
+                bus.phase = BUS_PAYLOAD;
+            } else {
+                finishSlave(bus, false);
+            }
+            break;
+        }
+
+        case BUS_PAYLOAD: {
+            slave.link.bytesRead += batchPayloadSize(batch.numEvents);
+
+            size_t eventBytes = batch.numEvents * sizeof(EventMessage);
+            uint32_t checksum;
+            memcpy(&checksum, (const uint8_t*)batch.events + eventBytes, sizeof(checksum));
+
+            if (CRC32::calculate(&batch, BATCH_HEADER_SIZE + eventBytes) != checksum) {
+                slave.link.checksumErrors++;
+                finishSlave(bus, false);
+                break;
+            }
+
+            // Duplicates were already queued
+            if (trackBatchSequence(slave.link, batch)) {
+                uint8_t panel = panelForAddress(slave.address);
+
+                for (uint8_t i = 0; i < batch.numEvents; i++) {
+                    // Panels send local IDs; translate once, here
+                    EventMessage& event = batch.events[i];
+                    uint16_t globalID = mapControlID(panel, event.globalID);
+                    if (globalID == CONTROL_MAP_INVALID) {
+                        slave.link.unmappedEvents++;
+                        continue;
+                    }
+
+                    event.globalID = globalID;
+                    queueEvent(event);
+                }
+            }
+
+            finishSlave(bus, true);
+            break;
+        }
+
+        default:
+            break;
     }
+}
 
-    // Request event data
-    uint8_t bytesReceived = slave.wire->requestFrom(slave.address, (uint8_t)49);  // 1 + 6*8 bytes max
+void MultiI2CMaster::finishSlave(BusState& bus, bool success) {
+    SlaveInfo& slave = m_slaves[bus.slaveIndex];
 
-    if (bytesReceived == 0) {
-        return false;
+    if (!success) {
+        slave.failCount++;
+        if (slave.failCount > 10) {
+            slave.healthy = false;
+        }
+    } else {
+        slave.failCount = 0;
+        slave.healthy = true;
     }
 
-    // Read event count
-    uint8_t numEvents = slave.wire->read();
+    slave.lastPollTime = micros();
+    bus.phase = BUS_IDLE;
+
+    // Come straight back if the slave reported more queued events or its
+    // line is still high (the edge that would re-flag it already happened)
+    int pin = m_eventPins[bus.slaveIndex];
+    if (success && (slave.link.backlog > 0 || (pin >= 0 && digitalRead(pin)))) {
+        setPending(bus.slaveIndex);
+    }
+
+    // A shared line still high after this slave is served may be held by
+    // another panel that raised it too late for an edge; which one is not
+    // known, so flag them all again
+    if (success && (m_sharedMask & (1 << bus.slaveIndex)) && digitalRead(m_sharedEventPin)) {
+        noInterrupts();
+        m_pendingMask |= m_sharedMask;
+        interrupts();
+    }
+}
 
-    // Read events
-    for (uint8_t i = 0; i < numEvents && i < 6; i++) {
-        if (slave.wire->available() >= sizeof(EventMessage)) {
-            EventMessage event;
-            slave.wire->readBytes((uint8_t*)&event, sizeof(EventMessage));
-            queueEvent(event);
+int8_t MultiI2CMaster::selectSlave(const BusState& bus) {
+    uint32_t now = micros();
+    uint16_t pending = m_pendingMask;
+    int8_t best = -1;
+
+    for (uint8_t i = bus.firstSlave; i < bus.firstSlave + SLAVES_PER_BUS; i++) {
+        const SlaveInfo& slave = m_slaves[i];
+
+        // Slaves with a line are polled on demand (plus a slow safety
+        // poll); slaves without one on the poll interval
+        bool hasLine = m_eventPins[i] >= 0 || (m_sharedMask & (1 << i));
+        uint32_t interval = hasLine ? SAFETY_POLL_INTERVAL_US : m_pollIntervalUs;
+        bool due = (pending & (1 << i)) || (now - slave.lastPollTime >= interval);
+        if (!due) {
+            continue;
+        }
+
+        if (best < 0 ||
+            slave.link.backlog > m_slaves[best].link.backlog ||
+            (slave.link.backlog == m_slaves[best].link.backlog &&
+             now - slave.lastPollTime > now - m_slaves[best].lastPollTime)) {
+            best = i;
         }
     }
 
-    return true;
+    return best;
+}
+
+void MultiI2CMaster::setPending(uint8_t slaveIndex) {
+    noInterrupts();
+    m_pendingMask |= (1 << slaveIndex);
+    interrupts();
+}
+
+void MultiI2CMaster::clearPending(uint8_t slaveIndex) {
+    noInterrupts();
+    m_pendingMask &= ~(1 << slaveIndex);
+    interrupts();
+}
+
+void MultiI2CMaster::onSharedEventPin() {
+    if (s_instance) {
+        s_instance->m_pendingMask |= s_instance->m_sharedMask;
+    }
+}
+
+void MultiI2CMaster::waitForBus(uint8_t busIndex) {
+    // Every transfer ends in DONE, an error or the AsyncI2CBus timeout
+    while (m_buses[busIndex].phase != BUS_IDLE) {
+        serviceBus(busIndex, false);
+    }
+}
+
+int8_t MultiI2CMaster::findSlave(uint8_t address) const {
+    for (uint8_t i = 0; i < NUM_SLAVES; i++) {
+        if (m_slaves[i].address == address) {
+            return i;
+        }
+    }
+    return -1;
 }
 
 bool MultiI2CMaster::queueEvent(const EventMessage& event) {
@@ -228,6 +464,7 @@ bool MultiI2CMaster::pingSlave(uint8_t slaveIndex) {
     }
 
     SlaveInfo& slave = m_slaves[slaveIndex];
+    waitForBus(slaveIndex / SLAVES_PER_BUS);
 
     slave.wire->beginTransmission(slave.address);
     slave.wire->write((uint8_t)CMD_PING);
@@ -236,4 +473,4 @@ bool MultiI2CMaster::pingSlave(uint8_t slaveIndex) {
     return result == 0;
 }
 
-#endif // Teensy 4.0
+#endif // Teensy 4.0 || NATIVE_BUILD
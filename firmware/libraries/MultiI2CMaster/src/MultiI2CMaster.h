@@ -4,33 +4,51 @@
 #include <Arduino.h>
 #include <Protocol.h>
 
-#if defined(__IMXRT1062__)  // Teensy 4.0/4.1
+#if defined(__IMXRT1062__) || defined(NATIVE_BUILD)  // Teensy 4.0/4.1 (or host build)
 #include <Wire.h>
+#include <AsyncI2C.h>
 
 /**
  * MultiI2CMaster - Teensy 4.0 Multi-Bus I2C Master
  *
  * Manages 3 parallel I2C buses for distributed ESP32 communication.
- * Uses interrupt-driven polling for sub-500µs latency.
+ * Each bus runs its own non-blocking poll state machine on an AsyncI2CBus,
+ * so one transfer is in flight on every bus at once and events from the
+ * three buses are merged into the global queue as each batch completes.
  *
  * Bus Assignment (32-Encoder Panel Design):
  * - Bus 0 (Wire): ESP32 #1 (0x08), #2 (0x09), #3 (0x0A)
  * - Bus 1 (Wire1): ESP32 #4 (0x0B), #5 (0x0C), #6 (0x0D)
  * - Bus 2 (Wire2): ESP32 #7 (0x0E), #8 (0x0F), #9 (0x10)
  *
+ * Ready lines:
+ * Each ESP32 drives its event pin high while it has events queued. With a
+ * line per panel (setEventPin()) the pin ISR only sets that slave's bit in
+ * a pending mask; poll() then services exactly the pending slaves, busiest
+ * (largest reported backlog) first, so idle panels cost no bus time. A
+ * single shared line (setSharedEventPin()) marks every slave without its
+ * own line as pending. Slaves with a line still get a slow safety poll for
+ * health monitoring and missed edges; slaves with no line at all are polled
+ * every setPollInterval() microseconds (default: back to back).
+ *
  * Features:
  * - 3 parallel I2C buses (1MHz Fast Mode+)
- * - Interrupt-driven event polling
+ * - Interrupt-driven transfers, one outstanding per bus (poll() never blocks)
+ * - Per-slave ready lines, pending bitmask, backlog-priority servicing
  * - Event batching (up to 6 events per slave)
+ * - Header-first batch reads (idle poll = 4 bytes), CRC32 check,
+ *   lost/duplicate batch detection from sequence numbers
+ * - Panel-local control IDs mapped to global IDs (ControlMap.h) as
+ *   batches arrive, so getEvent() always returns global IDs
  * - Health monitoring
  * - Automatic retry on failure
  *
  * Typical usage:
  *   MultiI2CMaster master;
  *   master.begin();
- *   master.attachInterrupt(eventPin, []() { master.handleInterrupt(); });
+ *   master.setEventPin(0x08, 3);   // one per panel
  *
- *   // In loop:
+ *   // In loop (returns immediately; advances each bus's transfer):
  *   master.poll();
  *   EventMessage event;
  *   if (master.getEvent(event)) { ... }
@@ -50,15 +68,40 @@ public:
     bool begin(uint32_t clockSpeed = 1000000);
 
     /**
-     * Attach interrupt handler for event pins
-     * @param pin - Event interrupt pin
-     * @param handler - Interrupt handler function
+     * Assign a ready line to one slave (rising edge = events queued)
+     * @param address - Slave address (0x08 to 0x10)
+     * @param pin - Teensy input pin wired to the slave's event pin
+     * @return true if slave found
+     */
+    bool setEventPin(uint8_t address, int pin);
+
+    /**
+     * Assign a ready line shared by all slaves without their own line
+     * @param pin - Teensy input pin (wired-OR of the slaves' event pins)
+     */
+    void setSharedEventPin(int pin);
+
+    /**
+     * Set poll interval for slaves without any ready line
+     * @param intervalUs - Microseconds between polls (0 = back to back)
+     */
+    void setPollInterval(uint32_t intervalUs);
+
+    /**
+     * Get slaves flagged by their ready line and not yet serviced
+     * (bit n = slave address 0x08 + n)
      */
-    void attachInterrupt(int pin, void (*handler)());
+    uint16_t getPendingMask() const { return m_pendingMask; }
 
     /**
-     * Poll all slaves for events
-     * Call this regularly in loop() or from interrupt
+     * Get number of slave polls started (all buses)
+     */
+    uint32_t getPollCount() const { return m_pollCount; }
+
+    /**
+     * Advance the poll state machine of every bus: collect finished
+     * transfers, queue their events and start the next transfer.
+     * Non-blocking - call as often as possible from loop() (not from an ISR)
      */
     void poll();
 
@@ -111,6 +154,14 @@ public:
      */
     bool resetSlave(uint8_t address);
 
+    /**
+     * Get batch link statistics for a slave
+     * @param address - Slave address
+     * @param stats - Output parameter for statistics
+     * @return true if slave found
+     */
+    bool getLinkStats(uint8_t address, I2CLinkStats& stats);
+
 private:
     struct SlaveInfo {
         uint8_t address;
@@ -119,18 +170,76 @@ private:
         uint32_t lastPollTime;
         uint32_t failCount;
         DiagnosticMetrics metrics;
+        I2CLinkStats link;
+    };
+
+    /**
+     * Per-bus poll phase (each phase is one I2C transfer)
+     */
+    enum BusPhase : uint8_t {
+        BUS_IDLE = 0,       // No transfer in flight
+        BUS_COMMAND,        // Writing CMD_GET_EVENTS
+        BUS_HEADER,         // Reading the 4-byte batch header
+        BUS_PAYLOAD         // Reading events + CRC32
+    };
+
+    struct BusState {
+        uint8_t firstSlave;         // Index of the bus's first slave in m_slaves
+        uint8_t slaveIndex;         // Slave being polled
+        BusPhase phase;
+        uint8_t command;            // Transmit buffer for the command phase
+        BatchEventMessage batch;    // Receive buffer for header + payload
     };
 
     static const uint8_t NUM_SLAVES = 9;  // 8 synth panels + 1 FX panel (snapshot via separate interface)
+    static const uint8_t NUM_BUSES = 3;
+    static const uint8_t SLAVES_PER_BUS = NUM_SLAVES / NUM_BUSES;
     static const uint16_t EVENT_QUEUE_SIZE = 256;
+    static const uint32_t SAFETY_POLL_INTERVAL_US = 50000;  // Slaves with a ready line
 
     SlaveInfo m_slaves[NUM_SLAVES];
+    AsyncI2CBus m_async[NUM_BUSES];
+    BusState m_buses[NUM_BUSES];
     EventMessage m_eventQueue[EVENT_QUEUE_SIZE];
     volatile uint16_t m_queueHead;
     volatile uint16_t m_queueTail;
 
     uint32_t m_lastPollTime;
-    uint8_t m_currentSlave;
+    uint32_t m_pollCount;
+
+    // Ready lines (pending bits are set from pin ISRs)
+    volatile uint16_t m_pendingMask;
+    int m_eventPins[NUM_SLAVES];
+    int m_sharedEventPin;
+    uint16_t m_sharedMask;          // Slaves covered by the shared line
+    uint32_t m_pollIntervalUs;
+
+    static MultiI2CMaster* s_instance;
+    static void (* const s_eventPinHandlers[NUM_SLAVES])();
+
+    /**
+     * Ready-line ISRs (static for ISR compatibility; one per slave)
+     */
+    template<uint8_t N>
+    static void onEventPin() {
+        if (s_instance) {
+            s_instance->m_pendingMask |= (1 << N);
+        }
+    }
+    static void onSharedEventPin();
+
+    /**
+     * Set/clear a pending bit from task context
+     */
+    void setPending(uint8_t slaveIndex);
+    void clearPending(uint8_t slaveIndex);
+
+    /**
+     * Pick the next slave to poll on a bus: pending or due slaves,
+     * largest backlog first, then least recently polled
+     * @return slave index, or -1 if nothing needs the bus
+     */
+    int8_t selectSlave(const BusState& bus);
 
     /**
      * Initialize slave info
@@ -138,19 +247,32 @@ private:
     void initSlaves();
 
     /**
-     * Get Wire interface for slave address
+     * Advance one bus: handle a finished transfer, then (optionally)
+     * start polling the bus's next slave
+     * @param busIndex - Bus to service
+     * @param startNext - false to only finish the slave in progress
+     */
+    void serviceBus(uint8_t busIndex, bool startNext);
+
+    /**
+     * Handle the completed transfer of the current phase and start the next
+     */
+    void advanceBus(BusState& bus, bool transferOk);
+
+    /**
+     * End the current slave's poll and update its health
      */
-    TwoWire* getWireForSlave(uint8_t address);
+    void finishSlave(BusState& bus, bool success);
 
     /**
-     * Poll specific slave
+     * Run a bus's poll in progress to completion (before blocking Wire use)
      */
-    bool pollSlave(uint8_t slaveIndex);
+    void waitForBus(uint8_t busIndex);
 
     /**
-     * Read events from slave
+     * Find slave index by address (-1 if unknown)
      */
-    bool readEventsFromSlave(uint8_t slaveIndex);
+    int8_t findSlave(uint8_t address) const;
 
     /**
      * Queue event to global queue
@@ -163,5 +285,5 @@ private:
     bool pingSlave(uint8_t slaveIndex);
 };
 
-#endif // Teensy 4.0
+#endif // Teensy 4.0 || NATIVE_BUILD
 #endif // MULTI_I2C_MASTER_H
@@ -0,0 +1,100 @@
+#ifndef CONTROL_BITSET_H
+#define CONTROL_BITSET_H
+
+#include <Protocol.h>
+
+/**
+ * ControlBitset - One Bit per Control (619 bits in 20 words)
+ *
+ * For sparse per-control sets (in flight, dirty, ...) that are walked often.
+ * forEach() skips empty words and finds set bits with count-trailing-zeros,
+ * so a walk costs one load per 32 controls plus one step per set bit instead
+ * of a check on all 619 controls.
+ *
+ * Typical usage:
+ *   ControlBitset active;
+ *   active.clear();
+ *   active.set(globalID);
+ *   active.forEach([&](uint16_t id) { ... });
+ *
+ * Note: Not interrupt safe; use from the main loop only.
+ */
+class ControlBitset {
+public:
+    static const uint16_t NUM_WORDS = (TOTAL_CONTROLS + 31) / 32;
+
+    /**
+     * Clear all bits
+     */
+    void clear() {
+        for (uint16_t i = 0; i < NUM_WORDS; i++) {
+            m_words[i] = 0;
+        }
+    }
+
+    void set(uint16_t id) { m_words[id >> 5] |= (1UL << (id & 31)); }
+    void reset(uint16_t id) { m_words[id >> 5] &= ~(1UL << (id & 31)); }
+    bool test(uint16_t id) const { return (m_words[id >> 5] & (1UL << (id & 31))) != 0; }
+
+    /**
+     * Check if any bit is set
+     */
+    bool any() const {
+        for (uint16_t i = 0; i < NUM_WORDS; i++) {
+            if (m_words[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Count set bits
+     */
+    uint16_t count() const {
+        uint16_t total = 0;
+        for (uint16_t i = 0; i < NUM_WORDS; i++) {
+            total += __builtin_popcount(m_words[i]);
+        }
+        return total;
+    }
+
+    /**
+     * Call fn(id) for every set bit in ascending order. fn may set or reset
+     * bits; bits in words not yet reached are seen with their new value.
+     */
+    template<typename Fn>
+    void forEach(Fn fn) const {
+        for (uint16_t i = 0; i < NUM_WORDS; i++) {
+            uint32_t bits = m_words[i];
+            while (bits) {
+                uint8_t bit = __builtin_ctz(bits);
+                bits &= bits - 1;
+                fn((uint16_t)((i << 5) + bit));
+            }
+        }
+    }
+
+    /**
+     * Get one 32-bit word (controls word*32 .. word*32+31)
+     */
+    uint32_t getWord(uint16_t index) const { return m_words[index]; }
+
+    /**
+     * Set one 32-bit word (bits past the last control must stay clear)
+     */
+    void setWord(uint16_t index, uint32_t bits) { m_words[index] = bits; }
+
+    /**
+     * Bits of a word that belong to controls (all but the last word: all 32)
+     */
+    static uint32_t wordMask(uint16_t index) {
+        uint16_t remaining = TOTAL_CONTROLS - (index << 5);
+        return remaining >= 32 ? 0xFFFFFFFFUL : ((1UL << remaining) - 1);
+    }
+
+private:
+    uint32_t m_words[NUM_WORDS];
+};
+
+#endif // CONTROL_BITSET_H
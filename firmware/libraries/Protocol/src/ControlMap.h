@@ -0,0 +1,164 @@
+#ifndef CONTROL_MAP_H
+#define CONTROL_MAP_H
+
+#include <Protocol.h>
+
+/**
+ * ControlMap - Compile-Time Panel Control ID Mapping
+ *
+ * Peripheral ESP32s number their controls locally: encoders 0..N-1, then
+ * buttons from N (N encoder push buttons, then the panel's standalone
+ * buttons). Every panel therefore sends IDs starting at 0. This table maps
+ * (panel, local ID) to the system-wide global ID (0-618) and control type.
+ * It is built by a constexpr function, so it lives in flash and a lookup is
+ * a bounds check and one array read.
+ *
+ * Global ID layout:
+ *   0-283    Encoders            (panel 0 = 0-31, ... panel 7 = 224-255, FX = 256-283)
+ *   284-567  Encoder buttons     (same order as the encoders, +284)
+ *   568-599  Standalone buttons  (4 per synth panel)
+ *   600-618  Snapshot buttons    (snapshot panel, not on the I2C buses)
+ *
+ * Panel index = I2C address - 0x08 (0-7 synth panels, 8 = FX panel).
+ *
+ * Typical usage:
+ *   uint16_t globalID = mapControlID(panelForAddress(0x09), event.globalID);
+ *   if (globalID != CONTROL_MAP_INVALID) { ... }
+ *
+ * Note: Needs C++14 (constexpr loops); include only from Teensy/host code.
+ */
+
+// ============================================================================
+// LAYOUT
+// ============================================================================
+
+#define NUM_PANELS 9                // I2C panels (8 synth + 1 FX)
+#define PANEL_FIRST_ADDRESS 0x08
+#define PANEL_SNAPSHOT 9            // panelID for the snapshot buttons
+#define MAX_LOCAL_CONTROLS 68       // 32 encoders + 32 encoder buttons + 4 standalone
+
+#define GLOBAL_ENCODER_BASE 0
+#define GLOBAL_ENCODER_BUTTON_BASE (GLOBAL_ENCODER_BASE + NUM_ENCODERS)
+#define GLOBAL_STANDALONE_BASE (GLOBAL_ENCODER_BUTTON_BASE + NUM_ENCODER_BUTTONS)
+#define GLOBAL_SNAPSHOT_BASE (GLOBAL_STANDALONE_BASE + NUM_STANDALONE_BUTTONS)
+
+#define CONTROL_MAP_INVALID 0xFFFF
+
+struct PanelLayout {
+    uint8_t numEncoders;        // Each encoder also has a push button
+    uint8_t numStandalone;      // Standalone buttons after the encoder buttons
+};
+
+constexpr PanelLayout PANEL_LAYOUTS[NUM_PANELS] = {
+    {32, 4}, {32, 4}, {32, 4}, {32, 4},     // Synth panels #1-4 (0x08-0x0B)
+    {32, 4}, {32, 4}, {32, 4}, {32, 4},     // Synth panels #5-8 (0x0C-0x0F)
+    {28, 0}                                 // FX panel #9 (0x10)
+};
+
+// ============================================================================
+// TABLE
+// ============================================================================
+
+struct ControlMapEntry {
+    uint16_t globalID;          // CONTROL_MAP_INVALID if the local ID is unused
+    ControlType controlType;
+};
+
+struct ControlMapTable {
+    ControlMapEntry entries[NUM_PANELS][MAX_LOCAL_CONTROLS];
+};
+
+/**
+ * Build the (panel, local ID) -> global ID table (compile time)
+ */
+constexpr ControlMapTable buildControlMap() {
+    ControlMapTable table = {};
+    uint16_t encoderBase = GLOBAL_ENCODER_BASE;
+    uint16_t standaloneBase = GLOBAL_STANDALONE_BASE;
+
+    for (uint8_t panel = 0; panel < NUM_PANELS; panel++) {
+        const PanelLayout& layout = PANEL_LAYOUTS[panel];
+        const uint8_t n = layout.numEncoders;
+
+        for (uint8_t local = 0; local < MAX_LOCAL_CONTROLS; local++) {
+            table.entries[panel][local].globalID = CONTROL_MAP_INVALID;
+            table.entries[panel][local].controlType = CONTROL_ENCODER;
+        }
+
+        for (uint8_t e = 0; e < n; e++) {
+            table.entries[panel][e].globalID = encoderBase + e;
+            table.entries[panel][e].controlType = CONTROL_ENCODER;
+
+            table.entries[panel][n + e].globalID = GLOBAL_ENCODER_BUTTON_BASE + encoderBase + e;
+            table.entries[panel][n + e].controlType = CONTROL_ENCODER_BUTTON;
+        }
+
+        for (uint8_t s = 0; s < layout.numStandalone; s++) {
+            table.entries[panel][2 * n + s].globalID = standaloneBase + s;
+            table.entries[panel][2 * n + s].controlType = CONTROL_BUTTON;
+        }
+
+        encoderBase += n;
+        standaloneBase += layout.numStandalone;
+    }
+
+    return table;
+}
+
+constexpr ControlMapTable CONTROL_MAP = buildControlMap();
+
+/**
+ * Global ID of the last standalone button in the table (compile time)
+ */
+constexpr uint16_t lastStandaloneID() {
+    uint16_t last = CONTROL_MAP_INVALID;
+    for (uint8_t panel = 0; panel < NUM_PANELS; panel++) {
+        const PanelLayout& layout = PANEL_LAYOUTS[panel];
+        if (layout.numStandalone > 0) {
+            last = CONTROL_MAP.entries[panel][2 * layout.numEncoders + layout.numStandalone - 1].globalID;
+        }
+    }
+    return last;
+}
+
+// Layout must account for every control exactly once
+static_assert(CONTROL_MAP.entries[NUM_PANELS - 1][PANEL_LAYOUTS[NUM_PANELS - 1].numEncoders - 1].globalID
+              == GLOBAL_ENCODER_BASE + NUM_ENCODERS - 1, "Panel encoders must add up to NUM_ENCODERS");
+static_assert(lastStandaloneID() == GLOBAL_SNAPSHOT_BASE - 1,
+              "Panel standalone buttons must add up to NUM_STANDALONE_BUTTONS");
+static_assert(GLOBAL_SNAPSHOT_BASE + NUM_SNAPSHOT_BUTTONS == TOTAL_CONTROLS,
+              "Global ID ranges must cover TOTAL_CONTROLS");
+
+// ============================================================================
+// LOOKUP
+// ============================================================================
+
+/**
+ * Panel index for an I2C address (NUM_PANELS or more if not a panel)
+ */
+constexpr uint8_t panelForAddress(uint8_t address) {
+    return (uint8_t)(address - PANEL_FIRST_ADDRESS);
+}
+
+/**
+ * Map a panel-local control ID to its global ID
+ * @param panel - Panel index (0-8)
+ * @param localID - ID sent by the panel
+ * @return Global ID, or CONTROL_MAP_INVALID
+ */
+constexpr uint16_t mapControlID(uint8_t panel, uint16_t localID) {
+    return (panel < NUM_PANELS && localID < MAX_LOCAL_CONTROLS)
+        ? CONTROL_MAP.entries[panel][localID].globalID
+        : CONTROL_MAP_INVALID;
+}
+
+/**
+ * Control type of a panel-local control ID (CONTROL_ENCODER if unmapped)
+ */
+constexpr ControlType mapControlType(uint8_t panel, uint16_t localID) {
+    return (panel < NUM_PANELS && localID < MAX_LOCAL_CONTROLS)
+        ? CONTROL_MAP.entries[panel][localID].controlType
+        : CONTROL_ENCODER;
+}
+
+#endif // CONTROL_MAP_H
@@ -0,0 +1,66 @@
+#ifndef CONTROL_ROUTE_H
+#define CONTROL_ROUTE_H
+
+#include <Protocol.h>
+
+/**
+ * ControlRoute - Compiled MIDI Routing for One Control (4 bytes)
+ *
+ * The per-event path needs only where a value goes: status byte, CC number,
+ * USB cable and resolution. ControlConfig (48 bytes, labels, diagnostics,
+ * both banks) stays the editable source of truth; a route is compiled from
+ * it for one bank, so 16 controls share a cache line instead of one config
+ * spanning two.
+ *
+ * Value scaling (range, inversion, acceleration) is compiled separately by
+ * ValueEngine, the only code that applies it.
+ *
+ * Typical usage:
+ *   ControlRoute route;
+ *   buildControlRoute(config, false, route);  // Bank A
+ *   if (route.flags & ROUTE_FLAG_ENABLED) { midi.processControl(route, value); }
+ */
+
+// Route flags
+#define ROUTE_FLAG_ENABLED  0x01    // CONTROL_FLAG_ENABLED
+#define ROUTE_FLAG_14BIT    0x02    // MSB/LSB pair on data1 and data1 + 32
+#define ROUTE_FLAG_RELATIVE_MASK  0x0C  // EncoderMode of a relative encoder (0 = absolute)
+#define ROUTE_RELATIVE_SHIFT      2
+
+struct ControlRoute {
+    uint8_t status;     // 0xB0 | channel, 0 = not routable (bad device / CC)
+    uint8_t data1;      // CC number (MSB for 14-bit)
+    uint8_t cable;      // Virtual device (0-3)
+    uint8_t flags;      // ROUTE_FLAG_*
+} __attribute__((packed));
+
+/**
+ * Compile a control's routing for one bank
+ * @param config - Control configuration
+ * @param bankB - true for the Bank B fields
+ * @param route - Output route
+ */
+inline void buildControlRoute(const ControlConfig& config, bool bankB, ControlRoute& route) {
+    uint8_t device = bankB ? config.virtualDeviceB : config.virtualDevice;
+    uint8_t channel = bankB ? config.midiChannelB : config.midiChannel;
+    uint8_t ccNumber = bankB ? config.ccNumberB : config.ccNumber;
+    bool highRes = (bankB ? config.resolutionB : config.resolution) == 1;
+
+    // Relative values are deltas: always one CC, summed rather than replaced
+    // when coalesced, so the engine needs the encoding
+    uint8_t relative = (config.controlType == CONTROL_ENCODER) ? (uint8_t)(config.encoderMode & 0x03) : 0;
+    if (relative != ENCODER_ABSOLUTE) {
+        highRes = false;
+    }
+
+    bool valid = device < 4 && ccNumber < (highRes ? 32 : 128);
+
+    route.status = valid ? (uint8_t)(0xB0 | (channel & 0x0F)) : 0;
+    route.data1 = ccNumber;
+    route.cable = device;
+    route.flags = ((config.flags & CONTROL_FLAG_ENABLED) ? ROUTE_FLAG_ENABLED : 0)
+                | (highRes ? ROUTE_FLAG_14BIT : 0)
+                | (uint8_t)(relative << ROUTE_RELATIVE_SHIFT);
+}
+
+#endif // CONTROL_ROUTE_H
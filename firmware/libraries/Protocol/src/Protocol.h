@@ -106,7 +106,7 @@ enum BulkAssignMode : uint8_t {
 #pragma pack(push, 1)
 
 struct EventMessage {
-    uint16_t globalID;      // 0-618
+    uint16_t globalID;      // 0-618 (panel-local ID on the wire, see ControlMap.h)
     uint8_t value;          // 0-127 for MIDI value
     uint8_t flags;          // Event flags (button press/release, etc.)
     uint32_t timestamp;     // Microseconds (for diagnostics)
@@ -119,6 +119,34 @@ struct EventMessage {
 #define EVENT_FLAG_ENCODER_CCW     0x08
 #define EVENT_FLAG_PRIORITY        0x80
 
+// ============================================================================
+// BATCH EVENT MESSAGE (I2C Communication, ESP32 -> Teensy)
+// ============================================================================
+//
+// Read in two phases so an idle poll costs only the 4-byte header:
+//   1. Master writes CMD_GET_EVENTS, reads BATCH_HEADER_SIZE bytes
+//   2. If numEvents > 0, master reads batchPayloadSize(numEvents) bytes:
+//      numEvents EventMessages followed by the CRC32
+// The CRC32 covers the header plus the events actually sent, so on the wire
+// the checksum directly follows the last event (not at a fixed offset).
+
+#define MAX_EVENTS_PER_BATCH 6
+#define BATCH_HEADER_SIZE 4
+
+struct BatchEventMessage {
+    uint8_t numEvents;           // 0-6
+    uint8_t sequenceNumber;      // Rolling counter, +1 per non-empty batch
+    uint16_t backlog;            // Events still queued on the slave (spec: reserved)
+    EventMessage events[MAX_EVENTS_PER_BATCH];
+    uint32_t checksum;           // CRC32 of header + events[0..numEvents-1]
+};
+// Size: 56 bytes
+
+// Bytes in the second read phase for a batch of numEvents
+inline uint8_t batchPayloadSize(uint8_t numEvents) {
+    return numEvents * sizeof(EventMessage) + sizeof(uint32_t);
+}
+
 #pragma pack(pop)
 
 // ============================================================================
@@ -148,7 +176,7 @@ struct ControlConfig {
     uint8_t minValue;            // 0-127
     uint8_t maxValue;            // 0-127
     uint8_t defaultValue;        // 0-127
-    uint8_t currentBank;         // 0=A, 1=B
+    uint8_t currentBank;         // Unused (bank is per panel, StateManager)
 
     // Encoder-specific (4 bytes)
     EncoderMode encoderMode;     // Absolute/Relative modes
@@ -258,6 +286,9 @@ struct Snapshot {
 // SESSION FILE (103424 bytes)
 // ============================================================================
 
+// In-memory layout; on SD only the meaningful sections are stored
+// (SessionManager's compact chunk format)
+
 #pragma pack(push, 1)
 
 struct SessionFile {
@@ -311,8 +342,54 @@ struct DiagnosticMetrics {
     uint32_t eventsProcessed;     // Total events processed
     uint32_t eventsDropped;       // Total events dropped
     float dropRate;               // Drop rate percentage
+    uint32_t scanCycles;          // Total scan cycles
+    uint32_t scansSkipped;        // Scan cycles skipped (frame unchanged)
 };
 
+// ============================================================================
+// I2C LINK STATISTICS (master side, per slave)
+// ============================================================================
+
+struct I2CLinkStats {
+    uint32_t batchesReceived;     // Valid non-empty batches
+    uint32_t batchesLost;         // Missing sequence numbers (incl. checksum failures)
+    uint32_t batchesDuplicated;   // Repeated sequence numbers (events discarded)
+    uint32_t checksumErrors;      // CRC32 mismatches (batch discarded)
+    uint32_t bytesRead;           // Bytes clocked in by event reads
+    uint32_t unmappedEvents;      // Local IDs with no global ID (event dropped)
+    uint16_t backlog;             // Events queued on slave at last read
+    uint8_t lastSequence;         // Last sequence number seen
+    bool haveSequence;            // lastSequence is valid
+};
+
+/**
+ * Track a validated batch's sequence number
+ * Non-empty batches must advance by 1; empty batches repeat the last
+ * number. Anything skipped is counted as lost.
+ * @return false if the batch is a duplicate (discard its events)
+ */
+inline bool trackBatchSequence(I2CLinkStats& link, const BatchEventMessage& batch) {
+    uint8_t step = (uint8_t)(batch.sequenceNumber - link.lastSequence);
+
+    if (!link.haveSequence) {
+        step = batch.numEvents > 0 ? 1 : 0;  // First contact: accept as-is
+        link.haveSequence = true;
+    }
+
+    if (batch.numEvents == 0) {
+        link.batchesLost += step;
+    } else if (step == 0) {
+        link.batchesDuplicated++;
+        return false;
+    } else {
+        link.batchesLost += step - 1;
+        link.batchesReceived++;
+    }
+
+    link.lastSequence = batch.sequenceNumber;
+    return true;
+}
+
 // ============================================================================
 // I2C COMMAND CODES
 // ============================================================================
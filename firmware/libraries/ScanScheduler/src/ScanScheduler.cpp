@@ -0,0 +1,197 @@
+#include "ScanScheduler.h"
+
+#if defined(ESP32) || defined(NATIVE_BUILD)
+
+ScanScheduler::ScanScheduler()
+    : m_timer(nullptr)
+    , m_task(nullptr)
+    , m_tickCallback(nullptr)
+    , m_tickArg(nullptr)
+    , m_rateHz(0)
+    , m_alarmCount(0)
+    , m_periodNs(0)
+    , m_running(false)
+{
+    resetStats();
+}
+
+ScanScheduler::~ScanScheduler() {
+    if (m_timer) {
+        stop();
+        gptimer_disable(m_timer);
+        gptimer_del_timer(m_timer);
+    }
+}
+
+bool ScanScheduler::begin(uint32_t rateHz, TaskHandle_t task) {
+    if (rateHz == 0 || rateHz > TIMER_RESOLUTION_HZ / 2 || m_timer) {
+        return false;
+    }
+
+    m_rateHz = rateHz;
+    m_alarmCount = alarmCountFor(rateHz, TIMER_RESOLUTION_HZ);
+    m_periodNs = (uint32_t)(m_alarmCount * 1000000000ULL / TIMER_RESOLUTION_HZ);
+    m_task = task ? task : xTaskGetCurrentTaskHandle();
+
+    // Zeroed first: fields added by newer IDF versions keep their defaults
+    gptimer_config_t timerConfig = {};
+    timerConfig.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+    timerConfig.direction = GPTIMER_COUNT_UP;
+    timerConfig.resolution_hz = TIMER_RESOLUTION_HZ;
+
+    if (gptimer_new_timer(&timerConfig, &m_timer) != ESP_OK) {
+        m_timer = nullptr;
+        return false;
+    }
+
+    gptimer_event_callbacks_t callbacks = {
+        .on_alarm = onAlarmISR,
+    };
+
+    gptimer_alarm_config_t alarmConfig = {
+        .alarm_count = m_alarmCount,
+        .reload_count = 0,
+        .flags = {
+            .auto_reload_on_alarm = 1,
+        },
+    };
+
+    if (gptimer_register_event_callbacks(m_timer, &callbacks, this) != ESP_OK ||
+        gptimer_set_alarm_action(m_timer, &alarmConfig) != ESP_OK ||
+        gptimer_enable(m_timer) != ESP_OK) {
+        gptimer_del_timer(m_timer);
+        m_timer = nullptr;
+        return false;
+    }
+
+    resetStats();
+    return true;
+}
+
+void ScanScheduler::setTickCallback(TickCallback callback, void* arg) {
+    m_tickArg = arg;
+    m_tickCallback = callback;
+}
+
+bool ScanScheduler::start() {
+    if (!m_timer || m_running) {
+        return false;
+    }
+
+    resetStats();
+    if (gptimer_start(m_timer) != ESP_OK) {
+        return false;
+    }
+
+    m_running = true;
+    return true;
+}
+
+void ScanScheduler::stop() {
+    if (m_timer && m_running) {
+        gptimer_stop(m_timer);
+        m_running = false;
+    }
+}
+
+uint32_t ScanScheduler::waitForTick(uint32_t timeoutMs) {
+    // Take all pending notifications: more than one means the last scan
+    // ran past the next tick
+    uint32_t ticks = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs));
+    if (ticks > 0) {
+        recordWake(ticks, micros());
+    }
+    return ticks;
+}
+
+ScanSchedulerStats ScanScheduler::getStats() const {
+    ScanSchedulerStats stats;
+    stats.tickCount = m_tickCount;
+    stats.overruns = m_overruns;
+    stats.minInterval = m_intervalCount ? m_minInterval : 0;
+    stats.maxInterval = m_maxInterval;
+    stats.avgInterval = m_intervalCount ? (uint32_t)(m_intervalSum / m_intervalCount) : 0;
+    stats.maxJitter = m_maxJitter;
+    stats.maxWakeLatency = m_maxWakeLatency;
+    return stats;
+}
+
+void ScanScheduler::resetStats() {
+    m_tickCount = 0;
+    m_lastTickUs = 0;
+    m_minInterval = 0xFFFFFFFF;
+    m_maxInterval = 0;
+    m_maxJitter = 0;
+    m_intervalSum = 0;
+    m_intervalCount = 0;
+    m_overruns = 0;
+    m_maxWakeLatency = 0;
+}
+
+void IRAM_ATTR ScanScheduler::recordTick(uint32_t nowUs) {
+    if (m_tickCount > 0) {
+        uint32_t interval = nowUs - m_lastTickUs;
+
+        if (interval < m_minInterval) {
+            m_minInterval = interval;
+        }
+        if (interval > m_maxInterval) {
+            m_maxInterval = interval;
+        }
+
+        // Jitter against the nominal period, in ns then rounded to µs
+        int32_t errorNs = (int32_t)(interval * 1000) - (int32_t)m_periodNs;
+        uint32_t jitter = ((errorNs < 0 ? -errorNs : errorNs) + 500) / 1000;
+        if (jitter > m_maxJitter) {
+            m_maxJitter = jitter;
+        }
+
+        m_intervalSum += interval;
+        m_intervalCount++;
+    }
+
+    m_lastTickUs = nowUs;
+    m_tickCount++;
+}
+
+void ScanScheduler::recordWake(uint32_t ticks, uint32_t nowUs) {
+    if (ticks > 1) {
+        m_overruns += ticks - 1;
+    }
+
+    uint32_t latency = nowUs - m_lastTickUs;
+    if (latency > m_maxWakeLatency) {
+        m_maxWakeLatency = latency;
+    }
+}
+
+uint64_t ScanScheduler::alarmCountFor(uint32_t rateHz, uint32_t resolutionHz) {
+    if (rateHz == 0) {
+        return 0;
+    }
+    return ((uint64_t)resolutionHz + rateHz / 2) / rateHz;
+}
+
+float ScanScheduler::actualRateHz(uint64_t alarmCount, uint32_t resolutionHz) {
+    if (alarmCount == 0) {
+        return 0.0f;
+    }
+    return (float)resolutionHz / (float)alarmCount;
+}
+
+bool IRAM_ATTR ScanScheduler::onAlarmISR(gptimer_handle_t /*timer*/, const gptimer_alarm_event_data_t* /*edata*/, void* userCtx) {
+    ScanScheduler* self = (ScanScheduler*)userCtx;
+
+    // Time-critical work first (e.g. latch), so it lands on the timer edge
+    if (self->m_tickCallback) {
+        self->m_tickCallback(self->m_tickArg);
+    }
+
+    self->recordTick(micros());
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(self->m_task, &woken);
+    return woken == pdTRUE;  // Request a context switch on ISR exit
+}
+
+#endif // ESP32 || NATIVE_BUILD
@@ -0,0 +1,183 @@
+#ifndef SCAN_SCHEDULER_H
+#define SCAN_SCHEDULER_H
+
+#include <Arduino.h>
+
+#if defined(ESP32) || defined(NATIVE_BUILD)
+#include <driver/gptimer.h>
+
+/**
+ * Scan timing statistics (all times in microseconds)
+ */
+struct ScanSchedulerStats {
+    uint32_t tickCount;         // Timer alarms since resetStats()
+    uint32_t overruns;          // Ticks that fired before the task took the previous one
+    uint32_t minInterval;       // Shortest measured tick interval
+    uint32_t maxInterval;       // Longest measured tick interval
+    uint32_t avgInterval;       // Mean tick interval
+    uint32_t maxJitter;         // Largest |interval - nominal period|
+    uint32_t maxWakeLatency;    // Longest tick -> task wake delay
+};
+
+/**
+ * ScanScheduler - Hardware-Timer Scan Pacing for ESP32
+ *
+ * Replaces vTaskDelayUntil() pacing, which works in whole RTOS ticks: at the
+ * default 1 kHz tick, pdMS_TO_TICKS(1000 / 5000) is 0 and the scan either
+ * spins unpaced or runs at 1 kHz. Here a gptimer alarm fires at the exact
+ * scan rate; its ISR runs an optional tick callback (e.g. pulse the shift
+ * register latch, so inputs are sampled on the timer edge) and notifies the
+ * scanner task, which then starts the DMA and decodes.
+ *
+ * Features:
+ * - gptimer alarm with auto-reload (10 MHz resolution)
+ * - Tick callback in ISR context for time-critical work (latch)
+ * - Task notification wake-up (no polling)
+ * - Interval, jitter, overrun and wake-latency statistics
+ *
+ * Typical usage:
+ *   ScanScheduler scheduler;
+ *   scheduler.setTickCallback(latchInputs, &shiftReg);
+ *   scheduler.begin(5000);  // 5 kHz, notifies the calling task
+ *   scheduler.start();
+ *   while (1) {
+ *       if (scheduler.waitForTick()) { scan(); }
+ *   }
+ *
+ * The timing maths and statistics are plain code (recordTick(),
+ * alarmCountFor(), actualRateHz()) so the native build can verify rate
+ * accuracy with a simulated clock.
+ *
+ * Note: gptimer requires ESP-IDF 5 (Arduino-ESP32 3.x)
+ */
+class ScanScheduler {
+public:
+    /**
+     * Tick callback (runs in timer interrupt context - keep it short)
+     * @param arg - User argument from setTickCallback()
+     */
+    typedef void (*TickCallback)(void* arg);
+
+    static const uint32_t TIMER_RESOLUTION_HZ = 10000000;  // 0.1 µs per count
+
+    ScanScheduler();
+    ~ScanScheduler();
+
+    /**
+     * Create and configure the timer
+     * @param rateHz - Scan rate in Hz
+     * @param task - Task to notify on each tick (nullptr = calling task)
+     * @return true if successful
+     */
+    bool begin(uint32_t rateHz, TaskHandle_t task = nullptr);
+
+    /**
+     * Set callback run from the timer ISR on every tick (before the task
+     * is notified). Set before start().
+     * @param callback - Function to call (nullptr to disable)
+     * @param arg - User argument passed to callback
+     */
+    void setTickCallback(TickCallback callback, void* arg = nullptr);
+
+    /**
+     * Start ticking
+     * @return true if timer started
+     */
+    bool start();
+
+    /**
+     * Stop ticking
+     */
+    void stop();
+
+    /**
+     * Block until the next tick
+     * @param timeoutMs - Timeout in milliseconds
+     * @return Ticks since last call (0 = timeout, >1 = scan overran)
+     */
+    uint32_t waitForTick(uint32_t timeoutMs = 10);
+
+    /**
+     * Get requested scan rate (Hz)
+     */
+    uint32_t getRateHz() const { return m_rateHz; }
+
+    /**
+     * Get rate the timer actually produces (alarm count is whole timer counts)
+     */
+    float getActualRateHz() const { return actualRateHz(m_alarmCount, TIMER_RESOLUTION_HZ); }
+
+    /**
+     * Get nominal tick period in nanoseconds
+     */
+    uint32_t getPeriodNs() const { return m_periodNs; }
+
+    /**
+     * Get timing statistics
+     */
+    ScanSchedulerStats getStats() const;
+
+    /**
+     * Reset timing statistics
+     */
+    void resetStats();
+
+    /**
+     * Record a tick at a timestamp (called from the timer ISR; host models
+     * call it directly with simulated times)
+     * @param nowUs - Tick time in microseconds
+     */
+    void recordTick(uint32_t nowUs);
+
+    /**
+     * Record a task wake (called by waitForTick(); public for host models)
+     * @param ticks - Notifications taken (more than 1 = overrun)
+     * @param nowUs - Wake time in microseconds
+     */
+    void recordWake(uint32_t ticks, uint32_t nowUs);
+
+    /**
+     * Timer counts per tick for a rate (rounded to nearest)
+     * @param rateHz - Scan rate in Hz
+     * @param resolutionHz - Timer counts per second
+     */
+    static uint64_t alarmCountFor(uint32_t rateHz, uint32_t resolutionHz);
+
+    /**
+     * Rate produced by an alarm count
+     * @param alarmCount - Timer counts per tick
+     * @param resolutionHz - Timer counts per second
+     */
+    static float actualRateHz(uint64_t alarmCount, uint32_t resolutionHz);
+
+private:
+    gptimer_handle_t m_timer;
+    TaskHandle_t m_task;
+    TickCallback m_tickCallback;
+    void* m_tickArg;
+    uint32_t m_rateHz;
+    uint64_t m_alarmCount;
+    uint32_t m_periodNs;
+    bool m_running;
+
+    // Statistics (written from ISR)
+    volatile uint32_t m_tickCount;
+    volatile uint32_t m_lastTickUs;
+    volatile uint32_t m_minInterval;
+    volatile uint32_t m_maxInterval;
+    volatile uint32_t m_maxJitter;
+    volatile uint64_t m_intervalSum;
+    volatile uint32_t m_intervalCount;
+
+    // Statistics (written from task)
+    uint32_t m_overruns;
+    uint32_t m_maxWakeLatency;
+
+    /**
+     * gptimer alarm handler (ISR context)
+     */
+    static bool onAlarmISR(gptimer_handle_t timer, const gptimer_alarm_event_data_t* edata, void* userCtx);
+};
+
+#endif // ESP32 || NATIVE_BUILD
+#endif // SCAN_SCHEDULER_H
@@ -0,0 +1,194 @@
+#ifndef SESSION_FORMAT_H
+#define SESSION_FORMAT_H
+
+#include <Arduino.h>
+#include <Protocol.h>
+#include <stddef.h>
+
+/**
+ * SessionFormat - Compact On-Disk Session Container
+ *
+ * SessionFile is the in-memory layout: 109 KB, of which 33 KB is trailing
+ * padding and 1,781 bytes per snapshot are reserved. On SD a session is
+ * stored as a versioned chunk container holding only the meaningful bytes:
+ *
+ *   SessionFileHeader    magic, format version, chunk count, file length
+ *   SessionChunkEntry[]  chunk directory (type, index, payload offset/length)
+ *   chunks...            SessionChunkHeader (TLV) + payload, in file order
+ *   END chunk
+ *
+ * Each payload is a byte-exact copy of one range of SessionFile
+ * (sessionChunkRange()), so loading is a read straight into the struct
+ * with no parsing. The directory fits in the first sector, so a single
+ * section loads with one directory read plus its own sectors.
+ *
+ * Chunks:
+ * - HEADER      name, version, active snapshot (header reserved bytes dropped)
+ * - CONTROLS    one chunk per block of 64 ControlConfigs (index = block)
+ * - SNAPSHOT    one per non-empty snapshot, reserved bytes dropped; an
+ *               all-zero snapshot is not stored and loads as zero
+ * - MASKS       zero masks, timestamps, CRC
+ *
+ * Integrity: each stored snapshot's crc32 covers its bytes before the
+ * field; SessionFile::crc32 (in MASKS) covers every known chunk payload
+ * in file order up to the field itself. Both are CRC-32 (CRC32 library),
+ * computed while the chunks stream out and checked while they stream in.
+ *
+ * Compatibility: readers skip chunk types they don't know, copy at most
+ * the size they know from a longer chunk and zero-fill a shorter one, so
+ * sections can grow without a format bump. SESSION_FORMAT_VERSION changes
+ * only for incompatible layouts; version 1 is the raw fixed SessionFile,
+ * recognized by its missing magic and converted on save.
+ */
+
+#define SESSION_FORMAT_MAGIC    0x53534B4D  // "MKSS" little-endian
+#define SESSION_FORMAT_VERSION  2           // 1 = raw fixed-layout SessionFile
+
+#define SESSION_CONTROL_BLOCK   64          // Controls per CONTROLS chunk
+#define SESSION_CONTROL_BLOCKS  ((TOTAL_CONTROLS + SESSION_CONTROL_BLOCK - 1) / SESSION_CONTROL_BLOCK)
+
+// Header + control blocks + snapshots + masks + end
+#define SESSION_MAX_CHUNKS      (1 + SESSION_CONTROL_BLOCKS + NUM_SNAPSHOTS + 1 + 1)
+
+/**
+ * Parts of a SessionFile that can be loaded or saved on their own
+ * (also the chunk type on disk)
+ */
+enum SessionSection : uint8_t {
+    SESSION_SECTION_HEADER = 0,     // Name, version, active snapshot
+    SESSION_SECTION_CONTROLS = 1,   // 619 ControlConfigs
+    SESSION_SECTION_SNAPSHOT = 2,   // One snapshot (by index)
+    SESSION_SECTION_MASKS = 3,      // Zero masks, timestamps, CRC
+    SESSION_SECTION_COUNT = 4
+};
+
+#define SESSION_CHUNK_END 0xFF      // Last chunk (no payload)
+
+#pragma pack(push, 1)
+
+struct SessionFileHeader {
+    uint32_t magic;                 // SESSION_FORMAT_MAGIC
+    uint16_t version;               // SESSION_FORMAT_VERSION
+    uint16_t chunkCount;            // Directory entries (END included)
+    uint32_t fileLength;            // Total bytes, END chunk included
+    uint32_t reserved;
+};
+
+struct SessionChunkEntry {
+    uint8_t type;                   // SessionSection or SESSION_CHUNK_END
+    uint8_t index;                  // Control block or snapshot number
+    uint16_t reserved;
+    uint32_t offset;                // Payload offset in the file
+    uint32_t length;                // Payload length
+};
+
+struct SessionChunkHeader {
+    uint8_t type;                   // As in the directory
+    uint8_t index;
+    uint16_t reserved;
+    uint32_t length;                // Payload length that follows
+};
+
+/**
+ * Write-ahead journal for in-place section saves ("sessionNNN.jnl"):
+ * header, then records (file offset, length, bytes), then a CRC-32 of the
+ * records. A complete journal is replayed into the session file after a
+ * power loss; a torn one is discarded with the file untouched.
+ */
+#define SESSION_JOURNAL_MAGIC   0x4C4A4B4D  // "MKJL" little-endian
+
+struct SessionJournalHeader {
+    uint32_t magic;                 // SESSION_JOURNAL_MAGIC
+    uint16_t recordCount;
+    uint16_t reserved;
+    uint32_t length;                // Record bytes (before the CRC)
+};
+
+struct SessionJournalRecord {
+    uint32_t offset;                // Session file offset
+    uint32_t length;                // Bytes that follow
+};
+
+/**
+ * Session index ("index.bin" in the session directory): a header, then one
+ * fixed-size entry per slot, so listing all slots is one read at boot and a
+ * save rewrites only its own entry in place. Each entry has its own CRC; a
+ * torn or stale entry is rebuilt from its session file by begin().
+ *
+ * The chunk layout of a compact file follows from which snapshots are
+ * stored, so snapshotMask stands in for the chunk offsets: a section load
+ * can plan its reads without reading the directory first.
+ */
+#define SESSION_INDEX_MAGIC     0x58494B4D  // "MKIX" little-endian
+#define SESSION_INDEX_VERSION   1
+
+#define SESSION_INDEX_USED      0x01        // Slot holds a session
+#define SESSION_INDEX_PLANNED   0x02        // Layout matches planChunks(snapshotMask)
+
+struct SessionIndexHeader {
+    uint32_t magic;                 // SESSION_INDEX_MAGIC
+    uint16_t version;               // SESSION_INDEX_VERSION
+    uint16_t entryCount;            // NUM_SESSIONS
+    uint32_t entrySize;             // sizeof(SessionIndexEntry)
+    uint32_t reserved;
+};
+
+struct SessionIndexEntry {
+    uint8_t flags;                  // SESSION_INDEX_*
+    uint8_t formatVersion;          // File format (0 = unreadable)
+    uint16_t snapshotMask;          // Stored snapshots (bit per snapshot)
+    uint32_t fileLength;            // Session file size
+    char name[64];                  // SessionFile::name
+    uint32_t createdTime;           // SessionFile::createdTime
+    uint32_t modifiedTime;          // SessionFile::modifiedTime
+    uint32_t sessionCrc;            // SessionFile::crc32
+    uint32_t crc32;                 // CRC-32 of this entry up to here
+};
+
+#pragma pack(pop)
+
+/**
+ * In-memory range of a chunk's payload
+ * @param type - Chunk type (SessionSection)
+ * @param index - Control block or snapshot number
+ * @param offset - Output offset in SessionFile
+ * @param length - Output length in bytes
+ * @return false for unknown types or out-of-range indices
+ */
+inline bool sessionChunkRange(uint8_t type, uint8_t index, uint32_t& offset, uint32_t& length) {
+    switch (type) {
+        case SESSION_SECTION_HEADER:
+            offset = 0;
+            length = offsetof(SessionFile, reserved);
+            return true;
+
+        case SESSION_SECTION_CONTROLS: {
+            if (index >= SESSION_CONTROL_BLOCKS) {
+                return false;
+            }
+            uint16_t first = (uint16_t)index * SESSION_CONTROL_BLOCK;
+            uint16_t count = min((uint16_t)SESSION_CONTROL_BLOCK, (uint16_t)(TOTAL_CONTROLS - first));
+            offset = offsetof(SessionFile, controls) + (uint32_t)first * sizeof(ControlConfig);
+            length = (uint32_t)count * sizeof(ControlConfig);
+            return true;
+        }
+
+        case SESSION_SECTION_SNAPSHOT:
+            if (index >= NUM_SNAPSHOTS) {
+                return false;
+            }
+            offset = offsetof(SessionFile, snapshots) + (uint32_t)index * sizeof(Snapshot);
+            length = offsetof(Snapshot, reserved);
+            return true;
+
+        case SESSION_SECTION_MASKS:
+            offset = offsetof(SessionFile, globalZeroMask);
+            length = offsetof(SessionFile, padding) - offset;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+#endif // SESSION_FORMAT_H
@@ -0,0 +1,1463 @@
+#include "SessionManager.h"
+
+#if defined(ESP32) || defined(NATIVE_BUILD)
+
+#include <stddef.h>
+
+// Session CRC coverage of a chunk payload: MASKS stops at SessionFile::crc32
+static uint32_t crcCoverage(uint8_t type, uint32_t length) {
+    if (type == SESSION_SECTION_MASKS) {
+        return min(length, (uint32_t)(offsetof(SessionFile, crc32) - offsetof(SessionFile, globalZeroMask)));
+    }
+    return length;
+}
+
+SessionManager::SessionManager()
+    : m_sector(nullptr),
+      m_sectorOffset(NO_SECTOR),
+      m_sectorLength(0),
+      m_index(nullptr),
+      m_indexScans(0),
+      m_cacheSize(0),
+      m_cacheClock(0),
+      m_cacheHits(0),
+      m_cacheMisses(0),
+      m_current(nullptr),
+      m_currentSlot(0),
+      m_changedSnapshots(0),
+      m_headerChanged(false),
+      m_masksChanged(false),
+      m_autoSave(false),
+      m_autoSaveIntervalMs(300000),
+      m_lastAutoSave(0),
+      m_lastLoadUs(0),
+      m_lastSaveUs(0),
+      m_lastSaveBytes(0),
+      m_budgetUs(0),
+      m_overBudgetCount(0),
+      m_crcErrorCount(0),
+      m_recoveredCount(0) {
+    m_directory[0] = '\0';
+    memset(m_stats, 0, sizeof(m_stats));
+    m_changedControls.clear();
+    for (uint8_t i = 0; i < MAX_CACHED; i++) {
+        m_cache[i] = {nullptr, NO_SLOT, 0};
+    }
+}
+
+SessionManager::~SessionManager() {
+    setCacheSize(0);
+    free(m_index);
+    free(m_sector);
+}
+
+bool SessionManager::begin(const char* directory) {
+    strncpy(m_directory, directory, sizeof(m_directory) - 1);
+    m_directory[sizeof(m_directory) - 1] = '\0';
+
+    if (!m_sector) {
+        m_sector = (uint8_t*)malloc(SECTOR_SIZE);
+        if (!m_sector) {
+            return false;
+        }
+    }
+
+    if (!SD.exists(m_directory) && !SD.mkdir(m_directory)) {
+        return false;
+    }
+
+    // One directory pass: session files and their sizes (to check the
+    // index), and slots with leftover .tmp/.bak/.jnl files
+    uint32_t present[(NUM_SESSIONS + 31) / 32] = {};
+    uint32_t pending[(NUM_SESSIONS + 31) / 32] = {};
+    uint32_t sizes[NUM_SESSIONS] = {};
+    File dir = SD.open(m_directory);
+    for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+        const char* name = strrchr(entry.name(), '/');
+        name = name ? name + 1 : entry.name();
+        unsigned slot;
+        char extension[4];
+        if (sscanf(name, "session%3u.%3s", &slot, extension) == 2 && slot < NUM_SESSIONS) {
+            if (strcmp(extension, "bin") == 0) {
+                present[slot / 32] |= 1UL << (slot % 32);
+                sizes[slot] = entry.size();
+            } else {
+                pending[slot / 32] |= 1UL << (slot % 32);
+            }
+        }
+        entry.close();
+    }
+    dir.close();
+
+    // Recover outside the listing; recovered slots get fresh index entries
+    for (uint8_t slot = 0; slot < NUM_SESSIONS; slot++) {
+        if (pending[slot / 32] & (1UL << (slot % 32))) {
+            recover(slot);
+            char path[48];
+            makePath(slot, path, sizeof(path));
+            if (SD.exists(path)) {
+                present[slot / 32] |= 1UL << (slot % 32);
+            } else {
+                present[slot / 32] &= ~(1UL << (slot % 32));
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < m_cacheSize; i++) {
+        m_cache[i].slot = NO_SLOT;
+    }
+    return loadIndex(present, sizes, pending);
+}
+
+bool SessionManager::exists(uint8_t slot) {
+    if (slot >= NUM_SESSIONS) {
+        return false;
+    }
+    if (m_index) {
+        return (m_index[slot].flags & SESSION_INDEX_USED) != 0;
+    }
+    char path[48];
+    makePath(slot, path, sizeof(path));
+    return SD.exists(path);
+}
+
+bool SessionManager::remove(uint8_t slot) {
+    if (slot >= NUM_SESSIONS) {
+        return false;
+    }
+    char path[48];
+    makePath(slot, path, sizeof(path));
+    if (!SD.remove(path)) {
+        return false;
+    }
+
+    CachedSession* cached = findCached(slot);
+    if (cached) {
+        cached->slot = NO_SLOT;
+    }
+    updateIndex(slot, nullptr);
+    return true;
+}
+
+// ============================================================================
+// Loading
+// ============================================================================
+
+bool SessionManager::load(uint8_t slot, SessionFile& session) {
+    if (slot >= NUM_SESSIONS || !m_sector) {
+        return false;
+    }
+
+    // Preloaded: a copy out of PSRAM
+    CachedSession* cached = findCached(slot);
+    if (cached) {
+        uint32_t start = micros();
+        memcpy(&session, cached->session, sizeof(SessionFile));
+        cached->lastUsed = ++m_cacheClock;
+        m_cacheHits++;
+        recordTotal(false, micros() - start);
+        return true;
+    }
+
+    if (!loadFile(slot, session)) {
+        return false;
+    }
+
+    // Recently used: keep a copy
+    cached = cacheSlot(slot);
+    if (cached) {
+        memcpy(cached->session, &session, sizeof(SessionFile));
+        cached->slot = slot;
+        cached->lastUsed = ++m_cacheClock;
+        m_cacheMisses++;
+    }
+    return true;
+}
+
+bool SessionManager::loadFile(uint8_t slot, SessionFile& session) {
+    char path[48];
+    makePath(slot, path, sizeof(path));
+    File file = SD.open(path, FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    uint32_t start = micros();
+    m_sectorOffset = NO_SECTOR;
+    uint16_t version = readDirectory(file);
+    bool ok = version != 0;
+
+    if (version == SESSION_FORMAT_VERSION) {
+        // Everything not stored (padding, reserved, empty snapshots) is zero
+        memset(&session, 0, sizeof(SessionFile));
+
+        uint32_t elapsed[SESSION_SECTION_COUNT] = {};
+        uint32_t bytes[SESSION_SECTION_COUNT] = {};
+        uint32_t crc = 0;
+
+        // Directory order is file order, so a sector shared by two chunks
+        // is read once and the session CRC runs in stream order
+        for (uint16_t c = 0; ok && c < m_header.chunkCount; c++) {
+            const SessionChunkEntry& chunk = m_chunks[c];
+            uint32_t chunkStart = micros();
+            uint32_t chunkBytes;
+            ok = readChunk(file, chunk, session, &crc, chunkBytes);
+            if (chunk.type < SESSION_SECTION_COUNT) {
+                elapsed[chunk.type] += micros() - chunkStart;
+                bytes[chunk.type] += chunkBytes;
+            }
+        }
+
+        if (ok && crc != session.crc32) {
+            m_crcErrorCount++;
+            ok = false;
+        }
+        for (uint8_t s = 0; s < SESSION_SECTION_COUNT; s++) {
+            recordSection((SessionSection)s, false, elapsed[s], bytes[s]);
+        }
+    } else if (version == 1) {
+        // Old layout (no CRCs); in file order, so a shared sector is read once
+        ok = readLegacySection(file, SESSION_SECTION_HEADER, 0, session)
+          && readLegacySection(file, SESSION_SECTION_CONTROLS, 0, session);
+        for (uint8_t i = 0; ok && i < NUM_SNAPSHOTS; i++) {
+            ok = readLegacySection(file, SESSION_SECTION_SNAPSHOT, i, session);
+        }
+        ok = ok && readLegacySection(file, SESSION_SECTION_MASKS, 0, session);
+        memset(session.padding, 0, sizeof(session.padding));
+    }
+    file.close();
+
+    recordTotal(false, micros() - start);
+    return ok;
+}
+
+bool SessionManager::loadSection(uint8_t slot, SessionSection section, SessionFile& session, uint8_t index) {
+    uint32_t offset, length;
+    if (slot >= NUM_SESSIONS || !m_sector || !getSectionRange(section, index, offset, length)) {
+        return false;
+    }
+
+    CachedSession* cached = findCached(slot);
+    if (cached) {
+        uint32_t start = micros();
+        if (section == SESSION_SECTION_SNAPSHOT) {
+            length = sizeof(Snapshot);  // Reserved bytes too (zero)
+        }
+        memcpy((uint8_t*)&session + offset, (const uint8_t*)cached->session + offset, length);
+        cached->lastUsed = ++m_cacheClock;
+        m_cacheHits++;
+        recordSection(section, false, micros() - start, length);
+        return true;
+    }
+
+    char path[48];
+    makePath(slot, path, sizeof(path));
+    File file = SD.open(path, FILE_READ);
+    if (!file) {
+        return false;
+    }
+
+    // The index knows the layout; the directory is read only without it
+    m_sectorOffset = NO_SECTOR;
+    uint16_t version = planFromIndex(slot, file) ? SESSION_FORMAT_VERSION : readDirectory(file);
+    bool ok = false;
+
+    if (version == SESSION_FORMAT_VERSION) {
+        memset((uint8_t*)&session + offset, 0, length);
+        if (section == SESSION_SECTION_SNAPSHOT) {
+            memset(session.snapshots[index].reserved, 0, sizeof(session.snapshots[index].reserved));
+        }
+        ok = readChunks(file, section, index, session);
+    } else if (version == 1) {
+        ok = readLegacySection(file, section, index, session);
+    }
+    file.close();
+    return ok;
+}
+
+uint16_t SessionManager::readDirectory(File& file) {
+    if (!readRange(file, 0, (uint8_t*)&m_header, sizeof(SessionFileHeader)) ||
+        m_header.magic != SESSION_FORMAT_MAGIC) {
+        // No magic: the old fixed layout, if the file is long enough
+        return file.size() >= getLegacySize() ? 1 : 0;
+    }
+
+    if (m_header.version != SESSION_FORMAT_VERSION ||
+        m_header.chunkCount > SESSION_MAX_CHUNKS ||
+        m_header.fileLength > file.size()) {
+        return 0;
+    }
+
+    uint32_t length = (uint32_t)m_header.chunkCount * sizeof(SessionChunkEntry);
+    if (!readRange(file, sizeof(SessionFileHeader), (uint8_t*)m_chunks, length)) {
+        return 0;
+    }
+
+    for (uint16_t c = 0; c < m_header.chunkCount; c++) {
+        if (m_chunks[c].offset + m_chunks[c].length > m_header.fileLength) {
+            return 0;
+        }
+    }
+    return SESSION_FORMAT_VERSION;
+}
+
+bool SessionManager::readChunk(File& file, const SessionChunkEntry& chunk, SessionFile& session,
+                               uint32_t* sessionCrc, uint32_t& bytes) {
+    bytes = 0;
+
+    // Unknown types are skipped; longer chunks are truncated to what we know
+    uint32_t offset, length;
+    if (!sessionChunkRange(chunk.type, chunk.index, offset, length)) {
+        return true;
+    }
+    length = min(length, chunk.length);
+    uint8_t* dest = (uint8_t*)&session + offset;
+
+    uint32_t covered = crcCoverage(chunk.type, length);
+    if (!readRange(file, chunk.offset, dest, covered, sessionCrc) ||
+        !readRange(file, chunk.offset + covered, dest + covered, length - covered)) {
+        return false;
+    }
+    bytes = length;
+
+    if (chunk.type == SESSION_SECTION_SNAPSHOT && length == offsetof(Snapshot, reserved)) {
+        const Snapshot& snapshot = session.snapshots[chunk.index];
+        if (CRC32::calculate(&snapshot, offsetof(Snapshot, crc32)) != snapshot.crc32) {
+            m_crcErrorCount++;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SessionManager::readChunks(File& file, SessionSection section, uint8_t index, SessionFile& session) {
+    uint32_t start = micros();
+    uint32_t total = 0;
+    bool ok = true;
+
+    for (uint16_t c = 0; ok && c < m_header.chunkCount; c++) {
+        const SessionChunkEntry& chunk = m_chunks[c];
+        if (chunk.type != section || (section == SESSION_SECTION_SNAPSHOT && chunk.index != index)) {
+            continue;
+        }
+        uint32_t bytes;
+        ok = readChunk(file, chunk, session, nullptr, bytes);
+        total += bytes;
+    }
+
+    recordSection(section, false, micros() - start, total);
+    return ok;
+}
+
+bool SessionManager::readLegacySection(File& file, SessionSection section, uint8_t index, SessionFile& session) {
+    uint32_t offset, length;
+    if (!getSectionRange(section, index, offset, length)) {
+        return false;
+    }
+
+    uint32_t start = micros();
+    bool ok = readRange(file, offset, (uint8_t*)&session + offset, length);
+
+    if (section == SESSION_SECTION_SNAPSHOT) {
+        // Reserved bytes are not read; keep RAM deterministic
+        memset(session.snapshots[index].reserved, 0, sizeof(session.snapshots[index].reserved));
+    }
+
+    recordSection(section, false, micros() - start, length);
+    return ok;
+}
+
+bool SessionManager::readRange(File& file, uint32_t offset, uint8_t* dest, uint32_t length, uint32_t* crc) {
+    if (offset + length > file.size()) {
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+
+    // Partial head sector (or a range inside one sector)
+    if (offset % SECTOR_SIZE != 0 || length < SECTOR_SIZE) {
+        uint32_t sectorOffset = offset - offset % SECTOR_SIZE;
+        if (!loadSector(file, sectorOffset)) {
+            return false;
+        }
+        uint32_t count = min(length, (uint32_t)(sectorOffset + SECTOR_SIZE - offset));
+        memcpy(dest, m_sector + (offset - sectorOffset), count);
+        if (crc) {
+            *crc = CRC32::update(*crc, dest, count);
+        }
+        offset += count;
+        dest += count;
+        length -= count;
+    }
+
+    // Whole sectors straight into the destination, a chunk at a time
+    uint32_t whole = length - length % SECTOR_SIZE;
+    if (whole > 0) {
+        if (!file.seek(offset)) {
+            return false;
+        }
+        while (whole > 0) {
+            uint32_t count = min(whole, (uint32_t)CHUNK_SIZE);
+            if (file.read(dest, count) != count) {
+                return false;
+            }
+            if (crc) {
+                // While the chunk is still in cache
+                *crc = CRC32::update(*crc, dest, count);
+            }
+            offset += count;
+            dest += count;
+            length -= count;
+            whole -= count;
+            if (whole > 0) {
+                yield();
+            }
+        }
+    }
+
+    // Partial tail sector
+    if (length > 0) {
+        if (!loadSector(file, offset)) {
+            return false;
+        }
+        memcpy(dest, m_sector, length);
+        if (crc) {
+            *crc = CRC32::update(*crc, dest, length);
+        }
+    }
+
+    return true;
+}
+
+bool SessionManager::loadSector(File& file, uint32_t sectorOffset) {
+    if (m_sectorOffset == sectorOffset) {
+        return true;
+    }
+
+    m_sectorOffset = NO_SECTOR;
+    if (!file.seek(sectorOffset)) {
+        return false;
+    }
+
+    // The last sector of a file may be short; the rest reads as zero
+    uint32_t available = file.size() > sectorOffset ? file.size() - sectorOffset : 0;
+    uint32_t count = min(available, (uint32_t)SECTOR_SIZE);
+    if (count > 0 && file.read(m_sector, count) != count) {
+        return false;
+    }
+    memset(m_sector + count, 0, SECTOR_SIZE - count);
+
+    m_sectorOffset = sectorOffset;
+    m_sectorLength = count;
+    return true;
+}
+
+// ============================================================================
+// Saving
+// ============================================================================
+
+bool SessionManager::save(uint8_t slot, SessionFile& session) {
+    if (slot >= NUM_SESSIONS || !m_sector) {
+        return false;
+    }
+
+    char path[48], tempPath[48], backupPath[48];
+    makePath(slot, path, sizeof(path));
+    makePath(slot, tempPath, sizeof(tempPath), "tmp");
+    makePath(slot, backupPath, sizeof(backupPath), "bak");
+
+    File file = SD.open(tempPath, FILE_WRITE);
+    if (!file) {
+        return false;
+    }
+
+    uint32_t start = micros();
+    m_sectorOffset = NO_SECTOR;     // m_sector holds pending bytes, not a cached sector
+    m_sectorLength = 0;
+
+    planChunks(storedSnapshots(session), m_header, m_chunks);
+    bool ok = streamWrite(file, &m_header, sizeof(SessionFileHeader))
+           && streamWrite(file, m_chunks, (uint32_t)m_header.chunkCount * sizeof(SessionChunkEntry));
+
+    uint32_t elapsed[SESSION_SECTION_COUNT] = {};
+    uint32_t bytes[SESSION_SECTION_COUNT] = {};
+    uint32_t crc = 0;
+
+    for (uint16_t c = 0; ok && c < m_header.chunkCount; c++) {
+        const SessionChunkEntry& chunk = m_chunks[c];
+        uint32_t chunkStart = micros();
+
+        SessionChunkHeader header = {chunk.type, chunk.index, 0, chunk.length};
+        ok = streamWrite(file, &header, sizeof(SessionChunkHeader));
+
+        uint32_t offset, length;
+        if (!ok || !sessionChunkRange(chunk.type, chunk.index, offset, length)) {
+            continue;
+        }
+        uint8_t* src = (uint8_t*)&session + offset;
+
+        if (chunk.type == SESSION_SECTION_SNAPSHOT) {
+            // Snapshot CRC over the bytes before its field, as they go out
+            Snapshot& snapshot = session.snapshots[chunk.index];
+            uint32_t snapshotCrc = 0;
+            ok = streamWrite(file, src, offsetof(Snapshot, crc32), &snapshotCrc);
+            snapshot.crc32 = snapshotCrc;
+            ok = ok && streamWrite(file, src + offsetof(Snapshot, crc32), length - offsetof(Snapshot, crc32));
+            crc = CRC32::update(crc, src, length);
+        } else {
+            // MASKS is last: the session CRC is complete at its crc32 field
+            uint32_t covered = crcCoverage(chunk.type, length);
+            ok = streamWrite(file, src, covered, &crc);
+            if (chunk.type == SESSION_SECTION_MASKS) {
+                session.crc32 = crc;
+            }
+            ok = ok && streamWrite(file, src + covered, length - covered);
+        }
+
+        elapsed[chunk.type] += micros() - chunkStart;
+        bytes[chunk.type] += length;
+    }
+    ok = ok && streamFlush(file);
+    file.close();
+
+    // Commit: old file to .bak, new file into place, drop .bak. A power
+    // loss anywhere in here is finished or rolled back by recover()
+    if (ok) {
+        if (SD.exists(path) && !SD.rename(path, backupPath)) {
+            ok = false;
+        } else if (!SD.rename(tempPath, path)) {
+            SD.rename(backupPath, path);
+            ok = false;
+        } else {
+            // Index entry while .bak still marks the slot for recovery
+            updateIndex(slot, &session);
+            SD.remove(backupPath);
+        }
+    }
+    if (!ok) {
+        SD.remove(tempPath);
+    } else {
+        if (&session == m_current && slot == m_currentSlot) {
+            clearChanges();
+        }
+
+        // Cached copy: what a load would now return
+        CachedSession* cached = findCached(slot);
+        if (cached) {
+            memset(cached->session, 0, sizeof(SessionFile));
+            for (uint16_t c = 0; c < m_header.chunkCount; c++) {
+                uint32_t offset, length;
+                if (sessionChunkRange(m_chunks[c].type, m_chunks[c].index, offset, length)) {
+                    memcpy((uint8_t*)cached->session + offset, (const uint8_t*)&session + offset, length);
+                }
+            }
+        }
+    }
+
+    m_lastSaveBytes = m_header.fileLength;
+    for (uint8_t s = 0; s < SESSION_SECTION_COUNT; s++) {
+        recordSection((SessionSection)s, true, elapsed[s], bytes[s]);
+    }
+    recordTotal(true, micros() - start);
+    return ok;
+}
+
+bool SessionManager::saveSection(uint8_t slot, SessionSection section, SessionFile& session, uint8_t index) {
+    uint32_t offset, length;
+    if (slot >= NUM_SESSIONS || !m_sector || !getSectionRange(section, index, offset, length)) {
+        return false;
+    }
+
+    uint32_t start = micros();
+    bool compact = getFormatVersion(slot) == SESSION_FORMAT_VERSION;
+
+    // Chunks have a fixed size per type, so a stored section is
+    // overwritten in place, together with MASKS for the session CRC
+    JournalRange ranges[MAX_JOURNAL_RANGES];
+    uint8_t count = 0;
+    uint32_t bytes = 0;
+    bool found = false;
+    for (uint16_t c = 0; compact && c < m_header.chunkCount; c++) {
+        const SessionChunkEntry& chunk = m_chunks[c];
+        uint32_t chunkOffset, chunkLength;
+        if (!sessionChunkRange(chunk.type, chunk.index, chunkOffset, chunkLength)) {
+            continue;
+        }
+        if (chunk.length != chunkLength) {
+            compact = false;
+            break;
+        }
+        bool match = chunk.type == section && (section != SESSION_SECTION_SNAPSHOT || chunk.index == index);
+        if (match) {
+            found = true;
+            bytes += chunkLength;
+        }
+        if (match || chunk.type == SESSION_SECTION_MASKS) {
+            ranges[count++] = {chunk.offset, chunkOffset, chunkLength};
+        }
+    }
+
+    if (!compact || !found) {
+        // Old format or a section not stored yet: rewrite the whole file
+        return save(slot, session);
+    }
+
+    if (section == SESSION_SECTION_SNAPSHOT) {
+        session.snapshots[index].crc32 = CRC32::calculate(&session.snapshots[index], offsetof(Snapshot, crc32));
+    }
+    session.crc32 = computeSessionCrc(session);
+
+    if (!writeJournaled(slot, session, ranges, count)) {
+        return false;
+    }
+
+    m_lastSaveBytes = bytes;
+    recordSection(section, true, micros() - start, bytes);
+    return true;
+}
+
+uint32_t SessionManager::computeSessionCrc(const SessionFile& session) const {
+    uint32_t crc = 0;
+    for (uint16_t c = 0; c < m_header.chunkCount; c++) {
+        uint32_t offset, length;
+        if (sessionChunkRange(m_chunks[c].type, m_chunks[c].index, offset, length)) {
+            length = min(length, m_chunks[c].length);
+            crc = CRC32::update(crc, (const uint8_t*)&session + offset, crcCoverage(m_chunks[c].type, length));
+        }
+    }
+    return crc;
+}
+
+bool SessionManager::writeJournaled(uint8_t slot, const SessionFile& session, const JournalRange* ranges, uint8_t count) {
+    char path[48], journalPath[48];
+    makePath(slot, path, sizeof(path));
+    makePath(slot, journalPath, sizeof(journalPath), "jnl");
+
+    SessionJournalHeader header = {SESSION_JOURNAL_MAGIC, count, 0, 0};
+    for (uint8_t i = 0; i < count; i++) {
+        header.length += sizeof(SessionJournalRecord) + ranges[i].length;
+    }
+
+    // 1. Journal: records, then their CRC
+    File journal = SD.open(journalPath, FILE_WRITE);
+    if (!journal) {
+        return false;
+    }
+    m_sectorOffset = NO_SECTOR;
+    m_sectorLength = 0;
+
+    uint32_t crc = 0;
+    bool ok = streamWrite(journal, &header, sizeof(SessionJournalHeader));
+    for (uint8_t i = 0; ok && i < count; i++) {
+        SessionJournalRecord record = {ranges[i].fileOffset, ranges[i].length};
+        ok = streamWrite(journal, &record, sizeof(SessionJournalRecord), &crc)
+          && streamWrite(journal, (const uint8_t*)&session + ranges[i].memOffset, ranges[i].length, &crc);
+    }
+    ok = ok && streamWrite(journal, &crc, sizeof(crc)) && streamFlush(journal);
+    journal.close();
+    if (!ok) {
+        SD.remove(journalPath);
+        return false;
+    }
+
+    // 2. Apply in place
+    File file = SD.open(path, "r+");
+    ok = (bool)file;
+    m_sectorOffset = NO_SECTOR;
+    for (uint8_t i = 0; ok && i < count; i++) {
+        ok = writeRange(file, ranges[i].fileOffset, (const uint8_t*)&session + ranges[i].memOffset, ranges[i].length);
+    }
+    if (file) {
+        file.close();
+    }
+    m_sectorOffset = NO_SECTOR;
+
+    if (ok) {
+        // Index entry while the journal still marks the slot for recovery
+        updateIndex(slot, &session);
+
+        CachedSession* cached = findCached(slot);
+        for (uint8_t i = 0; cached && i < count; i++) {
+            memcpy((uint8_t*)cached->session + ranges[i].memOffset,
+                   (const uint8_t*)&session + ranges[i].memOffset, ranges[i].length);
+        }
+    }
+
+    // 3. Done (a failed apply leaves the journal for recover())
+    return ok && SD.remove(journalPath);
+}
+
+// ============================================================================
+// Differential Autosave
+// ============================================================================
+
+void SessionManager::attach(uint8_t slot, SessionFile* session) {
+    m_current = session;
+    m_currentSlot = slot;
+    clearChanges();
+    m_lastAutoSave = millis();
+}
+
+void SessionManager::markControlChanged(uint16_t globalID) {
+    if (globalID < TOTAL_CONTROLS) {
+        m_changedControls.set(globalID);
+    }
+}
+
+void SessionManager::markSnapshotChanged(uint8_t index) {
+    if (index < NUM_SNAPSHOTS) {
+        m_changedSnapshots |= (1 << index);
+    }
+}
+
+bool SessionManager::isModified() const {
+    return m_headerChanged || m_masksChanged || m_changedSnapshots != 0 || m_changedControls.any();
+}
+
+void SessionManager::clearChanges() {
+    m_changedControls.clear();
+    m_changedSnapshots = 0;
+    m_headerChanged = false;
+    m_masksChanged = false;
+}
+
+bool SessionManager::saveChanges() {
+    if (!m_current || m_currentSlot >= NUM_SESSIONS) {
+        return false;
+    }
+    if (!isModified()) {
+        return true;
+    }
+
+    uint32_t start = micros();
+    SessionFile& session = *m_current;
+    bool compact = getFormatVersion(m_currentSlot) == SESSION_FORMAT_VERSION;
+
+    // Changed snapshots must already have a chunk to overwrite
+    uint16_t stored = 0;
+    for (uint16_t c = 0; compact && c < m_header.chunkCount; c++) {
+        uint32_t offset, length;
+        if (!sessionChunkRange(m_chunks[c].type, m_chunks[c].index, offset, length)) {
+            continue;
+        }
+        compact = m_chunks[c].length == length;
+        if (m_chunks[c].type == SESSION_SECTION_SNAPSHOT) {
+            stored |= (1 << m_chunks[c].index);
+        }
+    }
+
+    // Runs of changed controls; whole blocks if there are too many runs
+    JournalRange ranges[MAX_JOURNAL_RANGES];
+    uint8_t count = 0;
+    if (!compact || (m_changedSnapshots & ~stored) ||
+        (!planChanges(false, ranges, count) && !planChanges(true, ranges, count))) {
+        return save(m_currentSlot, session);
+    }
+
+    for (uint8_t i = 0; i < NUM_SNAPSHOTS; i++) {
+        if (m_changedSnapshots & (1 << i)) {
+            session.snapshots[i].crc32 = CRC32::calculate(&session.snapshots[i], offsetof(Snapshot, crc32));
+        }
+    }
+    session.crc32 = computeSessionCrc(session);
+
+    bool ok = writeJournaled(m_currentSlot, session, ranges, count);
+    if (ok) {
+        m_lastSaveBytes = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            m_lastSaveBytes += ranges[i].length;
+        }
+        clearChanges();
+    }
+
+    recordTotal(true, micros() - start);
+    return ok;
+}
+
+bool SessionManager::planChanges(bool wholeBlocks, JournalRange* ranges, uint8_t& count) const {
+    count = 0;
+
+    for (uint16_t c = 0; c < m_header.chunkCount; c++) {
+        const SessionChunkEntry& chunk = m_chunks[c];
+        uint32_t offset, length;
+        if (!sessionChunkRange(chunk.type, chunk.index, offset, length)) {
+            continue;
+        }
+
+        if (chunk.type == SESSION_SECTION_CONTROLS) {
+            uint16_t first = (uint16_t)chunk.index * SESSION_CONTROL_BLOCK;
+            uint16_t controls = length / sizeof(ControlConfig);
+
+            for (uint16_t i = 0; i < controls; ) {
+                if (!m_changedControls.test(first + i)) {
+                    i++;
+                    continue;
+                }
+                uint16_t end = i + 1;
+                if (wholeBlocks) {
+                    i = 0;
+                    end = controls;
+                } else {
+                    while (end < controls && m_changedControls.test(first + end)) {
+                        end++;
+                    }
+                }
+                if (count == MAX_JOURNAL_RANGES) {
+                    return false;
+                }
+                uint32_t skip = (uint32_t)i * sizeof(ControlConfig);
+                ranges[count++] = {chunk.offset + skip, offset + skip, (uint32_t)((end - i) * sizeof(ControlConfig))};
+                i = end;
+            }
+            continue;
+        }
+
+        // MASKS always goes out: it carries the session CRC
+        bool changed = (chunk.type == SESSION_SECTION_HEADER && m_headerChanged)
+                    || (chunk.type == SESSION_SECTION_SNAPSHOT && (m_changedSnapshots & (1 << chunk.index)))
+                    || chunk.type == SESSION_SECTION_MASKS;
+        if (changed) {
+            if (count == MAX_JOURNAL_RANGES) {
+                return false;
+            }
+            ranges[count++] = {chunk.offset, offset, length};
+        }
+    }
+    return true;
+}
+
+void SessionManager::enableAutoSave(bool enabled, uint32_t intervalMs) {
+    m_autoSave = enabled;
+    m_autoSaveIntervalMs = intervalMs;
+    m_lastAutoSave = millis();
+}
+
+bool SessionManager::checkAutoSave() {
+    if (!m_autoSave || !m_current || millis() - m_lastAutoSave < m_autoSaveIntervalMs) {
+        return false;
+    }
+    m_lastAutoSave = millis();
+    return isModified() && saveChanges();
+}
+
+// ============================================================================
+// Index
+// ============================================================================
+
+uint8_t SessionManager::getSessionCount() const {
+    uint8_t count = 0;
+    for (uint8_t slot = 0; m_index && slot < NUM_SESSIONS; slot++) {
+        count += (m_index[slot].flags & SESSION_INDEX_USED) ? 1 : 0;
+    }
+    return count;
+}
+
+const SessionIndexEntry* SessionManager::getSessionInfo(uint8_t slot) const {
+    if (!m_index || slot >= NUM_SESSIONS || !(m_index[slot].flags & SESSION_INDEX_USED)) {
+        return nullptr;
+    }
+    return &m_index[slot];
+}
+
+bool SessionManager::loadIndex(const uint32_t* present, const uint32_t* sizes, const uint32_t* recovered) {
+    uint32_t length = NUM_SESSIONS * sizeof(SessionIndexEntry);
+    if (!m_index) {
+        m_index = (SessionIndexEntry*)malloc(length);
+        if (!m_index) {
+            return false;
+        }
+    }
+
+    char path[48];
+    snprintf(path, sizeof(path), "%s/index.bin", m_directory);
+    SessionIndexHeader header = {SESSION_INDEX_MAGIC, SESSION_INDEX_VERSION, NUM_SESSIONS, sizeof(SessionIndexEntry), 0};
+
+    bool valid = false;
+    File file = SD.open(path, FILE_READ);
+    if (file) {
+        SessionIndexHeader stored;
+        m_sectorOffset = NO_SECTOR;
+        valid = readRange(file, 0, (uint8_t*)&stored, sizeof(stored))
+             && memcmp(&stored, &header, sizeof(header)) == 0
+             && readRange(file, sizeof(header), (uint8_t*)m_index, length);
+        file.close();
+    }
+    if (!valid) {
+        memset(m_index, 0, length);
+    }
+
+    // Rebuild torn entries and any that disagree with the directory listing
+    bool rewrite = !valid;
+    m_indexScans = 0;
+    for (uint8_t slot = 0; slot < NUM_SESSIONS; slot++) {
+        SessionIndexEntry& entry = m_index[slot];
+        bool used = (present[slot / 32] & (1UL << (slot % 32))) != 0;
+        bool stale = (recovered[slot / 32] & (1UL << (slot % 32)))
+                  || entry.crc32 != CRC32::calculate(&entry, offsetof(SessionIndexEntry, crc32))
+                  || used != ((entry.flags & SESSION_INDEX_USED) != 0)
+                  || (used && entry.fileLength != sizes[slot]);
+        if (!stale) {
+            continue;
+        }
+        if (used) {
+            scanSlot(slot, entry);
+            m_indexScans++;
+        } else {
+            memset(&entry, 0, sizeof(entry));
+            entry.crc32 = CRC32::calculate(&entry, offsetof(SessionIndexEntry, crc32));
+        }
+        rewrite = true;
+    }
+
+    if (!rewrite) {
+        return true;
+    }
+
+    // Rewrite the whole index in one pass
+    file = SD.open(path, FILE_WRITE);
+    if (!file) {
+        return false;
+    }
+    m_sectorOffset = NO_SECTOR;
+    m_sectorLength = 0;
+    bool ok = streamWrite(file, &header, sizeof(header))
+           && streamWrite(file, m_index, length)
+           && streamFlush(file);
+    file.close();
+    return ok;
+}
+
+void SessionManager::scanSlot(uint8_t slot, SessionIndexEntry& entry) {
+    memset(&entry, 0, sizeof(entry));
+
+    char path[48];
+    makePath(slot, path, sizeof(path));
+    File file = SD.open(path, FILE_READ);
+    if (file) {
+        entry.flags = SESSION_INDEX_USED;
+        entry.fileLength = file.size();
+        m_sectorOffset = NO_SECTOR;
+        uint16_t version = readDirectory(file);
+        entry.formatVersion = version;
+
+        // Name from the header, timestamps and CRC from the masks
+        uint32_t nameOffset = 0;
+        uint32_t timesOffset = offsetof(SessionFile, createdTime);
+        bool found = version == 1;
+        if (version == SESSION_FORMAT_VERSION) {
+            if (matchesPlan(entry.snapshotMask)) {
+                entry.flags |= SESSION_INDEX_PLANNED;
+            }
+            uint8_t parts = 0;
+            for (uint16_t c = 0; c < m_header.chunkCount; c++) {
+                const SessionChunkEntry& chunk = m_chunks[c];
+                if (chunk.type == SESSION_SECTION_HEADER && chunk.length >= sizeof(entry.name)) {
+                    nameOffset = chunk.offset;
+                    parts |= 1;
+                } else if (chunk.type == SESSION_SECTION_MASKS &&
+                           chunk.length >= offsetof(SessionFile, padding) - offsetof(SessionFile, globalZeroMask)) {
+                    timesOffset = chunk.offset + offsetof(SessionFile, createdTime) - offsetof(SessionFile, globalZeroMask);
+                    parts |= 2;
+                }
+            }
+            found = parts == 3;
+        }
+
+        // createdTime, modifiedTime and crc32 are adjacent in both
+        if (found) {
+            readRange(file, nameOffset, (uint8_t*)entry.name, sizeof(entry.name));
+            readRange(file, timesOffset, (uint8_t*)&entry.createdTime, 3 * sizeof(uint32_t));
+            entry.name[sizeof(entry.name) - 1] = '\0';
+        }
+        file.close();
+    }
+
+    entry.crc32 = CRC32::calculate(&entry, offsetof(SessionIndexEntry, crc32));
+}
+
+void SessionManager::updateIndex(uint8_t slot, const SessionFile* session) {
+    if (!m_index) {
+        return;
+    }
+
+    SessionIndexEntry& entry = m_index[slot];
+    memset(&entry, 0, sizeof(entry));
+    if (session) {
+        entry.flags = SESSION_INDEX_USED | (matchesPlan(entry.snapshotMask) ? SESSION_INDEX_PLANNED : 0);
+        entry.formatVersion = SESSION_FORMAT_VERSION;
+        entry.fileLength = m_header.fileLength;
+        memcpy(entry.name, session->name, sizeof(entry.name));
+        entry.name[sizeof(entry.name) - 1] = '\0';
+        entry.createdTime = session->createdTime;
+        entry.modifiedTime = session->modifiedTime;
+        entry.sessionCrc = session->crc32;
+    }
+    entry.crc32 = CRC32::calculate(&entry, offsetof(SessionIndexEntry, crc32));
+
+    // In place; a torn entry fails its CRC and begin() rebuilds it
+    char path[48];
+    snprintf(path, sizeof(path), "%s/index.bin", m_directory);
+    File file = SD.open(path, "r+");
+    if (file) {
+        m_sectorOffset = NO_SECTOR;
+        writeRange(file, sizeof(SessionIndexHeader) + (uint32_t)slot * sizeof(SessionIndexEntry),
+                   (const uint8_t*)&entry, sizeof(entry));
+        file.close();
+        m_sectorOffset = NO_SECTOR;
+    }
+}
+
+bool SessionManager::planFromIndex(uint8_t slot, File& file) {
+    if (!m_index) {
+        return false;
+    }
+    const SessionIndexEntry& entry = m_index[slot];
+    if ((entry.flags & (SESSION_INDEX_USED | SESSION_INDEX_PLANNED)) != (SESSION_INDEX_USED | SESSION_INDEX_PLANNED) ||
+        entry.formatVersion != SESSION_FORMAT_VERSION) {
+        return false;
+    }
+
+    planChunks(entry.snapshotMask, m_header, m_chunks);
+    return m_header.fileLength == entry.fileLength && entry.fileLength == file.size();
+}
+
+bool SessionManager::matchesPlan(uint16_t& snapshotMask) const {
+    snapshotMask = 0;
+    for (uint16_t c = 0; c < m_header.chunkCount; c++) {
+        if (m_chunks[c].type == SESSION_SECTION_SNAPSHOT && m_chunks[c].index < NUM_SNAPSHOTS) {
+            snapshotMask |= (1 << m_chunks[c].index);
+        }
+    }
+
+    SessionFileHeader header;
+    SessionChunkEntry chunks[SESSION_MAX_CHUNKS];
+    planChunks(snapshotMask, header, chunks);
+    return header.chunkCount == m_header.chunkCount
+        && header.fileLength == m_header.fileLength
+        && memcmp(chunks, m_chunks, (uint32_t)header.chunkCount * sizeof(SessionChunkEntry)) == 0;
+}
+
+// ============================================================================
+// Preload Cache
+// ============================================================================
+
+uint8_t SessionManager::setCacheSize(uint8_t count) {
+    count = min(count, MAX_CACHED);
+
+    while (m_cacheSize > count) {
+        m_cacheSize--;
+        heap_caps_free(m_cache[m_cacheSize].session);
+        m_cache[m_cacheSize] = {nullptr, NO_SLOT, 0};
+    }
+
+    // 109 KB each: PSRAM only, never internal RAM
+    while (m_cacheSize < count) {
+        SessionFile* session = (SessionFile*)heap_caps_malloc(sizeof(SessionFile), MALLOC_CAP_SPIRAM);
+        if (!session) {
+            break;
+        }
+        m_cache[m_cacheSize++] = {session, NO_SLOT, 0};
+    }
+    return m_cacheSize;
+}
+
+bool SessionManager::preload(uint8_t slot) {
+    if (slot >= NUM_SESSIONS || !m_sector) {
+        return false;
+    }
+
+    CachedSession* cached = cacheSlot(slot);
+    if (!cached) {
+        return false;
+    }
+    if (cached->slot != slot) {
+        cached->slot = NO_SLOT;
+        if (!loadFile(slot, *cached->session)) {
+            return false;
+        }
+        cached->slot = slot;
+    }
+    cached->lastUsed = ++m_cacheClock;
+    return true;
+}
+
+bool SessionManager::isCached(uint8_t slot) const {
+    for (uint8_t i = 0; i < m_cacheSize; i++) {
+        if (m_cache[i].slot == slot) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SessionManager::CachedSession* SessionManager::findCached(uint8_t slot) {
+    for (uint8_t i = 0; i < m_cacheSize; i++) {
+        if (m_cache[i].slot == slot) {
+            return &m_cache[i];
+        }
+    }
+    return nullptr;
+}
+
+SessionManager::CachedSession* SessionManager::cacheSlot(uint8_t slot) {
+    CachedSession* victim = nullptr;
+    for (uint8_t i = 0; i < m_cacheSize; i++) {
+        CachedSession& entry = m_cache[i];
+        if (entry.slot == slot) {
+            return &entry;
+        }
+        if (!victim || (victim->slot != NO_SLOT && (entry.slot == NO_SLOT || entry.lastUsed < victim->lastUsed))) {
+            victim = &entry;
+        }
+    }
+    return victim;
+}
+
+// ============================================================================
+// Conversion
+// ============================================================================
+
+bool SessionManager::convert(uint8_t slot, SessionFile& scratch) {
+    uint16_t version = getFormatVersion(slot);
+    if (version == SESSION_FORMAT_VERSION) {
+        return true;
+    }
+    return version == 1 && load(slot, scratch) && save(slot, scratch);
+}
+
+uint16_t SessionManager::getFormatVersion(uint8_t slot) {
+    if (slot >= NUM_SESSIONS || !m_sector) {
+        return 0;
+    }
+
+    char path[48];
+    makePath(slot, path, sizeof(path));
+    File file = SD.open(path, FILE_READ);
+    if (!file) {
+        return 0;
+    }
+
+    m_sectorOffset = NO_SECTOR;
+    uint16_t version = readDirectory(file);
+    file.close();
+    return version;
+}
+
+bool SessionManager::streamWrite(File& file, const void* src, uint32_t length, uint32_t* crc) {
+    const uint8_t* bytes = (const uint8_t*)src;
+    if (crc) {
+        *crc = CRC32::update(*crc, bytes, length);
+    }
+    bool ok = true;
+
+    // m_sectorLength bytes are pending in m_sector; the file position is
+    // always sector-aligned behind them
+    while (ok && length > 0) {
+        if (m_sectorLength == 0 && length >= SECTOR_SIZE) {
+            uint32_t count = min(length - length % SECTOR_SIZE, (uint32_t)CHUNK_SIZE);
+            ok = file.write(bytes, count) == count;
+            bytes += count;
+            length -= count;
+            if (length >= SECTOR_SIZE) {
+                yield();
+            }
+        } else {
+            uint32_t count = min(length, (uint32_t)(SECTOR_SIZE - m_sectorLength));
+            memcpy(m_sector + m_sectorLength, bytes, count);
+            m_sectorLength += count;
+            bytes += count;
+            length -= count;
+            if (m_sectorLength == SECTOR_SIZE) {
+                ok = file.write(m_sector, SECTOR_SIZE) == SECTOR_SIZE;
+                m_sectorLength = 0;
+            }
+        }
+    }
+    return ok;
+}
+
+bool SessionManager::streamFlush(File& file) {
+    bool ok = m_sectorLength == 0 || file.write(m_sector, m_sectorLength) == m_sectorLength;
+    m_sectorLength = 0;
+    return ok;
+}
+
+bool SessionManager::writeRange(File& file, uint32_t offset, const uint8_t* src, uint32_t length) {
+    if (offset + length > file.size()) {
+        return false;
+    }
+
+    // Partial head sector: read-modify-write
+    if (offset % SECTOR_SIZE != 0 || length < SECTOR_SIZE) {
+        uint32_t sectorOffset = offset - offset % SECTOR_SIZE;
+        if (!loadSector(file, sectorOffset)) {
+            return false;
+        }
+        uint32_t count = min(length, (uint32_t)(sectorOffset + SECTOR_SIZE - offset));
+        memcpy(m_sector + (offset - sectorOffset), src, count);
+        if (!file.seek(sectorOffset) || file.write(m_sector, m_sectorLength) != m_sectorLength) {
+            return false;
+        }
+        offset += count;
+        src += count;
+        length -= count;
+    }
+
+    // Whole sectors straight from the source, a chunk at a time
+    uint32_t whole = length - length % SECTOR_SIZE;
+    if (whole > 0) {
+        if (!file.seek(offset)) {
+            return false;
+        }
+        while (whole > 0) {
+            uint32_t count = min(whole, (uint32_t)CHUNK_SIZE);
+            if (file.write(src, count) != count) {
+                return false;
+            }
+            offset += count;
+            src += count;
+            length -= count;
+            whole -= count;
+            if (whole > 0) {
+                yield();
+            }
+        }
+    }
+
+    // Partial tail sector: read-modify-write
+    if (length > 0) {
+        if (!loadSector(file, offset)) {
+            return false;
+        }
+        memcpy(m_sector, src, length);
+        if (!file.seek(offset) || file.write(m_sector, m_sectorLength) != m_sectorLength) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ============================================================================
+// Recovery
+// ============================================================================
+
+bool SessionManager::recover(uint8_t slot) {
+    char path[48], tempPath[48], backupPath[48], journalPath[48];
+    makePath(slot, path, sizeof(path));
+    makePath(slot, tempPath, sizeof(tempPath), "tmp");
+    makePath(slot, backupPath, sizeof(backupPath), "bak");
+    makePath(slot, journalPath, sizeof(journalPath), "jnl");
+
+    bool leftover = false;
+
+    // Section save: replay a complete journal, drop a torn one
+    if (SD.exists(journalPath)) {
+        replayJournal(slot);
+        SD.remove(journalPath);
+        leftover = true;
+    }
+
+    // Full save cut between the two renames: .tmp is complete (it is only
+    // renamed after closing), so finish the save; else restore .bak
+    if (SD.exists(backupPath)) {
+        if (!SD.exists(path)) {
+            SD.rename(SD.exists(tempPath) ? tempPath : backupPath, path);
+        }
+        if (SD.exists(backupPath)) {
+            SD.remove(backupPath);
+        }
+        leftover = true;
+    }
+
+    // Full save cut while writing .tmp: the old file is intact
+    if (SD.exists(tempPath)) {
+        SD.remove(tempPath);
+        leftover = true;
+    }
+
+    if (leftover) {
+        m_recoveredCount++;
+    }
+    return leftover;
+}
+
+bool SessionManager::replayJournal(uint8_t slot) {
+    char path[48], journalPath[48];
+    makePath(slot, path, sizeof(path));
+    makePath(slot, journalPath, sizeof(journalPath), "jnl");
+
+    File journal = SD.open(journalPath, FILE_READ);
+    if (!journal) {
+        return false;
+    }
+
+    SessionJournalHeader header;
+    uint8_t buffer[SECTOR_SIZE];
+    bool ok = journal.read((uint8_t*)&header, sizeof(header)) == sizeof(header)
+           && header.magic == SESSION_JOURNAL_MAGIC
+           && journal.size() == sizeof(header) + header.length + sizeof(uint32_t);
+
+    // Pass 1: the records must be complete before anything is applied
+    uint32_t crc = 0;
+    for (uint32_t done = 0; ok && done < header.length; ) {
+        uint32_t count = min(header.length - done, (uint32_t)SECTOR_SIZE);
+        ok = journal.read(buffer, count) == count;
+        crc = CRC32::update(crc, buffer, count);
+        done += count;
+    }
+    uint32_t stored = 0;
+    ok = ok && journal.read((uint8_t*)&stored, sizeof(stored)) == sizeof(stored) && stored == crc;
+
+    // Pass 2: copy each record into the session file
+    File file;
+    if (ok) {
+        file = SD.open(path, "r+");
+        ok = (bool)file && journal.seek(sizeof(header));
+    }
+    m_sectorOffset = NO_SECTOR;
+    for (uint16_t r = 0; ok && r < header.recordCount; r++) {
+        SessionJournalRecord record;
+        ok = journal.read((uint8_t*)&record, sizeof(record)) == sizeof(record);
+        for (uint32_t done = 0; ok && done < record.length; ) {
+            uint32_t count = min(record.length - done, (uint32_t)SECTOR_SIZE);
+            ok = journal.read(buffer, count) == count
+              && writeRange(file, record.offset + done, buffer, count);
+            done += count;
+        }
+    }
+    m_sectorOffset = NO_SECTOR;
+
+    if (file) {
+        file.close();
+    }
+    journal.close();
+    return ok;
+}
+
+// ============================================================================
+// Layout
+// ============================================================================
+
+bool SessionManager::getSectionRange(SessionSection section, uint8_t index, uint32_t& offset, uint32_t& length) {
+    switch (section) {
+        case SESSION_SECTION_HEADER:
+            offset = 0;
+            length = offsetof(SessionFile, controls);
+            return true;
+
+        case SESSION_SECTION_CONTROLS:
+            offset = offsetof(SessionFile, controls);
+            length = sizeof(((SessionFile*)nullptr)->controls);
+            return true;
+
+        case SESSION_SECTION_SNAPSHOT:
+        case SESSION_SECTION_MASKS:
+            return sessionChunkRange(section, index, offset, length);
+
+        default:
+            return false;
+    }
+}
+
+void SessionManager::planChunks(uint16_t snapshotMask, SessionFileHeader& header, SessionChunkEntry* chunks) {
+    uint16_t count = 0;
+    chunks[count++] = {SESSION_SECTION_HEADER, 0, 0, 0, 0};
+    for (uint8_t b = 0; b < SESSION_CONTROL_BLOCKS; b++) {
+        chunks[count++] = {SESSION_SECTION_CONTROLS, b, 0, 0, 0};
+    }
+    for (uint8_t i = 0; i < NUM_SNAPSHOTS; i++) {
+        if (snapshotMask & (1 << i)) {
+            chunks[count++] = {SESSION_SECTION_SNAPSHOT, i, 0, 0, 0};
+        }
+    }
+    chunks[count++] = {SESSION_SECTION_MASKS, 0, 0, 0, 0};
+    chunks[count++] = {SESSION_CHUNK_END, 0, 0, 0, 0};
+
+    // Payloads follow the directory, each behind its TLV header
+    uint32_t position = sizeof(SessionFileHeader) + (uint32_t)count * sizeof(SessionChunkEntry);
+    for (uint16_t c = 0; c < count; c++) {
+        uint32_t offset, length = 0;
+        sessionChunkRange(chunks[c].type, chunks[c].index, offset, length);
+        position += sizeof(SessionChunkHeader);
+        chunks[c].offset = position;
+        chunks[c].length = length;
+        position += length;
+    }
+
+    header.magic = SESSION_FORMAT_MAGIC;
+    header.version = SESSION_FORMAT_VERSION;
+    header.chunkCount = count;
+    header.fileLength = position;
+    header.reserved = 0;
+}
+
+uint16_t SessionManager::storedSnapshots(const SessionFile& session) {
+    uint16_t mask = 0;
+    for (uint8_t i = 0; i < NUM_SNAPSHOTS; i++) {
+        if (!isSnapshotEmpty(session.snapshots[i])) {
+            mask |= (1 << i);
+        }
+    }
+    return mask;
+}
+
+bool SessionManager::isSnapshotEmpty(const Snapshot& snapshot) {
+    // Its own crc32 does not count (it is recomputed on save)
+    const uint8_t* bytes = (const uint8_t*)&snapshot;
+    for (uint32_t i = 0; i < offsetof(Snapshot, crc32); i++) {
+        if (bytes[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t SessionManager::getCompactSize(const SessionFile& session) {
+    SessionFileHeader header;
+    SessionChunkEntry chunks[SESSION_MAX_CHUNKS];
+    planChunks(storedSnapshots(session), header, chunks);
+    return header.fileLength;
+}
+
+uint32_t SessionManager::getLegacySize() {
+    return offsetof(SessionFile, padding);
+}
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+void SessionManager::makePath(uint8_t slot, char* path, size_t size, const char* extension) const {
+    snprintf(path, size, "%s/session%03u.%s", m_directory, slot, extension);
+}
+
+void SessionManager::recordSection(SessionSection section, bool save, uint32_t elapsedUs, uint32_t bytes) {
+    SessionSectionStats& stats = m_stats[section];
+    if (save) {
+        stats.lastSaveUs = elapsedUs;
+        if (elapsedUs > stats.maxSaveUs) {
+            stats.maxSaveUs = elapsedUs;
+        }
+    } else {
+        stats.lastLoadUs = elapsedUs;
+        if (elapsedUs > stats.maxLoadUs) {
+            stats.maxLoadUs = elapsedUs;
+        }
+    }
+    stats.bytes = bytes;
+}
+
+void SessionManager::recordTotal(bool save, uint32_t elapsedUs) {
+    if (save) {
+        m_lastSaveUs = elapsedUs;
+    } else {
+        m_lastLoadUs = elapsedUs;
+    }
+    if (m_budgetUs > 0 && elapsedUs > m_budgetUs) {
+        m_overBudgetCount++;
+    }
+}
+
+#endif // ESP32 || NATIVE_BUILD
@@ -0,0 +1,505 @@
+#ifndef SESSION_MANAGER_H
+#define SESSION_MANAGER_H
+
+#include <Arduino.h>
+#include <Protocol.h>
+
+#if defined(ESP32) || defined(NATIVE_BUILD)
+#include <SD.h>
+#include <CRC32.h>
+#include <ControlBitset.h>
+#include "SessionFormat.h"
+
+/**
+ * Timing of one section type, summed over its chunks in the last
+ * load/save that touched it
+ */
+struct SessionSectionStats {
+    uint32_t lastLoadUs;
+    uint32_t maxLoadUs;
+    uint32_t lastSaveUs;
+    uint32_t maxSaveUs;
+    uint32_t bytes;             // Bytes moved by the last load or save
+};
+
+/**
+ * SessionManager - Session Storage on SD (ESP32 WiFi Node)
+ *
+ * Sessions are stored one file per slot (0-127) in the compact chunk
+ * container (SessionFormat.h): only meaningful bytes, about 47 KB with
+ * every snapshot in use instead of the 109 KB SessionFile. Nothing reads
+ * or writes the whole struct at once:
+ *
+ * - Every SD transfer starts on a 512-byte sector boundary and covers
+ *   whole sectors; a partial sector at either end of a range goes through
+ *   a one-sector buffer (read-modify-write when saving a section in place).
+ *   Long ranges move in 4 KB chunks with yield() in between, so the web
+ *   server and WiFi stack keep running during a load.
+ * - Sections load by offset from the chunk directory: the controls alone,
+ *   a single snapshot or the masks, without touching the rest of the file.
+ *   Chunk payloads are read straight into the struct.
+ * - Saves of an existing section overwrite its chunk in place; padding,
+ *   reserved bytes and empty snapshots are never written.
+ * - Saves survive power loss. A full save writes "sessionNNN.tmp" and
+ *   renames it over the old file (kept as ".bak" until the new one is in
+ *   place). A section save goes through a write-ahead journal (".jnl").
+ *   begin() finishes or rolls back whatever a power loss interrupted.
+ * - Snapshot and session CRC-32s are computed as chunks stream out and
+ *   checked as they stream in; a mismatch fails the load.
+ * - Differential autosave: edits to the attached working session are
+ *   tracked per control, snapshot and section, and saveChanges() journals
+ *   only those bytes (runs of changed ControlConfigs, changed snapshots,
+ *   masks), so autosave I/O scales with the edits, not the session.
+ * - Files in the old fixed layout (version 1) still load, and are
+ *   converted by the next full save or by convert().
+ * - An index file ("index.bin") holds each slot's name, timestamps, CRC
+ *   and layout. begin() reads it in one go and rebuilds only entries that
+ *   disagree with the card, so listing sessions never opens their files,
+ *   and section loads plan their reads from it without the directory.
+ * - Preload cache: a few sessions (recently loaded, or preload()ed as the
+ *   next set-list entries) stay in PSRAM, so switching to one is a memcpy.
+ *   Saves keep cached copies in step with the card.
+ *
+ * Every load and save is timed per section (getSectionStats()), and whole
+ * loads/saves are checked against a time budget (setBudgetUs()).
+ *
+ * Typical usage:
+ *   SessionManager sessions;
+ *   sessions.begin();
+ *
+ *   sessions.save(slot, session);
+ *   sessions.load(slot, session);
+ *   sessions.loadSection(slot, SESSION_SECTION_SNAPSHOT, session, 3);
+ *
+ *   // List sessions; keep the next song ready in PSRAM
+ *   const SessionIndexEntry* info = sessions.getSessionInfo(slot);
+ *   sessions.setCacheSize(4);
+ *   sessions.preload(nextSlot);
+ *
+ *   // Autosave the working session every 5 minutes
+ *   sessions.attach(slot, &session);
+ *   sessions.enableAutoSave(true);
+ *   session.controls[id] = config;
+ *   sessions.markControlChanged(id);
+ *   sessions.checkAutoSave();   // From loop()
+ *
+ * Note: One caller at a time (main loop); not interrupt safe.
+ */
+class SessionManager {
+public:
+    static const uint16_t SECTOR_SIZE = 512;
+    static const uint16_t CHUNK_SIZE = 4096;    // 8 sectors per transfer
+    static const uint8_t MAX_CACHED = 8;        // Preloaded sessions (109 KB each)
+
+    SessionManager();
+    ~SessionManager();
+
+    /**
+     * Initialize (SD must already be mounted) and recover saves
+     * interrupted by a power loss
+     * @param directory - Session directory (created if missing)
+     * @return true if the directory is usable
+     */
+    bool begin(const char* directory = "/sessions");
+
+    /**
+     * Check if a slot holds a session (from the index once begin() ran)
+     */
+    bool exists(uint8_t slot);
+
+    /**
+     * Delete a session
+     * @return true if it was deleted
+     */
+    bool remove(uint8_t slot);
+
+    /**
+     * Number of slots holding a session (from the index)
+     */
+    uint8_t getSessionCount() const;
+
+    /**
+     * Index entry of a slot: name, timestamps, CRC and size, without
+     * touching the card
+     * @return nullptr if the slot is empty (or before begin())
+     */
+    const SessionIndexEntry* getSessionInfo(uint8_t slot) const;
+
+    /**
+     * Load a whole session (all sections), from the cache if it is there
+     * @param slot - Session slot (0-127)
+     * @param session - Destination
+     * @return true if successful
+     */
+    bool load(uint8_t slot, SessionFile& session);
+
+    /**
+     * Load one section into its place in a SessionFile
+     * @param slot - Session slot
+     * @param section - Section to load
+     * @param session - Destination (other sections untouched)
+     * @param index - Snapshot index for SESSION_SECTION_SNAPSHOT
+     * @return true if successful
+     */
+    bool loadSection(uint8_t slot, SessionSection section, SessionFile& session, uint8_t index = 0);
+
+    /**
+     * Save a whole session (atomically replaces the file)
+     * @param slot - Session slot
+     * @param session - Session to save (its crc32 fields are updated)
+     * @return true if successful
+     */
+    bool save(uint8_t slot, SessionFile& session);
+
+    /**
+     * Save one section in place (the session file must exist; falls back
+     * to a full save for old-format files or a snapshot not yet stored).
+     * The session CRC is recomputed from RAM, so the other sections of
+     * `session` must match the stored file.
+     * @param slot - Session slot
+     * @param section - Section to save
+     * @param session - Source (its crc32 fields are updated)
+     * @param index - Snapshot index for SESSION_SECTION_SNAPSHOT
+     * @return true if successful
+     */
+    bool saveSection(uint8_t slot, SessionSection section, SessionFile& session, uint8_t index = 0);
+
+    /**
+     * Rewrite an old fixed-layout session in the compact format
+     * @param slot - Session slot
+     * @param scratch - Working buffer for the session
+     * @return true if the slot is in the compact format afterwards
+     */
+    bool convert(uint8_t slot, SessionFile& scratch);
+
+    /**
+     * Attach the working session for change tracking and autosave
+     * (call after loading or saving it, so it matches the file)
+     * @param slot - Slot the session is stored in
+     * @param session - Working session (nullptr to detach)
+     */
+    void attach(uint8_t slot, SessionFile* session);
+
+    /**
+     * Record edits to the attached session
+     * @param globalID - Control whose ControlConfig changed
+     * @param index - Snapshot that changed
+     */
+    void markControlChanged(uint16_t globalID);
+    void markSnapshotChanged(uint8_t index);
+    void markHeaderChanged() { m_headerChanged = true; }
+    void markMasksChanged() { m_masksChanged = true; }
+
+    /**
+     * Check if the attached session has unsaved edits
+     */
+    bool isModified() const;
+
+    /**
+     * Write only the edits to the attached session (journaled, in place).
+     * Falls back to a full save when a changed snapshot is not stored yet
+     * or the file is in the old format.
+     * @return true if the file matches the session afterwards
+     */
+    bool saveChanges();
+
+    /**
+     * Enable periodic autosave of the attached session
+     * @param enabled - true to autosave
+     * @param intervalMs - Interval between saves (5 minutes default)
+     */
+    void enableAutoSave(bool enabled, uint32_t intervalMs = 300000);
+
+    /**
+     * Save changes once the autosave interval has passed (call from loop())
+     * @return true if an autosave was written
+     */
+    bool checkAutoSave();
+
+    /**
+     * Set how many sessions stay preloaded (buffers in PSRAM)
+     * @param count - Sessions to keep (0 frees the cache, at most MAX_CACHED)
+     * @return Buffers actually allocated
+     */
+    uint8_t setCacheSize(uint8_t count);
+
+    /**
+     * Load a session into the cache ahead of use (next set-list entry),
+     * evicting the least recently used one
+     * @return true if the session is cached
+     */
+    bool preload(uint8_t slot);
+
+    /**
+     * Check if a session is in the cache
+     */
+    bool isCached(uint8_t slot) const;
+
+    /**
+     * On-disk format of a slot
+     * @return SESSION_FORMAT_VERSION, 1 for the old fixed layout, 0 if none
+     */
+    uint16_t getFormatVersion(uint8_t slot);
+
+    /**
+     * Set the time budget for a whole load or save
+     * @param budgetUs - Budget in microseconds (0 = none)
+     */
+    void setBudgetUs(uint32_t budgetUs) { m_budgetUs = budgetUs; }
+
+    /**
+     * Get statistics
+     */
+    const SessionSectionStats& getSectionStats(SessionSection section) const { return m_stats[section]; }
+    uint32_t getLastLoadUs() const { return m_lastLoadUs; }
+    uint32_t getLastSaveUs() const { return m_lastSaveUs; }
+    uint32_t getLastSaveBytes() const { return m_lastSaveBytes; }   // Session bytes written
+    uint32_t getOverBudgetCount() const { return m_overBudgetCount; }
+    uint32_t getCrcErrorCount() const { return m_crcErrorCount; }
+    uint32_t getRecoveredCount() const { return m_recoveredCount; }
+    uint32_t getCacheHits() const { return m_cacheHits; }
+    uint32_t getCacheMisses() const { return m_cacheMisses; }
+    uint8_t getIndexScanCount() const { return m_indexScans; }     // Files rescanned by begin()
+
+    /**
+     * In-memory range of a section (the file range in the old fixed layout)
+     * @param section - Section
+     * @param index - Snapshot index
+     * @param offset - Output offset
+     * @param length - Output length in bytes
+     * @return true if the section/index is valid
+     */
+    static bool getSectionRange(SessionSection section, uint8_t index, uint32_t& offset, uint32_t& length);
+
+    /**
+     * Size of a session in the compact format
+     */
+    static uint32_t getCompactSize(const SessionFile& session);
+
+    /**
+     * Size of a session in the old fixed layout (everything before the padding)
+     */
+    static uint32_t getLegacySize();
+
+private:
+    // One in-place write: session bytes at memOffset to file fileOffset
+    struct JournalRange {
+        uint32_t fileOffset;
+        uint32_t memOffset;
+        uint32_t length;
+    };
+    static const uint8_t MAX_JOURNAL_RANGES = 32;
+
+    // One preloaded session
+    struct CachedSession {
+        SessionFile* session;       // PSRAM buffer
+        uint8_t slot;               // NO_SLOT if unused
+        uint32_t lastUsed;          // LRU clock
+    };
+    static const uint8_t NO_SLOT = 0xFF;
+
+    char m_directory[32];
+    uint8_t* m_sector;              // One-sector buffer for partial sectors
+    uint32_t m_sectorOffset;        // File offset held in m_sector (or NO_SECTOR)
+    uint32_t m_sectorLength;        // Valid bytes in m_sector (pending bytes while saving)
+    static const uint32_t NO_SECTOR = 0xFFFFFFFF;
+
+    SessionFileHeader m_header;     // Directory of the open file
+    SessionChunkEntry m_chunks[SESSION_MAX_CHUNKS];
+
+    SessionSectionStats m_stats[SESSION_SECTION_COUNT];
+
+    SessionIndexEntry* m_index;     // NUM_SESSIONS entries (nullptr before begin())
+    uint8_t m_indexScans;
+
+    CachedSession m_cache[MAX_CACHED];
+    uint8_t m_cacheSize;
+    uint32_t m_cacheClock;
+    uint32_t m_cacheHits;
+    uint32_t m_cacheMisses;
+
+    // Attached working session and its unsaved edits
+    SessionFile* m_current;
+    uint8_t m_currentSlot;
+    ControlBitset m_changedControls;
+    uint16_t m_changedSnapshots;    // Bit per snapshot
+    bool m_headerChanged;
+    bool m_masksChanged;
+
+    bool m_autoSave;
+    uint32_t m_autoSaveIntervalMs;
+    uint32_t m_lastAutoSave;
+
+    uint32_t m_lastLoadUs;
+    uint32_t m_lastSaveUs;
+    uint32_t m_lastSaveBytes;
+    uint32_t m_budgetUs;
+    uint32_t m_overBudgetCount;
+    uint32_t m_crcErrorCount;
+    uint32_t m_recoveredCount;
+
+    /**
+     * Build a slot's file path
+     * @param extension - "bin", or "tmp"/"bak"/"jnl" while saving
+     */
+    void makePath(uint8_t slot, char* path, size_t size, const char* extension = "bin") const;
+
+    /**
+     * Load a whole session from the card
+     */
+    bool loadFile(uint8_t slot, SessionFile& session);
+
+    /**
+     * Read the index and rebuild entries that disagree with the card
+     * @param present - Bit per slot with a session file
+     * @param sizes - Session file size per slot
+     * @param recovered - Bit per slot recovered after a power loss
+     * @return true if the index file is in step
+     */
+    bool loadIndex(const uint32_t* present, const uint32_t* sizes, const uint32_t* recovered);
+
+    /**
+     * Build a slot's index entry from its session file
+     */
+    void scanSlot(uint8_t slot, SessionIndexEntry& entry);
+
+    /**
+     * Update a slot's index entry after a save (m_chunks describes the
+     * file) and write it in place
+     * @param session - Saved session (nullptr = slot removed)
+     */
+    void updateIndex(uint8_t slot, const SessionFile* session);
+
+    /**
+     * Plan m_header/m_chunks from the index instead of the directory
+     * @return false if the index has no usable layout for the file
+     */
+    bool planFromIndex(uint8_t slot, File& file);
+
+    /**
+     * Stored snapshots in m_chunks, and whether the directory is the one
+     * planChunks() makes for them
+     */
+    bool matchesPlan(uint16_t& snapshotMask) const;
+
+    /**
+     * Find a cached session (nullptr if not cached)
+     */
+    CachedSession* findCached(uint8_t slot);
+
+    /**
+     * Cache entry for a slot: its own, a free one or the least recently used
+     * @return nullptr if the cache is off
+     */
+    CachedSession* cacheSlot(uint8_t slot);
+
+    /**
+     * Read the file header and chunk directory of an open file
+     * @return SESSION_FORMAT_VERSION, 1 for the old fixed layout, 0 if invalid
+     */
+    uint16_t readDirectory(File& file);
+
+    /**
+     * Plan the file header and chunk directory
+     * @param snapshotMask - Snapshots to store (bit per snapshot)
+     */
+    static void planChunks(uint16_t snapshotMask, SessionFileHeader& header, SessionChunkEntry* chunks);
+
+    /**
+     * Non-empty snapshots of a session (bit per snapshot)
+     */
+    static uint16_t storedSnapshots(const SessionFile& session);
+
+    /**
+     * Compact format: read one chunk into the session, checking a
+     * snapshot's CRC
+     * @param sessionCrc - Running session CRC to continue (nullptr = none)
+     * @param bytes - Output payload bytes read
+     * @return false on I/O or CRC error
+     */
+    bool readChunk(File& file, const SessionChunkEntry& chunk, SessionFile& session,
+                   uint32_t* sessionCrc, uint32_t& bytes);
+
+    /**
+     * Compact format: read the chunks of one section into the session
+     * @param index - Snapshot index (ignored for other sections)
+     * @return false on I/O or CRC error
+     */
+    bool readChunks(File& file, SessionSection section, uint8_t index, SessionFile& session);
+
+    /**
+     * Session CRC over the chunks in m_chunks, from RAM
+     */
+    uint32_t computeSessionCrc(const SessionFile& session) const;
+
+    /**
+     * Write a journal of session ranges, then apply it in place
+     */
+    bool writeJournaled(uint8_t slot, const SessionFile& session, const JournalRange* ranges, uint8_t count);
+
+    /**
+     * Build journal ranges for the attached session's edits (uses m_chunks)
+     * @param wholeBlocks - Whole control blocks instead of runs of changed controls
+     * @return false if the ranges do not fit in MAX_JOURNAL_RANGES
+     */
+    bool planChanges(bool wholeBlocks, JournalRange* ranges, uint8_t& count) const;
+
+    /**
+     * Forget tracked edits (the file matches the session)
+     */
+    void clearChanges();
+
+    /**
+     * Finish or roll back an interrupted save of one slot
+     * @return true if anything was left over
+     */
+    bool recover(uint8_t slot);
+
+    /**
+     * Replay a complete journal into the session file
+     * @return false if the journal is torn or invalid
+     */
+    bool replayJournal(uint8_t slot);
+
+    /**
+     * Old fixed layout: read one section at its struct offset
+     */
+    bool readLegacySection(File& file, SessionSection section, uint8_t index, SessionFile& session);
+
+    /**
+     * Sequential sector-aligned writes (m_sector holds the pending partial
+     * sector), optionally continuing a CRC over the bytes
+     */
+    bool streamWrite(File& file, const void* src, uint32_t length, uint32_t* crc = nullptr);
+    bool streamFlush(File& file);
+
+    /**
+     * Check if a snapshot's stored bytes are all zero (not stored)
+     */
+    static bool isSnapshotEmpty(const Snapshot& snapshot);
+
+    /**
+     * Sector-aligned transfers of [offset, offset + length)
+     */
+    bool readRange(File& file, uint32_t offset, uint8_t* dest, uint32_t length, uint32_t* crc = nullptr);
+    bool writeRange(File& file, uint32_t offset, const uint8_t* src, uint32_t length);
+
+    /**
+     * Load the sector at a sector-aligned offset into m_sector
+     */
+    bool loadSector(File& file, uint32_t sectorOffset);
+
+    /**
+     * Record a timed section transfer
+     */
+    void recordSection(SessionSection section, bool save, uint32_t elapsedUs, uint32_t bytes);
+
+    /**
+     * Record a whole load or save against the budget
+     */
+    void recordTotal(bool save, uint32_t elapsedUs);
+};
+
+#endif // ESP32 || NATIVE_BUILD
+
+#endif // SESSION_MANAGER_H
@@ -1,6 +1,10 @@
 #include "ShiftRegisterDMA.h"
 
-#ifdef ESP32
+#if defined(ESP32) || defined(NATIVE_BUILD)
+
+#if defined(ESP32)
+#include <soc/gpio_struct.h>
+#endif
 
 ShiftRegisterDMA::ShiftRegisterDMA(spi_host_device_t host, int misoPin, int sckPin, int latchPin, uint8_t numBytes)
     : m_host(host)
@@ -12,19 +16,42 @@ ShiftRegisterDMA::ShiftRegisterDMA(spi_host_device_t host, int misoPin, int sckP
     , m_dmaBuffer(nullptr)
     , m_lastTransferTime(0)
     , m_dmaInProgress(false)
+    , m_latchMissed(false)
+    , m_latchSetReg(nullptr)
+    , m_latchClearReg(nullptr)
+    , m_latchMask(0)
+    , m_latchCycles(0)
+    , m_continuous(false)
+    , m_heldIndex(-1)
+    , m_inFlight(0)
+    , m_frameCount(0)
+    , m_frameReadyCallback(nullptr)
+    , m_frameReadyArg(nullptr)
 {
-    // Allocate DMA-capable buffer (must be 4-byte aligned)
-    m_dmaBuffer = (uint8_t*)heap_caps_malloc(m_numBytes, MALLOC_CAP_DMA);
-    memset(m_dmaBuffer, 0, m_numBytes);
+    // Allocate DMA-capable buffers (must be 4-byte aligned)
+    for (uint8_t i = 0; i < 2; i++) {
+        m_dmaBuffers[i] = (uint8_t*)heap_caps_malloc(m_numBytes, MALLOC_CAP_DMA);
+        memset(m_dmaBuffers[i], 0, m_numBytes);
+
+        memset(&m_trans[i], 0, sizeof(m_trans[i]));
+        m_trans[i].length = m_numBytes * 8;     // Length in bits
+        m_trans[i].rxlength = m_numBytes * 8;
+        m_trans[i].user = this;
+        m_trans[i].rx_buffer = m_dmaBuffers[i];
+    }
+    m_dmaBuffer = m_dmaBuffers[0];
 }
 
 ShiftRegisterDMA::~ShiftRegisterDMA() {
     if (m_spiHandle) {
+        stopContinuous();
         spi_bus_remove_device(m_spiHandle);
         spi_bus_free(m_host);
     }
-    if (m_dmaBuffer) {
-        heap_caps_free(m_dmaBuffer);
+    for (uint8_t i = 0; i < 2; i++) {
+        if (m_dmaBuffers[i]) {
+            heap_caps_free(m_dmaBuffers[i]);
+        }
     }
 }
 
@@ -33,6 +60,13 @@ bool ShiftRegisterDMA::begin(uint32_t clockSpeedHz) {
     pinMode(m_latchPin, OUTPUT);
     digitalWrite(m_latchPin, HIGH);
 
+#if defined(ESP32)
+    m_latchMask = 1UL << (m_latchPin & 31);
+    m_latchSetReg = (m_latchPin < 32) ? &GPIO.out_w1ts : &GPIO.out1_w1ts.val;
+    m_latchClearReg = (m_latchPin < 32) ? &GPIO.out_w1tc : &GPIO.out1_w1tc.val;
+    m_latchCycles = getCpuFrequencyMhz() * LATCH_PULSE_US;
+#endif
+
     // Configure SPI bus
     spi_bus_config_t busConfig = {
         .mosi_io_num = -1,              // Not used
@@ -63,9 +97,9 @@ bool ShiftRegisterDMA::begin(uint32_t clockSpeedHz) {
         .input_delay_ns = 0,
         .spics_io_num = -1,             // No CS pin (using latch pin)
         .flags = 0,
-        .queue_size = 1,
-        .pre_cb = nullptr,
-        .post_cb = nullptr
+        .queue_size = 2,                // Ping-pong: one transferring, one queued
+        .pre_cb = preTransferISR,
+        .post_cb = postTransferISR
     };
 
     ret = spi_bus_add_device(m_host, &devConfig, &m_spiHandle);
@@ -74,39 +108,40 @@ bool ShiftRegisterDMA::begin(uint32_t clockSpeedHz) {
         return false;
     }
 
+    m_frameCount = 0;
     return true;
 }
 
-bool ShiftRegisterDMA::startDMA() {
-    if (m_dmaInProgress) {
-        return false;  // DMA already in progress
+bool ShiftRegisterDMA::startDMA(bool latchFirst) {
+    if (m_continuous) {
+        return false;
     }
 
-    uint32_t startTime = micros();
+    // An overrun transfer (waitForDMA() timed out) is collected once it
+    // lands; its frame is stale and dropped
+    if (m_dmaInProgress && !isDMAComplete()) {
+        return false;  // DMA still in progress
+    }
 
-    // Latch shift register inputs
-    latch();
+    uint32_t startTime = micros();
 
-    // Prepare SPI transaction
-    spi_transaction_t trans = {
-        .flags = 0,
-        .cmd = 0,
-        .addr = 0,
-        .length = m_numBytes * 8,       // Length in bits
-        .rxlength = m_numBytes * 8,
-        .user = nullptr,
-        .tx_buffer = nullptr,
-        .rx_buffer = m_dmaBuffer
-    };
+    // Latch shift register inputs (also when the tick's latch was skipped)
+    if (latchFirst || m_latchMissed) {
+        m_latchMissed = false;
+        latch();
+    }
 
-    // Start DMA transfer (non-blocking)
-    esp_err_t ret = spi_device_queue_trans(m_spiHandle, &trans, 0);
-    if (ret == ESP_OK) {
-        m_dmaInProgress = true;
+    // Start DMA transfer (non-blocking). Marked in progress before it is
+    // queued: the transfer may start at once, and a tick in between must
+    // not latch mid-shift.
+    m_dmaBuffer = m_dmaBuffers[0];
+    m_dmaInProgress = true;
+    if (queueTransfer(0, 0)) {
         m_lastTransferTime = micros() - startTime;
         return true;
     }
 
+    m_dmaInProgress = false;
     return false;
 }
 
@@ -119,6 +154,7 @@ bool ShiftRegisterDMA::isDMAComplete() {
     esp_err_t ret = spi_device_get_trans_result(m_spiHandle, &rtrans, 0);
 
     if (ret == ESP_OK) {
+        m_inFlight--;
         m_dmaInProgress = false;
         return true;
     }
@@ -135,6 +171,7 @@ bool ShiftRegisterDMA::waitForDMA(uint32_t timeoutMs) {
     esp_err_t ret = spi_device_get_trans_result(m_spiHandle, &rtrans, pdMS_TO_TICKS(timeoutMs));
 
     if (ret == ESP_OK) {
+        m_inFlight--;
         m_dmaInProgress = false;
         return true;
     }
@@ -142,6 +179,76 @@ bool ShiftRegisterDMA::waitForDMA(uint32_t timeoutMs) {
     return false;  // Timeout
 }
 
+bool ShiftRegisterDMA::startContinuous() {
+    if (!m_spiHandle || m_continuous || m_dmaInProgress) {
+        return false;
+    }
+
+    // Latching moves into the pre-transfer callback from here on
+    m_continuous = true;
+    m_heldIndex = -1;
+
+    if (!queueTransfer(0, 0) || !queueTransfer(1, 0)) {
+        stopContinuous();
+        return false;
+    }
+
+    return true;
+}
+
+void ShiftRegisterDMA::stopContinuous() {
+    if (!m_continuous) {
+        return;
+    }
+
+    // Collect whatever is still queued so the driver holds no buffer pointers
+    spi_transaction_t* rtrans;
+    while (m_inFlight > 0 &&
+           spi_device_get_trans_result(m_spiHandle, &rtrans, pdMS_TO_TICKS(100)) == ESP_OK) {
+        m_inFlight--;
+    }
+
+    m_heldIndex = -1;
+    m_continuous = false;
+}
+
+const uint8_t* ShiftRegisterDMA::waitForFrame(uint32_t timeoutMs) {
+    if (!m_continuous) {
+        return nullptr;
+    }
+
+    // Caller forgot releaseFrame(): requeue so the ping-pong keeps running
+    if (m_heldIndex >= 0) {
+        releaseFrame();
+    }
+
+    spi_transaction_t* rtrans;
+    esp_err_t ret = spi_device_get_trans_result(m_spiHandle, &rtrans, pdMS_TO_TICKS(timeoutMs));
+    if (ret != ESP_OK) {
+        return nullptr;
+    }
+
+    m_inFlight--;
+    m_heldIndex = (rtrans == &m_trans[1]) ? 1 : 0;
+    m_dmaBuffer = m_dmaBuffers[m_heldIndex];
+    return m_dmaBuffer;
+}
+
+void ShiftRegisterDMA::releaseFrame() {
+    if (!m_continuous || m_heldIndex < 0) {
+        return;
+    }
+
+    uint8_t index = m_heldIndex;
+    m_heldIndex = -1;
+    queueTransfer(index, 0);
+}
+
+void ShiftRegisterDMA::setFrameReadyCallback(FrameReadyCallback callback, void* arg) {
+    m_frameReadyArg = arg;
+    m_frameReadyCallback = callback;
+}
+
 const uint8_t* ShiftRegisterDMA::getDMABuffer() const {
     return m_dmaBuffer;
 }
@@ -164,12 +271,64 @@ bool ShiftRegisterDMA::getBit(uint16_t bitIndex) {
     return (m_dmaBuffer[byteIndex] & (1 << bitOffset)) != 0;
 }
 
-void ShiftRegisterDMA::latch() {
+bool ShiftRegisterDMA::queueTransfer(uint8_t index, TickType_t ticksToWait) {
+    if (spi_device_queue_trans(m_spiHandle, &m_trans[index], ticksToWait) != ESP_OK) {
+        return false;
+    }
+    m_inFlight++;
+    return true;
+}
+
+void IRAM_ATTR ShiftRegisterDMA::preTransferISR(spi_transaction_t* trans) {
+    ShiftRegisterDMA* self = (ShiftRegisterDMA*)trans->user;
+
+    // Single-shot mode latches in startDMA(); continuous mode latches here
+    // so a queued transfer samples the inputs when it actually starts
+    if (self->m_continuous) {
+        self->latch();
+    }
+}
+
+void IRAM_ATTR ShiftRegisterDMA::postTransferISR(spi_transaction_t* trans) {
+    ShiftRegisterDMA* self = (ShiftRegisterDMA*)trans->user;
+
+    self->m_frameCount++;
+
+    if (self->m_frameReadyCallback) {
+        self->m_frameReadyCallback((const uint8_t*)trans->rx_buffer, self->m_frameReadyArg);
+    }
+}
+
+bool IRAM_ATTR ShiftRegisterDMA::latchIfIdle() {
+    if (m_dmaInProgress) {
+        m_latchMissed = true;
+        return false;
+    }
+    latch();
+    return true;
+}
+
+void IRAM_ATTR ShiftRegisterDMA::latch() {
     // Pulse latch LOW to load parallel inputs
+#if defined(ESP32)
+    // Called from the tick and pre-transfer ISRs: write the GPIO set/clear
+    // registers directly and hold on the cycle counter instead of
+    // digitalWrite() / delayMicroseconds()
+    uint32_t start;
+    *m_latchClearReg = m_latchMask;
+    start = ESP.getCycleCount();
+    while (ESP.getCycleCount() - start < m_latchCycles) {
+    }
+    *m_latchSetReg = m_latchMask;
+    start = ESP.getCycleCount();
+    while (ESP.getCycleCount() - start < m_latchCycles) {
+    }
+#else
     digitalWrite(m_latchPin, LOW);
-    delayMicroseconds(1);
+    delayMicroseconds(LATCH_PULSE_US);
     digitalWrite(m_latchPin, HIGH);
-    delayMicroseconds(1);
+    delayMicroseconds(LATCH_PULSE_US);
+#endif
 }
 
-#endif // ESP32
+#endif // ESP32 || NATIVE_BUILD
@@ -3,7 +3,7 @@
 
 #include <Arduino.h>
 
-#ifdef ESP32
+#if defined(ESP32) || defined(NATIVE_BUILD)
 #include <driver/spi_master.h>
 
 /**
@@ -18,6 +18,8 @@
  * - 10MHz+ clock speeds possible
  * - ~5µs for 16 bytes (128 bits) on ESP32
  *
+ * - Continuous ping-pong mode (next frame clocks in while the CPU decodes)
+ *
  * Typical usage:
  *   ShiftRegisterDMA sr(VSPI, MISO_PIN, SCK_PIN, LATCH_PIN, 16);
  *   sr.begin();
@@ -25,10 +27,32 @@
  *   while (!sr.isDMAComplete()) { taskYIELD(); }
  *   const uint8_t* data = sr.getDMABuffer();
  *
+ * Continuous mode:
+ *   Two DMA buffers are queued back to back. The driver's pre-transfer
+ *   callback latches the inputs right before each transfer, so while the
+ *   task decodes one buffer the other is already being filled. The task
+ *   blocks on the driver's result queue instead of polling:
+ *
+ *   sr.startContinuous();
+ *   while (1) {
+ *       const uint8_t* data = sr.waitForFrame();
+ *       if (data) { decode(data); sr.releaseFrame(); }
+ *   }
+ *
+ *   An optional frame-ready callback runs from the SPI ISR as each frame
+ *   lands (e.g. to notify another task).
+ *
  * Note: ESP32-specific using SPI peripheral
  */
 class ShiftRegisterDMA {
 public:
+    /**
+     * Frame-ready callback (runs in SPI interrupt context - keep it short)
+     * @param frame - Buffer that was just filled
+     * @param arg - User argument from setFrameReadyCallback()
+     */
+    typedef void (*FrameReadyCallback)(const uint8_t* frame, void* arg);
+
     /**
      * Constructor
      * @param host - SPI host (VSPI_HOST or HSPI_HOST)
@@ -49,9 +73,28 @@ public:
 
     /**
      * Start DMA read operation (non-blocking)
+     * A transfer left over from a timed-out waitForDMA() is collected
+     * first; while it is still running this returns false.
+     * @param latchFirst - Pulse the latch before the transfer. Pass false
+     *                     when latch() was already called at the sample
+     *                     instant (e.g. from a ScanScheduler tick ISR).
+     *                     A latch skipped by latchIfIdle() is done here.
      * @return true if DMA started successfully
      */
-    bool startDMA();
+    bool startDMA(bool latchFirst = true);
+
+    /**
+     * Pulse the latch to load the parallel inputs (ISR-safe, after begin())
+     */
+    void latch();
+
+    /**
+     * Pulse the latch unless a transfer is shifting (ISR-safe). Latching
+     * mid-shift would reload the chain and corrupt the frame; a skipped
+     * latch is done by the next startDMA() instead.
+     * @return true if the latch was pulsed
+     */
+    bool latchIfIdle();
 
     /**
      * Check if DMA read is complete
@@ -61,14 +104,59 @@ public:
 
     /**
      * Wait for DMA to complete (blocking)
+     * On timeout the transfer stays outstanding; startDMA() collects it.
      * @param timeoutMs - Timeout in milliseconds
      * @return true if completed, false if timeout
      */
     bool waitForDMA(uint32_t timeoutMs = 100);
 
+    /**
+     * Start continuous ping-pong scanning
+     * Queues both buffers; each transfer latches the inputs first.
+     * @return true if both transfers were queued
+     */
+    bool startContinuous();
+
+    /**
+     * Stop continuous scanning (waits for in-flight transfers)
+     */
+    void stopContinuous();
+
+    /**
+     * Wait for the next completed frame (continuous mode)
+     * Blocks on the SPI driver's result queue; the other buffer keeps
+     * filling meanwhile. Call releaseFrame() when done with the data.
+     * @param timeoutMs - Timeout in milliseconds
+     * @return Pointer to frame, or nullptr on timeout / not running
+     */
+    const uint8_t* waitForFrame(uint32_t timeoutMs = 10);
+
+    /**
+     * Hand the current frame's buffer back for the next transfer
+     */
+    void releaseFrame();
+
+    /**
+     * Check if continuous mode is running
+     */
+    bool isContinuous() const { return m_continuous; }
+
+    /**
+     * Set callback invoked from the SPI ISR when a frame completes
+     * @param callback - Function to call (nullptr to disable)
+     * @param arg - User argument passed to callback
+     */
+    void setFrameReadyCallback(FrameReadyCallback callback, void* arg = nullptr);
+
+    /**
+     * Get number of frames completed since begin()
+     */
+    uint32_t getFrameCount() const { return m_frameCount; }
+
     /**
      * Get pointer to DMA buffer (read-only)
-     * Call this after DMA is complete
+     * Call this after DMA is complete (in continuous mode: the last frame
+     * returned by waitForFrame())
      * @return Pointer to buffer containing shift register data
      */
     const uint8_t* getDMABuffer() const;
@@ -99,12 +187,39 @@ private:
     int m_sckPin;
     int m_latchPin;
     uint8_t m_numBytes;
-    uint8_t* m_dmaBuffer;
+    uint8_t* m_dmaBuffers[2];       // Ping-pong buffers (single-shot uses [0])
+    spi_transaction_t m_trans[2];   // Must outlive the queued transfer
+    uint8_t* m_dmaBuffer;           // Buffer returned by getDMABuffer()
     uint32_t m_lastTransferTime;
-    bool m_dmaInProgress;
+    volatile bool m_dmaInProgress;  // Read by latchIfIdle() in ISR context
+    volatile bool m_latchMissed;    // latchIfIdle() skipped a latch
 
-    void latch();
+    // Latch pulse, resolved by begin() (latch() runs in ISR context)
+    static const uint8_t LATCH_PULSE_US = 1;
+    volatile uint32_t* m_latchSetReg;   // GPIO write-1-to-set / -clear
+    volatile uint32_t* m_latchClearReg;
+    uint32_t m_latchMask;
+    uint32_t m_latchCycles;         // LATCH_PULSE_US in CPU cycles
+
+    // Continuous mode
+    volatile bool m_continuous;
+    int8_t m_heldIndex;             // Buffer owned by the CPU (-1 = none)
+    uint8_t m_inFlight;             // Transfers queued to the driver
+    volatile uint32_t m_frameCount;
+    FrameReadyCallback m_frameReadyCallback;
+    void* m_frameReadyArg;
+
+    /**
+     * Queue transfer into buffer index (0 or 1)
+     */
+    bool queueTransfer(uint8_t index, TickType_t ticksToWait);
+
+    /**
+     * SPI driver callbacks (ISR context, transaction user = this)
+     */
+    static void preTransferISR(spi_transaction_t* trans);
+    static void postTransferISR(spi_transaction_t* trans);
 };
 
-#endif // ESP32
+#endif // ESP32 || NATIVE_BUILD
 #endif // SHIFT_REGISTER_DMA_H
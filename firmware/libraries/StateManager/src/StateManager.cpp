@@ -1,16 +1,46 @@
 #include "StateManager.h"
+#include <ControlMap.h>
 
 StateManager::StateManager()
     : m_configs(nullptr)
+    , m_routes(nullptr)
+    , m_panelIDs(nullptr)
     , m_states(nullptr)
-    , m_currentBank(false)
+    , m_bankBPanels(0)
+    , m_globalZeroMask(0)
+    , m_panelZeroMask(0)
+    , m_bankZeroMask(0)
+    , m_configCallback(nullptr)
+    , m_configArg(nullptr)
 {
     m_configs = new ControlConfig[TOTAL_CONTROLS];
+    m_routes = new ControlRoute[2 * TOTAL_CONTROLS];
+    m_panelIDs = new uint8_t[TOTAL_CONTROLS];
     m_states = new ControlState[TOTAL_CONTROLS];
+
+    // Valid (empty) routes until begin() compiles the configs
+    memset(m_routes, 0, sizeof(ControlRoute) * 2 * TOTAL_CONTROLS);
+    memset(m_panelIDs, 0, TOTAL_CONTROLS);
+    setBank(false);
+
+    m_dirty.clear();
+    m_transitioning.clear();
+    m_recallZeroed.clear();
+    m_sendOnLoad.clear();
+    for (uint8_t panel = 0; panel < MAX_PANEL_IDS; panel++) {
+        m_panelMembers[panel].clear();
+    }
+
+    // Every control starts on panel 0 (m_panelIDs) until begin()
+    for (uint16_t w = 0; w < ControlBitset::NUM_WORDS; w++) {
+        m_panelMembers[0].setWord(w, ControlBitset::wordMask(w));
+    }
 }
 
 StateManager::~StateManager() {
     delete[] m_configs;
+    delete[] m_routes;
+    delete[] m_panelIDs;
     delete[] m_states;
 }
 
@@ -52,6 +82,31 @@ void StateManager::begin() {
         m_states[i].targetValue = 64;
         m_states[i].stateFlags = 0;
     }
+
+    // Control type and panel come from the panel layout
+    for (uint8_t panel = 0; panel < NUM_PANELS; panel++) {
+        for (uint8_t local = 0; local < MAX_LOCAL_CONTROLS; local++) {
+            uint16_t globalID = mapControlID(panel, local);
+            if (globalID != CONTROL_MAP_INVALID) {
+                m_configs[globalID].controlType = mapControlType(panel, local);
+                m_configs[globalID].panelID = panel;
+            }
+        }
+    }
+
+    for (uint16_t i = GLOBAL_SNAPSHOT_BASE; i < TOTAL_CONTROLS; i++) {
+        m_configs[i].controlType = CONTROL_BUTTON;
+        m_configs[i].panelID = PANEL_SNAPSHOT;
+    }
+
+    for (uint16_t i = 0; i < TOTAL_CONTROLS; i++) {
+        updateRoute(i);
+    }
+    setBank(false);
+
+    m_dirty.clear();
+    m_transitioning.clear();
+    setZeroMasks(0, 0, 0);
 }
 
 bool StateManager::setValue(uint16_t globalID, uint8_t value) {
@@ -62,6 +117,7 @@ bool StateManager::setValue(uint16_t globalID, uint8_t value) {
     if (m_states[globalID].value != value) {
         m_states[globalID].value = value;
         m_states[globalID].stateFlags |= STATE_FLAG_DIRTY;
+        m_dirty.set(globalID);
         return true;
     }
 
@@ -86,6 +142,7 @@ void StateManager::setTargetValue(uint16_t globalID, uint8_t value) {
     if (globalID < TOTAL_CONTROLS) {
         m_states[globalID].targetValue = value;
         m_states[globalID].stateFlags |= STATE_FLAG_TRANSITIONING;
+        m_transitioning.set(globalID);
     }
 }
 
@@ -93,19 +150,41 @@ bool StateManager::isDirty(uint16_t globalID) const {
     if (globalID >= TOTAL_CONTROLS) {
         return false;
     }
-    return (m_states[globalID].stateFlags & STATE_FLAG_DIRTY) != 0;
+    return m_dirty.test(globalID);
 }
 
 void StateManager::clearDirty(uint16_t globalID) {
     if (globalID < TOTAL_CONTROLS) {
         m_states[globalID].stateFlags &= ~STATE_FLAG_DIRTY;
         m_states[globalID].lastSentValue = m_states[globalID].value;
+        m_dirty.reset(globalID);
     }
 }
 
 void StateManager::markDirty(uint16_t globalID) {
     if (globalID < TOTAL_CONTROLS) {
         m_states[globalID].stateFlags |= STATE_FLAG_DIRTY;
+        m_dirty.set(globalID);
+    }
+}
+
+void StateManager::clearAllDirty() {
+    m_dirty.forEach([this](uint16_t id) {
+        clearDirty(id);
+    });
+}
+
+void StateManager::setTransitioning(uint16_t globalID, bool transitioning) {
+    if (globalID >= TOTAL_CONTROLS) {
+        return;
+    }
+
+    if (transitioning) {
+        m_states[globalID].stateFlags |= STATE_FLAG_TRANSITIONING;
+        m_transitioning.set(globalID);
+    } else {
+        m_states[globalID].stateFlags &= ~STATE_FLAG_TRANSITIONING;
+        m_transitioning.reset(globalID);
     }
 }
 
@@ -126,9 +205,50 @@ const ControlConfig* StateManager::getConfig(uint16_t globalID) const {
 void StateManager::setConfig(uint16_t globalID, const ControlConfig& config) {
     if (globalID < TOTAL_CONTROLS) {
         m_configs[globalID] = config;
+        updateRoute(globalID);
     }
 }
 
+void StateManager::setConfigCallback(ConfigCallback callback, void* arg) {
+    m_configCallback = callback;
+    m_configArg = arg;
+}
+
+void StateManager::updateRoute(uint16_t globalID) {
+    if (globalID < TOTAL_CONTROLS) {
+        buildControlRoute(m_configs[globalID], false, m_routes[globalID]);
+        buildControlRoute(m_configs[globalID], true, m_routes[TOTAL_CONTROLS + globalID]);
+
+        // Panel membership (move from the previous panel)
+        m_panelMembers[m_panelIDs[globalID]].reset(globalID);
+        m_panelIDs[globalID] = m_configs[globalID].panelID & (MAX_PANEL_IDS - 1);
+        m_panelMembers[m_panelIDs[globalID]].set(globalID);
+
+        if (m_configs[globalID].snapshotFlags != 0) {
+            m_recallZeroed.set(globalID);
+        } else {
+            m_recallZeroed.reset(globalID);
+        }
+
+        if (m_configs[globalID].flags & CONTROL_FLAG_SEND_ON_LOAD) {
+            m_sendOnLoad.set(globalID);
+        } else {
+            m_sendOnLoad.reset(globalID);
+        }
+
+        if (m_configCallback) {
+            m_configCallback(globalID, m_configs[globalID], m_configArg);
+        }
+    }
+}
+
+uint8_t StateManager::getPanel(uint16_t globalID) const {
+    if (globalID >= TOTAL_CONTROLS) {
+        return 0;
+    }
+    return m_panelIDs[globalID];
+}
+
 ControlState* StateManager::getState(uint16_t globalID) {
     if (globalID >= TOTAL_CONTROLS) {
         return nullptr;
@@ -144,27 +264,92 @@ const ControlState* StateManager::getState(uint16_t globalID) const {
 }
 
 void StateManager::setBank(bool useB) {
-    m_currentBank = useB;
+    for (uint8_t panel = 0; panel < MAX_PANEL_IDS; panel++) {
+        setPanelBank(panel, useB);
+    }
+}
 
-    // Update all configs to use new bank
-    for (uint16_t i = 0; i < TOTAL_CONTROLS; i++) {
-        m_configs[i].currentBank = useB ? 1 : 0;
+bool StateManager::setPanelBank(uint8_t panelID, bool useB) {
+    if (panelID >= MAX_PANEL_IDS) {
+        return false;
+    }
+
+    // Point the panel at the other prebuilt table
+    m_panelRoutes[panelID] = useB ? m_routes + TOTAL_CONTROLS : m_routes;
+    if (useB) {
+        m_bankBPanels |= (1 << panelID);
+    } else {
+        m_bankBPanels &= ~(1 << panelID);
     }
+    return true;
 }
 
-void StateManager::loadSnapshot(const Snapshot& snapshot) {
-    for (uint16_t i = 0; i < TOTAL_CONTROLS; i++) {
-        // Check zero mask
-        uint16_t maskIndex = i / 16;
-        uint16_t maskBit = i % 16;
-        bool zeroed = (snapshot.zeroMask[maskIndex] & (1 << maskBit)) != 0;
+bool StateManager::isPanelBankB(uint8_t panelID) const {
+    if (panelID >= MAX_PANEL_IDS) {
+        return false;
+    }
+    return (m_bankBPanels & (1 << panelID)) != 0;
+}
 
-        if (!zeroed) {
-            setValue(i, snapshot.values[i]);
+void StateManager::setZeroMasks(uint32_t globalMask, uint32_t panelMask, uint32_t bankMask) {
+    m_globalZeroMask = globalMask;
+    m_panelZeroMask = panelMask;
+    m_bankZeroMask = bankMask;
+}
+
+void StateManager::getRecallMask(const Snapshot& snapshot, ControlBitset& recall) const {
+    if (m_globalZeroMask != 0) {
+        recall.clear();
+        return;
+    }
+
+    // Panels excluded directly or through their active bank
+    uint16_t zeroPanels = (uint16_t)m_panelZeroMask;
+    if (m_bankZeroMask & 0x01) {
+        zeroPanels |= (uint16_t)~m_bankBPanels;
+    }
+    if (m_bankZeroMask & 0x02) {
+        zeroPanels |= m_bankBPanels;
+    }
+
+    const uint16_t maskWords = sizeof(snapshot.zeroMask) / sizeof(snapshot.zeroMask[0]);
+
+    for (uint16_t w = 0; w < ControlBitset::NUM_WORDS; w++) {
+        // Two 16-bit snapshot mask words per 32 controls
+        uint32_t excluded = snapshot.zeroMask[2 * w];
+        if (2 * w + 1 < maskWords) {
+            excluded |= (uint32_t)snapshot.zeroMask[2 * w + 1] << 16;
         }
+        excluded |= m_recallZeroed.getWord(w);
+
+        uint16_t panels = zeroPanels;
+        while (panels) {
+            uint8_t panel = __builtin_ctz(panels);
+            panels &= panels - 1;
+            excluded |= m_panelMembers[panel].getWord(w);
+        }
+
+        recall.setWord(w, ~excluded & ControlBitset::wordMask(w));
     }
 }
 
+uint16_t StateManager::loadSnapshot(const Snapshot& snapshot) {
+    ControlBitset recall;
+    getRecallMask(snapshot, recall);
+
+    // Only changed values become dirty (send-on-load controls always do)
+    uint16_t changed = 0;
+    recall.forEach([&](uint16_t id) {
+        if (setValue(id, snapshot.values[id])) {
+            changed++;
+        } else if (m_sendOnLoad.test(id)) {
+            markDirty(id);
+        }
+    });
+
+    return changed;
+}
+
 void StateManager::saveSnapshot(Snapshot& snapshot) const {
     for (uint16_t i = 0; i < TOTAL_CONTROLS; i++) {
         snapshot.values[i] = m_states[i].value;
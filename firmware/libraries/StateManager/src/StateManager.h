@@ -3,6 +3,8 @@
 
 #include <Arduino.h>
 #include <Protocol.h>
+#include <ControlRoute.h>
+#include <ControlBitset.h>
 
 /**
  * StateManager - Centralized State Management for All 619 Controls
@@ -13,19 +15,59 @@
  * Features:
  * - 619 control states (O(1) access)
  * - Configuration management
- * - Dirty flag tracking
+ * - Compiled routing table for the event path
+ * - Dirty / transitioning bitsets (walk only the controls that changed)
  * - Value change detection
- * - Bank A/B switching
+ * - Bank A/B switching, globally or per panel, in O(1)
+ * - Snapshot recall through one merged zero mask
+ *
+ * Configs vs routes:
+ * ControlConfig is the editable source of truth (48 bytes, both banks,
+ * label, diagnostics). The per-event path reads a 4-byte ControlRoute per
+ * control instead. Routes for Bank A and Bank B are both compiled whenever
+ * a config changes; after editing a config in place through getConfig(),
+ * call updateRoute() (setConfig() does it automatically). Anything else
+ * compiled from configs must be recompiled on the same path: updateRoute()
+ * reports every change to the setConfigCallback() subscriber
+ * (ValueEngine::begin() subscribes its parameter table).
+ *
+ * Banks:
+ * Each panel points at the Bank A or Bank B route table, so switching a
+ * panel (or all of them) swaps pointers and never touches the controls.
+ * ControlConfig::currentBank is not used; the bank is panel state.
+ *
+ * Recall:
+ * A control is left alone by loadSnapshot() if the snapshot's zeroMask
+ * excludes it, its config has any snapshotFlags bit set, its panel is in
+ * the panel zero mask, its panel's active bank is in the bank zero mask, or
+ * the global zero is set. The control-level flags and panel membership are
+ * kept as bitsets, so the merged mask is built a 32-control word at a time.
+ * Only controls whose value changes are marked dirty (plus controls with
+ * CONTROL_FLAG_SEND_ON_LOAD).
  *
  * Typical usage:
  *   StateManager state;
  *   state.begin();
  *   state.setValue(globalID, 64);
  *   uint8_t value = state.getValue(globalID);
- *   if (state.isDirty(globalID)) { sendMIDI(...); state.clearDirty(globalID); }
+ *   state.getDirtyControls().forEach([&](uint16_t id) {
+ *       sendMIDI(...);
+ *       state.clearDirty(id);
+ *   });
+ *
+ *   const ControlRoute* route = state.getRoute(globalID);
+ *   midi.processControl(*route, value);
  */
 class StateManager {
 public:
+    /**
+     * Config change callback (after the routes are recompiled)
+     * @param globalID - Control ID
+     * @param config - New configuration
+     * @param arg - User argument from setConfigCallback()
+     */
+    typedef void (*ConfigCallback)(uint16_t globalID, const ControlConfig& config, void* arg);
+
     StateManager();
     ~StateManager();
 
@@ -74,6 +116,27 @@ public:
      */
     void markDirty(uint16_t globalID);
 
+    /**
+     * Clear all dirty flags (e.g. after a full save)
+     */
+    void clearAllDirty();
+
+    /**
+     * Set or clear the transitioning flag (TransitionEngine)
+     */
+    void setTransitioning(uint16_t globalID, bool transitioning);
+
+    /**
+     * Get the set of dirty controls (mirrors STATE_FLAG_DIRTY). Walk it with
+     * forEach(); clearDirty() inside the walk is allowed.
+     */
+    const ControlBitset& getDirtyControls() const { return m_dirty; }
+
+    /**
+     * Get the set of controls in a transition (mirrors STATE_FLAG_TRANSITIONING)
+     */
+    const ControlBitset& getTransitioningControls() const { return m_transitioning; }
+
     /**
      * Get control configuration
      */
@@ -85,6 +148,35 @@ public:
      */
     void setConfig(uint16_t globalID, const ControlConfig& config);
 
+    /**
+     * Set callback for config changes (setConfig() and updateRoute())
+     */
+    void setConfigCallback(ConfigCallback callback, void* arg = nullptr);
+
+    /**
+     * Get compiled routing for the control's panel's active bank
+     * @param globalID - Control ID
+     * @return Route, or nullptr if the ID is out of range
+     */
+    const ControlRoute* getRoute(uint16_t globalID) const {
+        if (globalID >= TOTAL_CONTROLS) {
+            return nullptr;
+        }
+        return m_panelRoutes[m_panelIDs[globalID]] + globalID;
+    }
+
+    /**
+     * Recompile a control's Bank A and Bank B routes and recall flags
+     * (after editing its config in place), then notify the config callback
+     * @param globalID - Control ID
+     */
+    void updateRoute(uint16_t globalID);
+
+    /**
+     * Get the panel a control belongs to (config panelID)
+     */
+    uint8_t getPanel(uint16_t globalID) const;
+
     /**
      * Get control state
      */
@@ -92,21 +184,52 @@ public:
     const ControlState* getState(uint16_t globalID) const;
 
     /**
-     * Switch Bank A/B
+     * Switch Bank A/B on all panels
      * @param useB - true for Bank B, false for Bank A
      */
     void setBank(bool useB);
 
     /**
-     * Get current bank
-     * @return true if Bank B active
+     * Check if all panels are on Bank B
+     */
+    bool isBankB() const { return m_bankBPanels == ALL_PANELS; }
+
+    /**
+     * Switch Bank A/B on one panel
+     * @param panelID - Panel (0-15)
+     * @param useB - true for Bank B, false for Bank A
+     * @return true if successful
+     */
+    bool setPanelBank(uint8_t panelID, bool useB);
+
+    /**
+     * Check if a panel is on Bank B
      */
-    bool isBankB() const { return m_currentBank; }
+    bool isPanelBankB(uint8_t panelID) const;
 
     /**
-     * Load all states from snapshot values
+     * Set the session-level zero masks (SessionFile)
+     * @param globalMask - Nonzero: no control is recalled
+     * @param panelMask - Bit per panelID: panel not recalled
+     * @param bankMask - Bit 0 = Bank A, bit 1 = Bank B: panels on that bank
+     *                   not recalled
      */
-    void loadSnapshot(const Snapshot& snapshot);
+    void setZeroMasks(uint32_t globalMask, uint32_t panelMask, uint32_t bankMask);
+
+    /**
+     * Build the set of controls a snapshot recall applies to (all zero
+     * levels merged)
+     * @param snapshot - Snapshot (its zeroMask)
+     * @param recall - Output set
+     */
+    void getRecallMask(const Snapshot& snapshot, ControlBitset& recall) const;
+
+    /**
+     * Load snapshot values into the recalled controls
+     * @param snapshot - Snapshot to recall
+     * @return Number of controls whose value changed (marked dirty)
+     */
+    uint16_t loadSnapshot(const Snapshot& snapshot);
 
     /**
      * Save all values to snapshot
@@ -119,9 +242,31 @@ public:
     uint16_t getTotalControls() const { return TOTAL_CONTROLS; }
 
 private:
-    ControlConfig* m_configs;
+    static const uint8_t MAX_PANEL_IDS = 16;
+    static const uint16_t ALL_PANELS = 0xFFFF;
+
+    ControlConfig* m_configs;       // Cold: editable source of truth
+    ControlRoute* m_routes;         // Hot: Bank A table, then Bank B table
+    uint8_t* m_panelIDs;            // Hot: panel per control
     ControlState* m_states;
-    bool m_currentBank;  // false = A, true = B
+
+    const ControlRoute* m_panelRoutes[MAX_PANEL_IDS];  // Active table per panel
+    uint16_t m_bankBPanels;         // Bit per panel, set = Bank B
+
+    // Bit per control, kept in step with the state flags
+    ControlBitset m_dirty;
+    ControlBitset m_transitioning;
+
+    // Recall: compiled from the configs by updateRoute()
+    ControlBitset m_recallZeroed;                   // Any snapshotFlags bit
+    ControlBitset m_sendOnLoad;                     // CONTROL_FLAG_SEND_ON_LOAD
+    ControlBitset m_panelMembers[MAX_PANEL_IDS];    // Controls per panel
+    uint32_t m_globalZeroMask;
+    uint32_t m_panelZeroMask;
+    uint32_t m_bankZeroMask;
+
+    ConfigCallback m_configCallback;
+    void* m_configArg;
 };
 
 #endif // STATE_MANAGER_H
@@ -0,0 +1,278 @@
+#include "TransitionEngine.h"
+#include <math.h>
+
+uint16_t TransitionEngine::s_easeTables[4][LUT_SIZE];
+bool TransitionEngine::s_tablesBuilt = false;
+
+// 7-bit value on the 14-bit scale (v << 7 | v), so 127 maps to 16383
+static inline uint16_t to14bit(uint8_t value) {
+    return (uint16_t)value * 129;
+}
+
+// Nearest 7-bit value for a 14-bit value
+static inline uint8_t to7bit(uint16_t value14) {
+    uint16_t value = (value14 + 64) >> 7;
+    return value > 127 ? 127 : (uint8_t)value;
+}
+
+TransitionEngine::TransitionEngine()
+    : m_state(nullptr)
+    , m_tracks(nullptr)
+    , m_activeCount(0)
+    , m_type(TRANSITION_LINEAR)
+    , m_stepValue14(0)
+    , m_startTime(0)
+    , m_durationUs(0)
+    , m_progress(0)
+    , m_clock(nullptr)
+    , m_clockSync(false)
+    , m_clockStart(0)
+    , m_clockEnd(0)
+    , m_outputCallback(nullptr)
+    , m_outputArg(nullptr)
+    , m_emittedCount(0)
+{
+    m_tracks = new Track[TOTAL_CONTROLS];
+    m_active.clear();
+}
+
+TransitionEngine::~TransitionEngine() {
+    delete[] m_tracks;
+}
+
+void TransitionEngine::begin(StateManager& state) {
+    m_state = &state;
+    m_active.clear();
+    m_activeCount = 0;
+    m_emittedCount = 0;
+    buildTables();
+}
+
+void TransitionEngine::setOutputCallback(OutputCallback callback, void* arg) {
+    m_outputCallback = callback;
+    m_outputArg = arg;
+}
+
+void TransitionEngine::setClock(const MIDIClock* clock) {
+    m_clock = clock;
+}
+
+uint16_t TransitionEngine::start(const Snapshot& snapshot) {
+    if (!m_state) {
+        return 0;
+    }
+
+    const TransitionSettings& settings = snapshot.transition;
+    bool instant = (settings.type == TRANSITION_INSTANT || settings.duration == 0);
+    uint32_t now = micros();
+
+    m_type = settings.type;
+    m_stepValue14 = to14bit(settings.stepValue > 0 ? settings.stepValue : 1);
+    m_startTime = now;
+    m_progress = 0;
+    m_clockSync = false;
+
+    uint32_t unitUs = 1000;
+    if (settings.timebase == TIMEBASE_MIDI_CLOCK) {
+        if (m_clock && m_clock->isRunning(now)) {
+            // End on the next grid line at least `duration` ticks ahead
+            uint64_t grid = (uint64_t)min(settings.duration, (uint16_t)MUSICAL_TIME_1_BAR) << 16;
+            m_clockStart = m_clock->getPositionQ16(now);
+            m_clockEnd = m_clockStart + ((uint64_t)settings.duration << 16);
+            m_clockEnd = ((m_clockEnd + grid - 1) / grid) * grid;
+            m_clockSync = true;
+        }
+        unitUs = (m_clock && m_clock->hasTempo()) ? m_clock->getTickIntervalUs() : CLOCK_TICK_US;
+    }
+    m_durationUs = settings.duration * unitUs;
+
+    // Controls the recall applies to (snapshot, control, panel, bank and
+    // global zero masks merged); excluded controls in flight stay put
+    ControlBitset recall;
+    m_state->getRecallMask(snapshot, recall);
+
+    m_active.forEach([this, &recall](uint16_t id) {
+        if (!recall.test(id)) {
+            finish(id);
+        }
+    });
+
+    uint16_t moving = 0;
+
+    recall.forEach([&](uint16_t i) {
+        bool inFlight = m_active.test(i);
+
+        ControlState* state = m_state->getState(i);
+        Track& track = m_tracks[i];
+
+        uint8_t target = snapshot.values[i] > 127 ? 127 : snapshot.values[i];
+        uint16_t target14 = to14bit(target);
+
+        // Controls in flight continue from their last emitted position
+        uint16_t current = inFlight ? track.lastEmitted : to14bit(state->value);
+        track.lastEmitted = current;
+        track.highRes = (m_state->getRoute(i)->flags & ROUTE_FLAG_14BIT) != 0;
+
+        if (current == target14) {
+            if (inFlight) {
+                finish(i);
+            }
+            return;
+        }
+
+        track.start = current;
+        track.span = (int16_t)target14 - (int16_t)current;
+        track.target = target;
+        state->targetValue = target;
+        moving++;
+
+        if (instant) {
+            applyValue(i, track, target14);
+            if (inFlight) {
+                finish(i);
+            }
+            return;
+        }
+
+        if (!inFlight) {
+            m_active.set(i);
+            m_activeCount++;
+            m_state->setTransitioning(i, true);
+        }
+    });
+
+    return moving;
+}
+
+void TransitionEngine::update() {
+    if (m_activeCount == 0) {
+        return;
+    }
+
+    uint32_t progress = currentProgress();
+    if (progress == m_progress) {
+        return;  // No time has passed on the Q16 scale
+    }
+    m_progress = progress;
+
+    if (progress >= PROGRESS_ONE) {
+        // Land exactly on the targets
+        m_active.forEach([this](uint16_t id) {
+            Track& track = m_tracks[id];
+            applyValue(id, track, to14bit(track.target));
+            finish(id);
+        });
+        return;
+    }
+
+    // One curve evaluation for the whole tick, then a multiply-add per control
+    int32_t eased = ease(m_type, progress);
+    bool stepped = (m_type == TRANSITION_STEPPED);
+
+    m_active.forEach([this, eased, stepped](uint16_t id) {
+        Track& track = m_tracks[id];
+        int32_t delta = ((int32_t)track.span * eased + (EASE_ONE / 2)) >> 15;
+        if (stepped) {
+            delta = (delta / m_stepValue14) * m_stepValue14;
+        }
+        applyValue(id, track, (uint16_t)(track.start + delta));
+    });
+}
+
+uint32_t TransitionEngine::currentProgress() {
+    if (m_clockSync) {
+        uint64_t position = m_clock->getPositionQ16(micros());
+        if (position < m_clockStart || position >= m_clockEnd) {
+            return PROGRESS_ONE;  // Done, or the song jumped back
+        }
+        return (uint32_t)(((position - m_clockStart) * PROGRESS_ONE) / (m_clockEnd - m_clockStart));
+    }
+
+    uint32_t elapsed = micros() - m_startTime;
+    if (elapsed >= m_durationUs) {
+        return PROGRESS_ONE;
+    }
+    return (uint32_t)(((uint64_t)elapsed * PROGRESS_ONE) / m_durationUs);
+}
+
+void TransitionEngine::cancel(uint16_t globalID) {
+    if (globalID < TOTAL_CONTROLS && m_active.test(globalID)) {
+        finish(globalID);
+    }
+}
+
+void TransitionEngine::cancelAll() {
+    m_active.forEach([this](uint16_t id) {
+        finish(id);
+    });
+}
+
+uint16_t TransitionEngine::ease(TransitionType type, uint32_t progressQ16) {
+    if (progressQ16 >= PROGRESS_ONE) {
+        return EASE_ONE;
+    }
+
+    switch (type) {
+        case TRANSITION_EASE_IN:
+        case TRANSITION_EASE_OUT:
+        case TRANSITION_EASE_IN_OUT:
+        case TRANSITION_EXPONENTIAL: {
+            if (!s_tablesBuilt) {
+                buildTables();
+            }
+            const uint16_t* table = s_easeTables[type - TRANSITION_EASE_IN];
+            uint16_t index = progressQ16 >> 8;
+            int32_t frac = progressQ16 & 0xFF;
+            int32_t a = table[index];
+            int32_t b = table[index + 1];
+            return (uint16_t)(a + (((b - a) * frac) >> 8));
+        }
+
+        default:  // LINEAR, STEPPED
+            return (uint16_t)(progressQ16 >> 1);
+    }
+}
+
+void TransitionEngine::buildTables() {
+    if (s_tablesBuilt) {
+        return;
+    }
+
+    for (uint16_t i = 0; i < LUT_SIZE; i++) {
+        float t = i / (float)(LUT_SIZE - 1);
+        float inv = 1.0f - t;
+        float curves[4] = {
+            t * t,                                                  // EASE_IN
+            1.0f - inv * inv,                                       // EASE_OUT
+            t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * inv * inv,      // EASE_IN_OUT
+            (powf(2.0f, 10.0f * t) - 1.0f) / 1023.0f                // EXPONENTIAL
+        };
+
+        for (uint8_t c = 0; c < 4; c++) {
+            s_easeTables[c][i] = (uint16_t)(curves[c] * EASE_ONE + 0.5f);
+        }
+    }
+
+    s_tablesBuilt = true;
+}
+
+void TransitionEngine::applyValue(uint16_t globalID, Track& track, uint16_t value14) {
+    uint16_t output = track.highRes ? value14 : to14bit(to7bit(value14));
+    if (output == track.lastEmitted) {
+        return;
+    }
+
+    track.lastEmitted = output;
+    m_state->setValue(globalID, to7bit(output));
+    m_emittedCount++;
+
+    if (m_outputCallback) {
+        m_outputCallback(globalID, output, m_outputArg);
+    }
+}
+
+void TransitionEngine::finish(uint16_t globalID) {
+    m_active.reset(globalID);
+    m_activeCount--;
+    m_state->setTransitioning(globalID, false);
+}
@@ -0,0 +1,204 @@
+#ifndef TRANSITION_ENGINE_H
+#define TRANSITION_ENGINE_H
+
+#include <Arduino.h>
+#include <Protocol.h>
+#include <ControlBitset.h>
+#include <StateManager.h>
+#include <MIDIClock.h>
+
+/**
+ * TransitionEngine - Snapshot Morphing (Teensy)
+ *
+ * Moves every recalled control (StateManager::getRecallMask(): all zero
+ * levels merged) from its current value to a snapshot's value along the
+ * snapshot's TransitionSettings curve. All in-flight
+ * controls share one timeline, so each update() evaluates the curve once
+ * (Q16 progress -> Q15 eased position via a 257-entry lookup table with
+ * linear interpolation) and then does one multiply-add per control on its
+ * 14-bit start/span. Only controls still in flight are visited (bitset
+ * walk), and a value is emitted only when it changes at the control's
+ * resolution (7 or 14 bit). With all 619 controls morphing, a tick is a
+ * few microseconds plus the emitted messages.
+ *
+ * Curves:
+ * - INSTANT: jump on start()
+ * - LINEAR, EASE_IN (t^2), EASE_OUT, EASE_IN_OUT (quadratic), EXPONENTIAL (2^10t)
+ * - STEPPED: linear, moving in multiples of stepValue
+ *
+ * Timebases:
+ * - TIMEBASE_MILLISECONDS: duration in ms
+ * - TIMEBASE_MIDI_CLOCK: duration in 24 PPQN ticks. With a running
+ *   MIDIClock (setClock()), progress comes from the clock's song position
+ *   with sub-tick phase, and the end is moved to the next grid line of
+ *   min(duration, 1 bar) - a 2-bar morph ends on a bar line, a 1/16 morph
+ *   on a 1/16. The morph pauses while the clock is stopped and completes
+ *   at once if the song position jumps back. Without a running clock, the
+ *   duration is converted at the clock's last tempo (or 120 BPM).
+ *
+ * StateManager values stay 7-bit: each emitted value is also stored with
+ * setValue(), and controls in flight carry STATE_FLAG_TRANSITIONING and
+ * their targetValue.
+ *
+ * Typical usage:
+ *   TransitionEngine transitions;
+ *   transitions.begin(stateManager);
+ *   transitions.setOutputCallback(sendValue, &midiEngine);
+ *   transitions.setClock(&midiClock);
+ *   transitions.start(snapshot);
+ *
+ *   // Every loop iteration
+ *   transitions.update();
+ *
+ *   // A control touched by hand leaves the transition
+ *   transitions.cancel(event.globalID);
+ */
+class TransitionEngine {
+public:
+    /**
+     * Output callback
+     * @param globalID - Control ID
+     * @param value14 - New value, 14-bit (7-bit controls: value << 7 | value)
+     * @param arg - User argument from setOutputCallback()
+     */
+    typedef void (*OutputCallback)(uint16_t globalID, uint16_t value14, void* arg);
+
+    TransitionEngine();
+    ~TransitionEngine();
+
+    /**
+     * Initialize and build the easing tables
+     * @param state - State manager to read from and write to
+     */
+    void begin(StateManager& state);
+
+    /**
+     * Set callback for emitted values
+     */
+    void setOutputCallback(OutputCallback callback, void* arg = nullptr);
+
+    /**
+     * Set the MIDI clock for TIMEBASE_MIDI_CLOCK transitions
+     * @param clock - Clock tracker (nullptr = fixed 120 BPM)
+     */
+    void setClock(const MIDIClock* clock);
+
+    /**
+     * Check if the running transition follows the MIDI clock
+     */
+    bool isClockSynced() const { return m_clockSync; }
+
+    /**
+     * Start morphing toward a snapshot (restarts controls already in flight
+     * from where they are)
+     * @param snapshot - Target values, zero mask and transition settings
+     * @return Number of controls that will move
+     */
+    uint16_t start(const Snapshot& snapshot);
+
+    /**
+     * Advance all controls in flight (call every loop)
+     */
+    void update();
+
+    /**
+     * Stop one control where it is (e.g. it was moved by hand)
+     */
+    void cancel(uint16_t globalID);
+
+    /**
+     * Stop all controls where they are
+     */
+    void cancelAll();
+
+    /**
+     * Check if a transition is running
+     */
+    bool isActive() const { return m_activeCount > 0; }
+
+    /**
+     * Get number of controls in flight
+     */
+    uint16_t getActiveCount() const { return m_activeCount; }
+
+    /**
+     * Get transition progress (0-65536)
+     */
+    uint32_t getProgress() const { return m_progress; }
+
+    /**
+     * Get number of values emitted
+     */
+    uint32_t getEmittedCount() const { return m_emittedCount; }
+
+    /**
+     * Eased position for a curve
+     * @param type - Curve type
+     * @param progressQ16 - Progress (0-65536)
+     * @return Position (0-32768)
+     */
+    static uint16_t ease(TransitionType type, uint32_t progressQ16);
+
+private:
+    static const uint16_t LUT_SIZE = 257;       // 256 segments, both ends
+    static const uint16_t EASE_ONE = 32768;     // 1.0 in Q15
+    static const uint32_t PROGRESS_ONE = 65536; // 1.0 in Q16
+    static const uint32_t CLOCK_TICK_US = 20833; // 24 PPQN at 120 BPM
+
+    // Easing tables for the non-linear curves (EASE_IN .. EXPONENTIAL)
+    static uint16_t s_easeTables[4][LUT_SIZE];
+    static bool s_tablesBuilt;
+
+    // Per-control track (14-bit values)
+    struct Track {
+        uint16_t start;             // Value at start()
+        int16_t span;               // target - start
+        uint16_t lastEmitted;       // At the control's resolution, 14-bit scale
+        uint8_t target;             // 7-bit target (snapshot value)
+        uint8_t highRes;            // Emit at 14-bit resolution
+    };
+
+    StateManager* m_state;
+    Track* m_tracks;
+    ControlBitset m_active;
+    uint16_t m_activeCount;
+
+    TransitionType m_type;
+    uint16_t m_stepValue14;         // STEPPED step size (14-bit scale)
+    uint32_t m_startTime;           // micros()
+    uint32_t m_durationUs;
+    uint32_t m_progress;            // Q16
+
+    // Clock-synced timeline (song position, ticks << 16)
+    const MIDIClock* m_clock;
+    bool m_clockSync;
+    uint64_t m_clockStart;
+    uint64_t m_clockEnd;
+
+    OutputCallback m_outputCallback;
+    void* m_outputArg;
+    uint32_t m_emittedCount;
+
+    /**
+     * Current progress (0-65536) from the clock or elapsed time
+     */
+    uint32_t currentProgress();
+
+    /**
+     * Build the easing tables (once)
+     */
+    static void buildTables();
+
+    /**
+     * Set a control to a 14-bit value; emit and store it if it changed at
+     * the control's resolution
+     */
+    void applyValue(uint16_t globalID, Track& track, uint16_t value14);
+
+    /**
+     * Remove a control from the transition
+     */
+    void finish(uint16_t globalID);
+};
+
+#endif // TRANSITION_ENGINE_H
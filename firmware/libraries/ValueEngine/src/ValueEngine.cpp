@@ -0,0 +1,214 @@
+#include "ValueEngine.h"
+
+// Normalized speed (8.8) for 0..20 detents/s: (speed - 2) / 18, clamped.
+// Faster than the table is full speed.
+static const uint16_t SPEED_NORM_Q8[21] = {
+    0, 0, 0, 14, 28, 43, 57, 71, 85, 100,
+    114, 128, 142, 156, 171, 185, 199, 213, 228, 242, 256
+};
+
+// Relative encodings carry at most +63/-64
+static const int16_t RELATIVE_MAX = 63;
+static const int16_t RELATIVE_MIN = -64;
+
+static inline int16_t clampDelta(int16_t delta) {
+    return delta > RELATIVE_MAX ? RELATIVE_MAX : (delta < RELATIVE_MIN ? RELATIVE_MIN : delta);
+}
+
+ValueEngine::ValueEngine()
+    : m_params(nullptr)
+    , m_runtime(nullptr)
+    , m_state(nullptr)
+{
+    m_params = new ValueParams[TOTAL_CONTROLS];
+    m_runtime = new ValueRuntime[TOTAL_CONTROLS];
+    memset(m_params, 0, sizeof(ValueParams) * TOTAL_CONTROLS);
+    reset();
+}
+
+ValueEngine::~ValueEngine() {
+    if (m_state) {
+        m_state->setConfigCallback(nullptr);
+    }
+    delete[] m_params;
+    delete[] m_runtime;
+}
+
+void ValueEngine::begin(StateManager& state) {
+    for (uint16_t i = 0; i < TOTAL_CONTROLS; i++) {
+        configure(i, *state.getConfig(i));
+    }
+    reset();
+
+    m_state = &state;
+    state.setConfigCallback(onConfigChanged, this);
+}
+
+void ValueEngine::onConfigChanged(uint16_t globalID, const ControlConfig& config, void* arg) {
+    ((ValueEngine*)arg)->configure(globalID, config);
+}
+
+void ValueEngine::configure(uint16_t globalID, const ControlConfig& config) {
+    if (globalID >= TOTAL_CONTROLS) {
+        return;
+    }
+
+    ValueParams& params = m_params[globalID];
+
+    if (!(config.flags & CONTROL_FLAG_ENABLED)) {
+        params.kind = KIND_DISABLED;
+    } else if (config.controlType == CONTROL_ENCODER) {
+        params.kind = KIND_ENCODER;
+    } else if (config.controlType == CONTROL_BUTTON ||
+               config.controlType == CONTROL_ENCODER_BUTTON ||
+               config.controlType == CONTROL_JOYSTICK_BUTTON) {
+        params.kind = KIND_BUTTON;
+    } else {
+        params.kind = KIND_DIRECT;
+    }
+
+    params.mode = (params.kind == KIND_ENCODER) ? (uint8_t)config.encoderMode : (uint8_t)config.buttonAction;
+    params.minValue = min(config.minValue, config.maxValue);
+    params.maxValue = max(config.minValue, config.maxValue);
+    params.accelGainQ8 = (uint16_t)((config.acceleration * 7UL * 256 + 127) / 255);
+    params.threshold = config.threshold > 0 ? config.threshold : 1;
+    params.buttonValue = config.buttonValue;
+    params.direction = (config.flags & CONTROL_FLAG_INVERTED) ? -1 : 1;
+
+    m_runtime[globalID].accumulator = 0;
+}
+
+bool ValueEngine::process(const EventMessage& event, uint8_t currentValue, ValueResult& result) {
+    if (event.globalID >= TOTAL_CONTROLS) {
+        return false;
+    }
+
+    const ValueParams& params = m_params[event.globalID];
+    ValueRuntime& runtime = m_runtime[event.globalID];
+
+    switch (params.kind) {
+        case KIND_ENCODER:
+            return processEncoder(params, runtime, event, currentValue, result);
+
+        case KIND_BUTTON:
+            return processButton(params, runtime, event, result);
+
+        case KIND_DIRECT: {
+            uint8_t value = constrain(event.value, params.minValue, params.maxValue);
+            result.value = value;
+            result.midiValue = value;
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+bool ValueEngine::getButtonAction(uint16_t globalID, ButtonAction& action) const {
+    if (globalID >= TOTAL_CONTROLS || m_params[globalID].kind != KIND_BUTTON) {
+        return false;
+    }
+    action = (ButtonAction)m_params[globalID].mode;
+    return true;
+}
+
+void ValueEngine::reset() {
+    memset(m_runtime, 0, sizeof(ValueRuntime) * TOTAL_CONTROLS);
+}
+
+uint16_t ValueEngine::accelerationQ8(uint32_t speed, uint16_t gainQ8) {
+    uint16_t norm = speed < 21 ? SPEED_NORM_Q8[speed] : 256;
+    return 256 + (uint16_t)(((uint32_t)norm * gainQ8) >> 8);
+}
+
+bool ValueEngine::processEncoder(const ValueParams& params, ValueRuntime& runtime,
+                                 const EventMessage& event, uint8_t currentValue, ValueResult& result) {
+    // Panel puts the signed detent count in the value byte; a CCW flag with
+    // a magnitude (older senders) means the count is negative
+    int16_t detents = (int8_t)event.value;
+    if ((event.flags & EVENT_FLAG_ENCODER_CCW) && detents > 0) {
+        detents = -detents;
+    }
+    detents *= params.direction;
+
+    // Speed over the time since this control's last event (panel clock)
+    uint32_t interval = event.timestamp - runtime.lastTimestamp;
+    bool haveInterval = runtime.lastTimestamp != 0 && interval > 0;
+    runtime.lastTimestamp = event.timestamp;
+
+    // Hold back small movements until they add up to the threshold
+    runtime.accumulator += detents;
+    if (abs(runtime.accumulator) < params.threshold) {
+        return false;
+    }
+    int16_t delta = runtime.accumulator;
+    runtime.accumulator = 0;
+
+    if (params.accelGainQ8 > 0 && haveInterval) {
+        uint32_t speed = (uint32_t)abs(delta) * 1000000UL / interval;
+        int32_t scaled = (int32_t)delta * accelerationQ8(speed, params.accelGainQ8);
+        delta = (int16_t)(scaled / 256);
+    }
+
+    int16_t value = (int16_t)currentValue + delta;
+    value = constrain(value, (int16_t)params.minValue, (int16_t)params.maxValue);
+    result.value = (uint8_t)value;
+
+    switch (params.mode) {
+        case ENCODER_RELATIVE_1:
+            result.midiValue = (uint8_t)(64 + clampDelta(delta));
+            return true;
+
+        case ENCODER_RELATIVE_2:
+            if (delta == 1 || delta == -1) {
+                result.midiValue = delta > 0 ? 65 : 63;
+            } else {
+                result.midiValue = delta > 0 ? 127 : 0;
+            }
+            return true;
+
+        case ENCODER_RELATIVE_3:
+            result.midiValue = (uint8_t)(clampDelta(delta) & 0x7F);
+            return true;
+
+        default:  // ENCODER_ABSOLUTE
+            result.midiValue = result.value;
+            return result.value != currentValue;  // Pinned at a limit
+    }
+}
+
+bool ValueEngine::processButton(const ValueParams& params, ValueRuntime& runtime,
+                                const EventMessage& event, ValueResult& result) {
+    bool pressed = (event.flags & EVENT_FLAG_BUTTON_PRESSED) != 0;
+    bool inverted = params.direction < 0;
+    uint8_t onValue = inverted ? params.minValue : params.maxValue;
+    uint8_t offValue = inverted ? params.maxValue : params.minValue;
+
+    switch (params.mode) {
+        case BUTTON_CC_TOGGLE:
+            if (!pressed) {
+                return false;
+            }
+            runtime.toggle ^= 1;
+            result.value = runtime.toggle ? onValue : offValue;
+            break;
+
+        case BUTTON_CC_MOMENTARY:
+            result.value = pressed ? onValue : offValue;
+            break;
+
+        case BUTTON_CC_VALUE:
+            if (!pressed) {
+                return false;
+            }
+            result.value = params.buttonValue;
+            break;
+
+        default:
+            return false;  // Not a CC value; caller dispatches the action
+    }
+
+    result.midiValue = result.value;
+    return true;
+}
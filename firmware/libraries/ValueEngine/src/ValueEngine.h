@@ -0,0 +1,145 @@
+#ifndef VALUE_ENGINE_H
+#define VALUE_ENGINE_H
+
+#include <Arduino.h>
+#include <Protocol.h>
+#include <StateManager.h>
+
+/**
+ * Result of processing one event
+ */
+struct ValueResult {
+    uint8_t value;          // New control value (store in StateManager)
+    uint8_t midiValue;      // Data byte to send (relative modes: encoded delta)
+};
+
+/**
+ * ValueEngine - Event to Control Value Conversion (Teensy)
+ *
+ * Panels send raw events: a signed detent delta in EventMessage::value for
+ * encoders, 127/0 for button press/release. ValueEngine turns them into the
+ * control value and the MIDI data byte according to each control's
+ * ControlConfig, using only integer math.
+ *
+ * Config fields are folded into a compact per-control ValueParams entry by
+ * configure(), so process() reads a 10-byte parameter entry and never
+ * touches the 48-byte ControlConfig. begin() subscribes to the
+ * StateManager's config callback, so setConfig() / updateRoute() keep the
+ * entries current.
+ *
+ * Encoders:
+ * - threshold: detents accumulate until |sum| >= threshold
+ * - acceleration (0-255): speed from the panel's event timestamps; at full
+ *   strength 2 detents/s = 1x up to 20+ detents/s = 8x (same curve as
+ *   EncoderDecoder::getAcceleratedDelta)
+ * - ENCODER_ABSOLUTE: value += delta, clamped to [minValue, maxValue]
+ * - ENCODER_RELATIVE_1: binary offset (64 + delta)
+ * - ENCODER_RELATIVE_2: 65/63 for single steps, 127/0 for faster turns
+ * - ENCODER_RELATIVE_3: 7-bit two's complement (1 = +1, 127 = -1)
+ * - CONTROL_FLAG_INVERTED reverses direction
+ * Relative modes still track the absolute value for display and snapshots.
+ *
+ * Buttons:
+ * - BUTTON_CC_TOGGLE: each press flips between minValue and maxValue
+ * - BUTTON_CC_MOMENTARY: press = maxValue, release = minValue
+ * - BUTTON_CC_VALUE: press = buttonValue
+ * - Other actions (program change, bank switch, snapshots, panic) produce
+ *   no CC value; the caller looks them up with getButtonAction()
+ *
+ * Typical usage:
+ *   ValueEngine values;
+ *   values.begin(stateManager);
+ *
+ *   ValueResult result;
+ *   if (values.process(event, stateManager.getValue(event.globalID), result)) {
+ *       stateManager.setValue(event.globalID, result.value);
+ *       midiEngine.processControl(*stateManager.getRoute(event.globalID), result.midiValue);
+ *   }
+ */
+class ValueEngine {
+public:
+    ValueEngine();
+    ~ValueEngine();
+
+    /**
+     * Precompute parameters for all controls and follow later config changes
+     * @param state - State manager holding the configs
+     */
+    void begin(StateManager& state);
+
+    /**
+     * Recompute one control's parameters (after its config changed)
+     * @param globalID - Control ID
+     * @param config - New configuration
+     */
+    void configure(uint16_t globalID, const ControlConfig& config);
+
+    /**
+     * Process one event (globalID already mapped)
+     * @param event - Event from the I2C master
+     * @param currentValue - Control's current value
+     * @param result - Output value and MIDI data byte
+     * @return true if there is something to send
+     */
+    bool process(const EventMessage& event, uint8_t currentValue, ValueResult& result);
+
+    /**
+     * Get a button's action (for the actions process() leaves to the caller)
+     * @param globalID - Control ID
+     * @param action - Output action
+     * @return true if the control is an enabled button
+     */
+    bool getButtonAction(uint16_t globalID, ButtonAction& action) const;
+
+    /**
+     * Clear accumulated deltas, timing and toggle states
+     */
+    void reset();
+
+    /**
+     * Acceleration multiplier in 8.8 fixed point
+     * @param speed - Detents per second
+     * @param gainQ8 - Per-control gain (accel * 7 / 255, 8.8 fixed point)
+     */
+    static uint16_t accelerationQ8(uint32_t speed, uint16_t gainQ8);
+
+private:
+    enum ValueKind : uint8_t {
+        KIND_DISABLED = 0,
+        KIND_ENCODER = 1,
+        KIND_BUTTON = 2,
+        KIND_DIRECT = 3         // Value passes through (clamped)
+    };
+
+    // Precomputed from ControlConfig
+    struct ValueParams {
+        ValueKind kind;
+        uint8_t mode;           // EncoderMode or ButtonAction
+        uint8_t minValue;       // Range, min <= max
+        uint8_t maxValue;
+        uint16_t accelGainQ8;   // 0 = no acceleration
+        uint8_t threshold;      // >= 1
+        uint8_t buttonValue;
+        int8_t direction;       // +1, or -1 if inverted
+    };
+
+    // Runtime per control
+    struct ValueRuntime {
+        uint32_t lastTimestamp; // Panel micros() of the previous event
+        int16_t accumulator;    // Detents below threshold
+        uint8_t toggle;
+    };
+
+    ValueParams* m_params;
+    ValueRuntime* m_runtime;
+    StateManager* m_state;      // Config callback subscription
+
+    static void onConfigChanged(uint16_t globalID, const ControlConfig& config, void* arg);
+
+    bool processEncoder(const ValueParams& params, ValueRuntime& runtime,
+                        const EventMessage& event, uint8_t currentValue, ValueResult& result);
+    bool processButton(const ValueParams& params, ValueRuntime& runtime,
+                       const EventMessage& event, ValueResult& result);
+};
+
+#endif // VALUE_ENGINE_H
@@ -0,0 +1,126 @@
+#ifndef ARDUINO_SHIM_H
+#define ARDUINO_SHIM_H
+
+/**
+ * Arduino.h - Minimal Arduino Core Shim for Host Builds
+ *
+ * Provides just enough of the Arduino, ESP32 and Teensy core API for the
+ * shared firmware libraries to compile and run unchanged on Linux/macOS.
+ * Only used by the native PlatformIO environment (NATIVE_BUILD).
+ *
+ * Host-only controls (manual clock, pin levels, SPI frame source) live in
+ * NativeShim.h.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+#define A0 14
+#define A1 15
+
+#define IRAM_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+using std::min;
+using std::max;
+using std::abs;
+
+// ============================================================================
+// TIMING
+// ============================================================================
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// ============================================================================
+// GPIO
+// ============================================================================
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+int digitalPinToInterrupt(int pin);
+void attachInterrupt(int interruptNum, void (*handler)(), int mode);
+void detachInterrupt(int interruptNum);
+
+// Host builds have no real interrupts; these only gate pin handlers
+void noInterrupts();
+void interrupts();
+
+// ============================================================================
+// MATH
+// ============================================================================
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// ============================================================================
+// SERIAL
+// ============================================================================
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud);
+
+    size_t print(const char* str);
+    size_t print(char c);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    size_t println(const char* str);
+    size_t println(char c);
+    size_t println(int value, int base = DEC);
+    size_t println(unsigned int value, int base = DEC);
+    size_t println(long value, int base = DEC);
+    size_t println(unsigned long value, int base = DEC);
+    size_t println(double value, int digits = 2);
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    int available() { return 0; }
+    int read() { return -1; }
+
+    explicit operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif // ARDUINO_SHIM_H
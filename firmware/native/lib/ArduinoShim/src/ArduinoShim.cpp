@@ -0,0 +1,328 @@
+#include "Arduino.h"
+#include "NativeShim.h"
+
+#include <stdarg.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// ============================================================================
+// TIMING
+// ============================================================================
+
+static const std::chrono::steady_clock::time_point s_startTime = std::chrono::steady_clock::now();
+static std::atomic<bool> s_manualClock(false);
+static std::atomic<uint64_t> s_manualMicros(0);
+
+static uint64_t elapsedMicros() {
+    if (s_manualClock.load(std::memory_order_relaxed)) {
+        return s_manualMicros.load(std::memory_order_relaxed);
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - s_startTime).count();
+}
+
+uint32_t millis() {
+    return (uint32_t)(elapsedMicros() / 1000);
+}
+
+uint32_t micros() {
+    return (uint32_t)elapsedMicros();
+}
+
+void delay(uint32_t ms) {
+    if (s_manualClock.load(std::memory_order_relaxed)) {
+        s_manualMicros.fetch_add((uint64_t)ms * 1000);
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    if (s_manualClock.load(std::memory_order_relaxed)) {
+        s_manualMicros.fetch_add(us);
+        return;
+    }
+
+    // Busy-wait like the cores do; sleeping would overshoot by ~50µs
+    uint64_t target = elapsedMicros() + us;
+    while (elapsedMicros() < target) {
+    }
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+void shimUseManualClock(bool manual) {
+    if (manual) {
+        s_manualMicros.store(elapsedMicros());
+    }
+    s_manualClock.store(manual);
+}
+
+void shimAdvanceMicros(uint32_t us) {
+    s_manualMicros.fetch_add(us);
+}
+
+void shimSetMicros(uint64_t us) {
+    s_manualMicros.store(us);
+}
+
+// ============================================================================
+// GPIO
+// ============================================================================
+
+static const uint8_t NUM_PINS = 64;
+static int s_pinLevels[NUM_PINS];
+
+// Pin interrupts, raised synchronously on the thread that changes the level
+static void (*s_pinHandlers[NUM_PINS])();
+static int s_pinModes[NUM_PINS];
+static std::atomic<bool> s_interruptsEnabled(true);
+
+static void setPinLevel(uint8_t pin, int value) {
+    if (pin >= NUM_PINS) {
+        return;
+    }
+
+    int previous = s_pinLevels[pin];
+    s_pinLevels[pin] = value;
+
+    void (*handler)() = s_pinHandlers[pin];
+    if (!handler || !s_interruptsEnabled.load() || previous == value) {
+        return;
+    }
+
+    bool rising = value != LOW;
+    int mode = s_pinModes[pin];
+    if (mode == CHANGE || (mode == RISING && rising) || (mode == FALLING && !rising)) {
+        handler();
+    }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < NUM_PINS && mode == INPUT_PULLUP) {
+        s_pinLevels[pin] = HIGH;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    setPinLevel(pin, value);
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < NUM_PINS ? s_pinLevels[pin] : LOW;
+}
+
+int analogRead(uint8_t pin) {
+    return pin < NUM_PINS ? s_pinLevels[pin] : 0;
+}
+
+int digitalPinToInterrupt(int pin) {
+    return pin;
+}
+
+void attachInterrupt(int interruptNum, void (*handler)(), int mode) {
+    if (interruptNum >= 0 && interruptNum < NUM_PINS) {
+        s_pinModes[interruptNum] = mode;
+        s_pinHandlers[interruptNum] = handler;
+    }
+}
+
+void detachInterrupt(int interruptNum) {
+    if (interruptNum >= 0 && interruptNum < NUM_PINS) {
+        s_pinHandlers[interruptNum] = nullptr;
+    }
+}
+
+void noInterrupts() {
+    s_interruptsEnabled.store(false);
+}
+
+void interrupts() {
+    s_interruptsEnabled.store(true);
+}
+
+void shimSetPin(uint8_t pin, int value) {
+    setPinLevel(pin, value);
+}
+
+int shimGetPin(uint8_t pin) {
+    return pin < NUM_PINS ? s_pinLevels[pin] : LOW;
+}
+
+// ============================================================================
+// MATH
+// ============================================================================
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// ============================================================================
+// SERIAL
+// ============================================================================
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long /*baud*/) {
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+}
+
+static size_t printNumber(unsigned long value, int base) {
+    switch (base) {
+        case HEX: return ::printf("%lX", value);
+        case BIN: {
+            char buf[sizeof(unsigned long) * 8 + 1];
+            int i = sizeof(buf) - 1;
+            buf[i] = '\0';
+            do {
+                buf[--i] = (value & 1) ? '1' : '0';
+                value >>= 1;
+            } while (value && i > 0);
+            return ::printf("%s", &buf[i]);
+        }
+        default: return ::printf("%lu", value);
+    }
+}
+
+size_t HardwareSerial::print(const char* str) { return ::printf("%s", str); }
+size_t HardwareSerial::print(char c) { return ::printf("%c", c); }
+size_t HardwareSerial::print(int value, int base) {
+    return base == DEC ? ::printf("%d", value) : printNumber((unsigned int)value, base);
+}
+size_t HardwareSerial::print(unsigned int value, int base) { return printNumber(value, base); }
+size_t HardwareSerial::print(long value, int base) {
+    return base == DEC ? ::printf("%ld", value) : printNumber((unsigned long)value, base);
+}
+size_t HardwareSerial::print(unsigned long value, int base) { return printNumber(value, base); }
+size_t HardwareSerial::print(double value, int digits) { return ::printf("%.*f", digits, value); }
+
+size_t HardwareSerial::println() { return ::printf("\n"); }
+size_t HardwareSerial::println(const char* str) { return print(str) + println(); }
+size_t HardwareSerial::println(char c) { return print(c) + println(); }
+size_t HardwareSerial::println(int value, int base) { return print(value, base) + println(); }
+size_t HardwareSerial::println(unsigned int value, int base) { return print(value, base) + println(); }
+size_t HardwareSerial::println(long value, int base) { return print(value, base) + println(); }
+size_t HardwareSerial::println(unsigned long value, int base) { return print(value, base) + println(); }
+size_t HardwareSerial::println(double value, int digits) { return print(value, digits) + println(); }
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int written = ::vprintf(format, args);
+    va_end(args);
+    return written > 0 ? written : 0;
+}
+
+// ============================================================================
+// HEAP CAPS
+// ============================================================================
+
+void* heap_caps_malloc(size_t size, uint32_t /*caps*/) {
+    // DMA buffers must be 4-byte aligned on ESP32; keep the same contract
+    size_t alignedSize = (size + 3) & ~(size_t)3;
+    return aligned_alloc(4, alignedSize > 0 ? alignedSize : 4);
+}
+
+void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+// ============================================================================
+// FREERTOS
+// ============================================================================
+
+TickType_t xTaskGetTickCount() {
+    return pdMS_TO_TICKS(millis());
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks * portTICK_PERIOD_MS);
+}
+
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t timeIncrement) {
+    TickType_t wakeTime = *previousWakeTime + timeIncrement;
+    TickType_t now = xTaskGetTickCount();
+
+    if ((int32_t)(wakeTime - now) > 0) {
+        vTaskDelay(wakeTime - now);
+    }
+
+    *previousWakeTime = wakeTime;
+}
+
+void taskYIELD() {
+    std::this_thread::yield();
+}
+
+// Per-task notification state (TaskHandle_t points at one of these)
+struct ShimTask {
+    std::mutex mutex;
+    std::condition_variable wake;
+    uint32_t notifyValue = 0;
+};
+
+static thread_local ShimTask* s_currentTask = nullptr;
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    // Threads not started through xTaskCreatePinnedToCore (e.g. main) get
+    // their state on first use
+    if (!s_currentTask) {
+        s_currentTask = new ShimTask();
+    }
+    return s_currentTask;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    ShimTask* t = (ShimTask*)task;
+    {
+        std::lock_guard<std::mutex> lock(t->mutex);
+        t->notifyValue++;
+    }
+    t->wake.notify_one();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken) {
+    xTaskNotifyGive(task);
+    if (higherPriorityTaskWoken) {
+        *higherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait) {
+    ShimTask* t = (ShimTask*)xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(t->mutex);
+
+    auto ready = [t] { return t->notifyValue > 0; };
+    if (ticksToWait == portMAX_DELAY) {
+        t->wake.wait(lock, ready);
+    } else if (!t->wake.wait_for(lock, std::chrono::milliseconds(ticksToWait * portTICK_PERIOD_MS), ready)) {
+        return 0;
+    }
+
+    uint32_t value = t->notifyValue;
+    t->notifyValue = clearCountOnExit ? 0 : value - 1;
+    return value;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t taskCode, const char* /*name*/,
+                                   uint32_t /*stackDepth*/, void* parameters,
+                                   UBaseType_t /*priority*/, TaskHandle_t* createdTask,
+                                   BaseType_t /*coreID*/) {
+    ShimTask* handle = new ShimTask();
+    std::thread task([taskCode, parameters, handle] {
+        s_currentTask = handle;
+        taskCode(parameters);
+    });
+    if (createdTask) {
+        *createdTask = handle;
+    }
+    task.detach();
+    return pdPASS;
+}
@@ -0,0 +1,105 @@
+#ifndef NATIVE_SHIM_H
+#define NATIVE_SHIM_H
+
+/**
+ * NativeShim - Host-Only Controls for the Arduino Shim
+ *
+ * Lets host programs drive the simulated hardware behind the shim:
+ * - Manual clock (deterministic millis()/micros() for simulations)
+ * - Digital/analog pin levels (edges raise attachInterrupt() handlers)
+ * - SPI frame source (what ShiftRegisterDMA "reads" from the 74HC165 chain)
+ *   and bus stalls (transfers that outlive a timeout)
+ * - SD card timing model, I/O statistics and power-loss injection (SD.h)
+ *
+ * Not available on device builds.
+ */
+
+#include <Arduino.h>
+
+/**
+ * Switch between the real monotonic clock (default) and a manual clock
+ * @param manual - true to freeze time until shimAdvanceMicros() is called
+ */
+void shimUseManualClock(bool manual);
+
+/**
+ * Advance the manual clock
+ * @param us - Microseconds to advance
+ */
+void shimAdvanceMicros(uint32_t us);
+
+/**
+ * Set the manual clock to an absolute time
+ * @param us - Microseconds since start
+ */
+void shimSetMicros(uint64_t us);
+
+/**
+ * Set the level returned by digitalRead()/analogRead() for a pin
+ * (an edge raises the handler from attachInterrupt(), like digitalWrite())
+ */
+void shimSetPin(uint8_t pin, int value);
+
+/**
+ * Get the last level written with digitalWrite()
+ */
+int shimGetPin(uint8_t pin);
+
+/**
+ * SPI frame source
+ * Called for every completed SPI transaction to fill the receive buffer.
+ */
+typedef void (*ShimSpiFrameSource)(uint8_t* buffer, size_t length, void* arg);
+void shimSetSpiFrameSource(ShimSpiFrameSource source, void* arg);
+
+/**
+ * Stall the SPI bus: queued transactions do not complete (result waits
+ * time out) until the stall is lifted
+ */
+void shimSpiStall(bool stalled);
+
+/**
+ * SD card timing model (SD.h shim). Each read/write call costs commandUs
+ * plus the transfer of every 512-byte sector it touches.
+ * @param commandUs - Overhead per call
+ * @param readKBps - Read rate in KB/s (0 = no timing)
+ * @param writeKBps - Write rate in KB/s (0 = no timing)
+ */
+void shimSdSetTiming(uint32_t commandUs, uint32_t readKBps, uint32_t writeKBps);
+
+/**
+ * SD card I/O statistics
+ */
+struct ShimSdStats {
+    uint32_t readCalls;
+    uint32_t writeCalls;
+    uint32_t sectorsRead;       // 512-byte sectors touched by reads
+    uint32_t sectorsWritten;
+    uint64_t bytesRead;
+    uint64_t bytesWritten;
+};
+
+const ShimSdStats& shimSdGetStats();
+void shimSdResetStats();
+
+/**
+ * Cut power to the simulated card after a number of mutating operations
+ * (writes, truncating/creating opens, rename, remove, mkdir). The next
+ * write only half reaches the card, a metadata operation does not happen,
+ * and everything after fails until shimSdPowerRestore().
+ * @param operations - Mutations that still succeed
+ */
+void shimSdPowerLossAfter(uint32_t operations);
+void shimSdPowerRestore();
+
+/**
+ * Check if the armed power loss has happened
+ */
+bool shimSdPowerLost();
+
+/**
+ * Remove all files and directories from the simulated card
+ */
+void shimSdFormat();
+
+#endif // NATIVE_SHIM_H
@@ -0,0 +1,351 @@
+#include "SD.h"
+#include "NativeShim.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+SDClass SD;
+
+static const uint32_t SECTOR_SIZE = 512;
+
+typedef std::vector<uint8_t> ShimSdData;
+
+static std::map<std::string, std::shared_ptr<ShimSdData>> s_files;
+static std::set<std::string> s_dirs = {"/"};
+
+static ShimSdStats s_stats;
+static uint32_t s_commandUs = 0;
+static uint32_t s_readKBps = 0;
+static uint32_t s_writeKBps = 0;
+
+// Power-loss injection: mutations left before the cut (armed), then dead
+static bool s_powerLossArmed = false;
+static uint32_t s_powerLossCountdown = 0;
+static bool s_powerLost = false;
+
+struct ShimSdHandle {
+    std::string path;
+    std::shared_ptr<ShimSdData> data;   // nullptr for directories
+    size_t position;
+    bool readable;
+    bool writable;
+    bool append;
+    std::vector<std::string> entries;   // Directory listing
+    size_t nextEntry;
+};
+
+// Sectors spanned by [position, position + length)
+static uint32_t sectorsTouched(size_t position, size_t length) {
+    if (length == 0) {
+        return 0;
+    }
+    return (uint32_t)((position + length - 1) / SECTOR_SIZE - position / SECTOR_SIZE + 1);
+}
+
+static void chargeTime(uint32_t sectors, uint32_t kbps) {
+    if (kbps == 0) {
+        return;
+    }
+    uint64_t us = s_commandUs + (uint64_t)sectors * SECTOR_SIZE * 1000000ULL / ((uint64_t)kbps * 1024);
+    delayMicroseconds((uint32_t)us);
+}
+
+// Consume one mutating operation; false once power is gone. The operation
+// that hits the cut is torn (writes) or dropped (metadata)
+static bool allowMutation(bool& torn) {
+    torn = false;
+    if (s_powerLost) {
+        return false;
+    }
+    if (s_powerLossArmed) {
+        if (s_powerLossCountdown == 0) {
+            s_powerLost = true;
+            torn = true;
+            return false;
+        }
+        s_powerLossCountdown--;
+    }
+    return true;
+}
+
+static bool allowMutation() {
+    bool torn;
+    return allowMutation(torn);
+}
+
+static std::string parentOf(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return (slash == 0 || slash == std::string::npos) ? "/" : path.substr(0, slash);
+}
+
+// ============================================================================
+// File
+// ============================================================================
+
+File::File() {}
+
+File::File(std::shared_ptr<ShimSdHandle> handle) : m_handle(handle) {}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    if (!m_handle || !m_handle->data || !m_handle->readable) {
+        return 0;
+    }
+
+    ShimSdData& data = *m_handle->data;
+    size_t count = 0;
+    if (m_handle->position < data.size()) {
+        count = min(size, data.size() - m_handle->position);
+    }
+    memcpy(buffer, data.data() + m_handle->position, count);
+
+    uint32_t sectors = sectorsTouched(m_handle->position, count);
+    s_stats.readCalls++;
+    s_stats.sectorsRead += sectors;
+    s_stats.bytesRead += count;
+    chargeTime(sectors, s_readKBps);
+
+    m_handle->position += count;
+    return count;
+}
+
+int File::read() {
+    uint8_t value;
+    return read(&value, 1) == 1 ? value : -1;
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    if (!m_handle || !m_handle->data || !m_handle->writable) {
+        return 0;
+    }
+
+    bool torn;
+    if (!allowMutation(torn)) {
+        if (!torn) {
+            return 0;
+        }
+        // Power cut mid-write: only the first half reaches the card
+        size /= 2;
+    }
+
+    ShimSdData& data = *m_handle->data;
+    if (m_handle->append) {
+        m_handle->position = data.size();
+    }
+    if (m_handle->position + size > data.size()) {
+        data.resize(m_handle->position + size);
+    }
+    memcpy(data.data() + m_handle->position, buffer, size);
+
+    uint32_t sectors = sectorsTouched(m_handle->position, size);
+    s_stats.writeCalls++;
+    s_stats.sectorsWritten += sectors;
+    s_stats.bytesWritten += size;
+    chargeTime(sectors, s_writeKBps);
+
+    m_handle->position += size;
+    return s_powerLost ? 0 : size;
+}
+
+size_t File::write(uint8_t value) {
+    return write(&value, 1);
+}
+
+bool File::seek(uint32_t pos) {
+    if (!m_handle || !m_handle->data) {
+        return false;
+    }
+    // Seeking past the end is allowed; a write there extends the file
+    m_handle->position = pos;
+    return true;
+}
+
+size_t File::position() const {
+    return m_handle ? m_handle->position : 0;
+}
+
+size_t File::size() const {
+    return (m_handle && m_handle->data) ? m_handle->data->size() : 0;
+}
+
+int File::available() {
+    size_t total = size();
+    return (m_handle && m_handle->position < total) ? (int)(total - m_handle->position) : 0;
+}
+
+void File::flush() {}
+
+void File::close() {
+    m_handle.reset();
+}
+
+const char* File::name() const {
+    if (!m_handle) {
+        return "";
+    }
+    size_t slash = m_handle->path.find_last_of('/');
+    return m_handle->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+const char* File::path() const {
+    return m_handle ? m_handle->path.c_str() : "";
+}
+
+bool File::isDirectory() const {
+    return m_handle && !m_handle->data;
+}
+
+File File::openNextFile() {
+    if (!isDirectory() || m_handle->nextEntry >= m_handle->entries.size()) {
+        return File();
+    }
+    return SD.open(m_handle->entries[m_handle->nextEntry++].c_str(), FILE_READ);
+}
+
+File::operator bool() const {
+    return (bool)m_handle;
+}
+
+// ============================================================================
+// SDClass
+// ============================================================================
+
+bool SDClass::begin(uint8_t /*ssPin*/) {
+    return true;
+}
+
+void SDClass::end() {}
+
+File SDClass::open(const char* path, const char* mode) {
+    std::string key(path);
+    std::string m(mode);
+
+    if (s_dirs.count(key)) {
+        auto handle = std::make_shared<ShimSdHandle>();
+        handle->path = key;
+        handle->position = 0;
+        handle->readable = handle->writable = handle->append = false;
+        handle->nextEntry = 0;
+        std::string prefix = (key == "/") ? "/" : key + "/";
+        for (auto& entry : s_files) {
+            if (entry.first.compare(0, prefix.size(), prefix) == 0 &&
+                entry.first.find('/', prefix.size()) == std::string::npos) {
+                handle->entries.push_back(entry.first);
+            }
+        }
+        return File(handle);
+    }
+
+    auto it = s_files.find(key);
+    bool create = (m[0] == 'w' || m[0] == 'a');
+    if ((m[0] == 'w' || (create && it == s_files.end())) && !allowMutation()) {
+        return File();
+    }
+    if (it == s_files.end()) {
+        if (!create || !s_dirs.count(parentOf(key))) {
+            return File();
+        }
+        it = s_files.emplace(key, std::make_shared<ShimSdData>()).first;
+    }
+
+    auto handle = std::make_shared<ShimSdHandle>();
+    handle->path = key;
+    handle->data = it->second;
+    handle->position = 0;
+    handle->readable = (m[0] == 'r' || m.find('+') != std::string::npos);
+    handle->writable = (m[0] != 'r' || m.find('+') != std::string::npos);
+    handle->append = (m[0] == 'a');
+    handle->nextEntry = 0;
+
+    if (m[0] == 'w') {
+        handle->data->clear();
+    }
+    return File(handle);
+}
+
+bool SDClass::exists(const char* path) {
+    return s_files.count(path) || s_dirs.count(path);
+}
+
+bool SDClass::remove(const char* path) {
+    if (!s_files.count(path) || !allowMutation()) {
+        return false;
+    }
+    return s_files.erase(path) > 0;
+}
+
+bool SDClass::rename(const char* pathFrom, const char* pathTo) {
+    // Like FatFs f_rename: fails if the target exists
+    auto it = s_files.find(pathFrom);
+    if (it == s_files.end() || s_files.count(pathTo) || !s_dirs.count(parentOf(pathTo)) ||
+        !allowMutation()) {
+        return false;
+    }
+    std::shared_ptr<ShimSdData> data = it->second;
+    s_files.erase(it);
+    s_files[pathTo] = data;
+    return true;
+}
+
+bool SDClass::mkdir(const char* path) {
+    if (!s_dirs.count(parentOf(path)) || !allowMutation()) {
+        return false;
+    }
+    s_dirs.insert(path);
+    return true;
+}
+
+bool SDClass::rmdir(const char* path) {
+    return s_dirs.erase(path) > 0;
+}
+
+uint64_t SDClass::totalBytes() {
+    return 32ULL * 1024 * 1024 * 1024;
+}
+
+uint64_t SDClass::usedBytes() {
+    uint64_t used = 0;
+    for (auto& entry : s_files) {
+        used += entry.second->size();
+    }
+    return used;
+}
+
+// ============================================================================
+// Host-only controls
+// ============================================================================
+
+void shimSdSetTiming(uint32_t commandUs, uint32_t readKBps, uint32_t writeKBps) {
+    s_commandUs = commandUs;
+    s_readKBps = readKBps;
+    s_writeKBps = writeKBps;
+}
+
+const ShimSdStats& shimSdGetStats() {
+    return s_stats;
+}
+
+void shimSdResetStats() {
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+void shimSdPowerLossAfter(uint32_t operations) {
+    s_powerLossArmed = true;
+    s_powerLossCountdown = operations;
+    s_powerLost = false;
+}
+
+void shimSdPowerRestore() {
+    s_powerLossArmed = false;
+    s_powerLost = false;
+}
+
+bool shimSdPowerLost() {
+    return s_powerLost;
+}
+
+void shimSdFormat() {
+    s_files.clear();
+    s_dirs.clear();
+    s_dirs.insert("/");
+}
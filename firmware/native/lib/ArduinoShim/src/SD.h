@@ -0,0 +1,77 @@
+#ifndef SD_SHIM_H
+#define SD_SHIM_H
+
+/**
+ * SD.h - ESP32 SD library shim for host builds
+ *
+ * An in-memory card: files are byte vectors keyed by path, directories are
+ * path prefixes. Modes follow the ESP32 VFS ("r", "w", "a", "r+", "w+").
+ *
+ * Every read/write counts the 512-byte sectors it touches and, if a timing
+ * model is set with shimSdSetTiming() (NativeShim.h), costs one command
+ * overhead plus transfer time via delayMicroseconds(), so a manual-clock
+ * benchmark sees SPI SD card latencies. shimSdPowerLossAfter() cuts power
+ * after a number of mutations to test crash safety.
+ */
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+struct ShimSdHandle;
+
+class File {
+public:
+    File();
+    explicit File(std::shared_ptr<ShimSdHandle> handle);
+
+    size_t read(uint8_t* buffer, size_t size);
+    int read();
+    size_t write(const uint8_t* buffer, size_t size);
+    size_t write(uint8_t value);
+
+    bool seek(uint32_t pos);
+    size_t position() const;
+    size_t size() const;
+    int available();
+
+    void flush();
+    void close();
+
+    const char* name() const;
+    const char* path() const;
+    bool isDirectory() const;
+
+    /**
+     * Next entry of a directory (empty File at the end)
+     */
+    File openNextFile();
+
+    operator bool() const;
+
+private:
+    std::shared_ptr<ShimSdHandle> m_handle;
+};
+
+class SDClass {
+public:
+    bool begin(uint8_t ssPin = 5);
+    void end();
+
+    File open(const char* path, const char* mode = FILE_READ);
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* pathFrom, const char* pathTo);
+    bool mkdir(const char* path);
+    bool rmdir(const char* path);
+
+    uint64_t totalBytes();
+    uint64_t usedBytes();
+};
+
+extern SDClass SD;
+
+#endif // SD_SHIM_H
@@ -0,0 +1,149 @@
+#include "Wire.h"
+
+#include <string.h>
+
+TwoWire Wire(0);
+TwoWire Wire1(1);
+TwoWire Wire2(2);
+
+// Slaves registered on the shared in-process bus, indexed by 7-bit address
+static TwoWire* s_slaves[128];
+
+TwoWire::TwoWire(uint8_t busNum)
+    : m_busNum(busNum)
+    , m_clock(100000)
+    , m_slaveAddress(0)
+    , m_onReceive(nullptr)
+    , m_onRequest(nullptr)
+    , m_txAddress(0)
+    , m_txLength(0)
+    , m_rxLength(0)
+    , m_rxIndex(0)
+    , m_bytesTransferred(0)
+    , m_transactionCount(0)
+{
+}
+
+bool TwoWire::begin() {
+    m_slaveAddress = 0;
+    return true;
+}
+
+void TwoWire::setClock(uint32_t frequency) {
+    m_clock = frequency;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    m_txAddress = address;
+    m_txLength = 0;
+}
+
+uint8_t TwoWire::endTransmission(bool /*sendStop*/) {
+    m_transactionCount++;
+    m_bytesTransferred += 1 + m_txLength;  // Address byte + payload
+
+    TwoWire* slave = s_slaves[m_txAddress & 0x7F];
+    if (!slave) {
+        return 2;  // NACK on address
+    }
+
+    memcpy(slave->m_rxBuffer, m_txBuffer, m_txLength);
+    slave->m_rxLength = m_txLength;
+    slave->m_rxIndex = 0;
+
+    if (slave->m_onReceive) {
+        slave->m_onReceive((int)m_txLength);
+    }
+
+    m_txLength = 0;
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool /*sendStop*/) {
+    m_transactionCount++;
+    m_bytesTransferred += 1;  // Address byte
+    m_rxLength = 0;
+    m_rxIndex = 0;
+
+    TwoWire* slave = s_slaves[address & 0x7F];
+    if (!slave) {
+        return 0;
+    }
+
+    slave->m_txLength = 0;
+    if (slave->m_onRequest) {
+        slave->m_onRequest();
+    }
+
+    // Master clocks exactly `quantity` bytes (a uint8_t always fits the
+    // buffer); a short reply reads as 0xFF
+    size_t count = quantity;
+    for (size_t i = 0; i < count; i++) {
+        m_rxBuffer[i] = i < slave->m_txLength ? slave->m_txBuffer[i] : 0xFF;
+    }
+    m_rxLength = count;
+    m_bytesTransferred += count;
+
+    return (uint8_t)count;
+}
+
+bool TwoWire::begin(uint8_t address, int /*sdaPin*/, int /*sclPin*/, uint32_t /*frequency*/) {
+    m_slaveAddress = address & 0x7F;
+    s_slaves[m_slaveAddress] = this;
+    return true;
+}
+
+void TwoWire::onReceive(void (*handler)(int)) {
+    m_onReceive = handler;
+}
+
+void TwoWire::onRequest(void (*handler)()) {
+    m_onRequest = handler;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if (m_txLength >= BUFFER_LENGTH) {
+        return 0;
+    }
+    m_txBuffer[m_txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t length) {
+    size_t written = 0;
+    while (written < length && write(data[written])) {
+        written++;
+    }
+    return written;
+}
+
+int TwoWire::available() {
+    return (int)(m_rxLength - m_rxIndex);
+}
+
+int TwoWire::read() {
+    if (m_rxIndex >= m_rxLength) {
+        return -1;
+    }
+    return m_rxBuffer[m_rxIndex++];
+}
+
+int TwoWire::peek() {
+    if (m_rxIndex >= m_rxLength) {
+        return -1;
+    }
+    return m_rxBuffer[m_rxIndex];
+}
+
+size_t TwoWire::readBytes(uint8_t* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length && m_rxIndex < m_rxLength) {
+        buffer[count++] = m_rxBuffer[m_rxIndex++];
+    }
+    return count;
+}
+
+void TwoWire::resetStatistics() {
+    m_bytesTransferred = 0;
+    m_transactionCount = 0;
+}
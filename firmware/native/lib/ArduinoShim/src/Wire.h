@@ -0,0 +1,72 @@
+#ifndef WIRE_SHIM_H
+#define WIRE_SHIM_H
+
+/**
+ * Wire.h - I2C (TwoWire) shim for host builds
+ *
+ * All TwoWire instances share one in-process bus. A TwoWire started in
+ * slave mode (begin(address, ...)) registers itself by address; master
+ * transactions addressed to it are delivered to its onReceive/onRequest
+ * callbacks, so I2CSlave and the I2C masters can talk to each other on a host.
+ * Transactions to unregistered addresses NACK.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BUFFER_LENGTH 256
+
+class TwoWire {
+public:
+    TwoWire(uint8_t busNum);
+
+    // Master mode
+    bool begin();
+    void setClock(uint32_t frequency);
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+
+    // Slave mode
+    bool begin(uint8_t address, int sdaPin, int sclPin, uint32_t frequency = 0);
+    void onReceive(void (*handler)(int));
+    void onRequest(void (*handler)());
+
+    // Stream
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t length);
+    int available();
+    int read();
+    int peek();
+    size_t readBytes(uint8_t* buffer, size_t length);
+
+    // Bus statistics (host only)
+    uint32_t getBytesTransferred() const { return m_bytesTransferred; }
+    uint32_t getTransactionCount() const { return m_transactionCount; }
+    void resetStatistics();
+
+private:
+    uint8_t m_busNum;
+    uint32_t m_clock;
+
+    uint8_t m_slaveAddress;   // 0 = master mode
+    void (*m_onReceive)(int);
+    void (*m_onRequest)();
+
+    uint8_t m_txAddress;
+    uint8_t m_txBuffer[BUFFER_LENGTH];
+    size_t m_txLength;
+
+    uint8_t m_rxBuffer[BUFFER_LENGTH];
+    size_t m_rxLength;
+    size_t m_rxIndex;
+
+    uint32_t m_bytesTransferred;
+    uint32_t m_transactionCount;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+extern TwoWire Wire2;
+
+#endif // WIRE_SHIM_H
@@ -0,0 +1,65 @@
+#ifndef GPTIMER_SHIM_H
+#define GPTIMER_SHIM_H
+
+/**
+ * gptimer.h - ESP-IDF general purpose timer shim for host builds
+ *
+ * A started timer runs on its own thread and calls on_alarm at every alarm
+ * (auto-reload only), against the real monotonic clock. Host scheduling
+ * adds tens of microseconds of jitter; use it to exercise the code path,
+ * not to judge device timing.
+ */
+
+#include <stdint.h>
+#include "../esp_err.h"
+
+typedef struct gptimer_t* gptimer_handle_t;
+
+typedef enum {
+    GPTIMER_CLK_SRC_DEFAULT = 0
+} gptimer_clock_source_t;
+
+typedef enum {
+    GPTIMER_COUNT_DOWN = 0,
+    GPTIMER_COUNT_UP = 1
+} gptimer_count_direction_t;
+
+typedef struct {
+    gptimer_clock_source_t clk_src;
+    gptimer_count_direction_t direction;
+    uint32_t resolution_hz;
+    int intr_priority;
+    struct {
+        uint32_t intr_shared : 1;
+    } flags;
+} gptimer_config_t;
+
+typedef struct {
+    uint64_t count_value;
+    uint64_t alarm_value;
+} gptimer_alarm_event_data_t;
+
+typedef bool (*gptimer_alarm_cb_t)(gptimer_handle_t timer, const gptimer_alarm_event_data_t* edata, void* userCtx);
+
+typedef struct {
+    gptimer_alarm_cb_t on_alarm;
+} gptimer_event_callbacks_t;
+
+typedef struct {
+    uint64_t alarm_count;
+    uint64_t reload_count;
+    struct {
+        uint32_t auto_reload_on_alarm : 1;
+    } flags;
+} gptimer_alarm_config_t;
+
+esp_err_t gptimer_new_timer(const gptimer_config_t* config, gptimer_handle_t* retTimer);
+esp_err_t gptimer_del_timer(gptimer_handle_t timer);
+esp_err_t gptimer_register_event_callbacks(gptimer_handle_t timer, const gptimer_event_callbacks_t* cbs, void* userData);
+esp_err_t gptimer_set_alarm_action(gptimer_handle_t timer, const gptimer_alarm_config_t* config);
+esp_err_t gptimer_enable(gptimer_handle_t timer);
+esp_err_t gptimer_disable(gptimer_handle_t timer);
+esp_err_t gptimer_start(gptimer_handle_t timer);
+esp_err_t gptimer_stop(gptimer_handle_t timer);
+
+#endif // GPTIMER_SHIM_H
@@ -0,0 +1,81 @@
+#ifndef SPI_MASTER_SHIM_H
+#define SPI_MASTER_SHIM_H
+
+/**
+ * spi_master.h - ESP-IDF SPI master driver shim for host builds
+ *
+ * Queued transactions complete when their result is collected. The receive
+ * buffer is filled from the frame source installed with
+ * shimSetSpiFrameSource() (see NativeShim.h), or zeroed if none is set.
+ * pre_cb/post_cb are invoked around the fill, as the driver does from its ISR.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../esp_err.h"
+#include "../freertos/FreeRTOS.h"
+
+typedef enum {
+    SPI1_HOST = 0,
+    SPI2_HOST = 1,
+    SPI3_HOST = 2
+} spi_host_device_t;
+
+#define HSPI_HOST SPI2_HOST
+#define VSPI_HOST SPI3_HOST
+
+#define SPI_DMA_CH_AUTO 3
+
+struct spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t* trans);
+
+typedef struct {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    int max_transfer_sz;
+    uint32_t flags;
+    int intr_flags;
+} spi_bus_config_t;
+
+typedef struct {
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+    uint8_t mode;
+    uint16_t duty_cycle_pos;
+    uint16_t cs_ena_pretrans;
+    uint8_t cs_ena_posttrans;
+    uint32_t clock_speed_hz;
+    int input_delay_ns;
+    int spics_io_num;
+    uint32_t flags;
+    int queue_size;
+    transaction_cb_t pre_cb;
+    transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+struct spi_transaction_t {
+    uint32_t flags;
+    uint16_t cmd;
+    uint64_t addr;
+    size_t length;
+    size_t rxlength;
+    void* user;
+    const void* tx_buffer;
+    void* rx_buffer;
+};
+
+typedef struct spi_device_t* spi_device_handle_t;
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t* busConfig, int dmaChan);
+esp_err_t spi_bus_free(spi_host_device_t host);
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t* devConfig,
+                             spi_device_handle_t* handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans, TickType_t ticksToWait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans, TickType_t ticksToWait);
+
+#endif // SPI_MASTER_SHIM_H
@@ -0,0 +1,22 @@
+#ifndef ESP_HEAP_CAPS_SHIM_H
+#define ESP_HEAP_CAPS_SHIM_H
+
+/**
+ * esp_heap_caps.h - ESP-IDF capability allocator shim for host builds
+ *
+ * All capabilities map onto an aligned host allocation.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_DEFAULT  (1 << 0)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+
+void* heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void* ptr);
+
+#endif // ESP_HEAP_CAPS_SHIM_H
@@ -0,0 +1,28 @@
+#ifndef FREERTOS_SHIM_H
+#define FREERTOS_SHIM_H
+
+/**
+ * FreeRTOS.h - FreeRTOS type and tick shim for host builds
+ *
+ * Tick rate matches the Arduino-ESP32 default (1 kHz).
+ */
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+
+#define configTICK_RATE_HZ 1000
+#define portMAX_DELAY      ((TickType_t)0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#endif // FREERTOS_SHIM_H
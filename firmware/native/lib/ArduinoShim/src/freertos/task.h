@@ -0,0 +1,34 @@
+#ifndef FREERTOS_TASK_SHIM_H
+#define FREERTOS_TASK_SHIM_H
+
+/**
+ * task.h - FreeRTOS task API shim for host builds
+ *
+ * Tasks run as detached std::threads; core affinity and priority are ignored.
+ * Direct-to-task notifications work between any shim tasks (and from
+ * gptimer callbacks, which stand in for ISRs).
+ */
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef void* TaskHandle_t;
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+TickType_t xTaskGetTickCount();
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t timeIncrement);
+void taskYIELD();
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t taskCode, const char* name,
+                                   uint32_t stackDepth, void* parameters,
+                                   UBaseType_t priority, TaskHandle_t* createdTask,
+                                   BaseType_t coreID);
+
+#endif // FREERTOS_TASK_SHIM_H
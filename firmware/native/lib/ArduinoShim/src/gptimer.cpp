@@ -0,0 +1,125 @@
+#include "driver/gptimer.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+struct gptimer_t {
+    gptimer_config_t config;
+    gptimer_event_callbacks_t callbacks;
+    void* userData;
+    gptimer_alarm_config_t alarm;
+    bool enabled;
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+esp_err_t gptimer_new_timer(const gptimer_config_t* config, gptimer_handle_t* retTimer) {
+    if (!config || !retTimer || config->resolution_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    gptimer_t* timer = new gptimer_t();
+    timer->config = *config;
+    timer->callbacks.on_alarm = nullptr;
+    timer->userData = nullptr;
+    timer->alarm.alarm_count = 0;
+    timer->alarm.reload_count = 0;
+    timer->alarm.flags.auto_reload_on_alarm = 0;
+    timer->enabled = false;
+    timer->running = false;
+    *retTimer = timer;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_del_timer(gptimer_handle_t timer) {
+    if (timer->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    delete timer;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_register_event_callbacks(gptimer_handle_t timer, const gptimer_event_callbacks_t* cbs, void* userData) {
+    if (timer->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->callbacks = *cbs;
+    timer->userData = userData;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_set_alarm_action(gptimer_handle_t timer, const gptimer_alarm_config_t* config) {
+    if (config) {
+        timer->alarm = *config;
+    } else {
+        timer->alarm.alarm_count = 0;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gptimer_enable(gptimer_handle_t timer) {
+    if (timer->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_disable(gptimer_handle_t timer) {
+    if (!timer->enabled || timer->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->enabled = false;
+    return ESP_OK;
+}
+
+static void runTimer(gptimer_t* timer) {
+    using namespace std::chrono;
+
+    const nanoseconds period((int64_t)(timer->alarm.alarm_count * 1000000000ULL / timer->config.resolution_hz));
+    const nanoseconds spinWindow(100000);  // Sleep overshoots; spin the last 100us
+    steady_clock::time_point next = steady_clock::now() + period;
+    uint64_t count = 0;
+
+    while (timer->running.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_until(next - spinWindow);
+        while (steady_clock::now() < next) {
+        }
+
+        count += timer->alarm.alarm_count;
+        if (timer->callbacks.on_alarm) {
+            gptimer_alarm_event_data_t edata = {count, timer->alarm.alarm_count};
+            timer->callbacks.on_alarm(timer, &edata, timer->userData);
+        }
+
+        // Like the hardware, an alarm that was missed fires once, not as a burst
+        next += period;
+        steady_clock::time_point now = steady_clock::now();
+        while (next <= now) {
+            next += period;
+        }
+    }
+}
+
+esp_err_t gptimer_start(gptimer_handle_t timer) {
+    if (!timer->enabled || timer->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!timer->alarm.flags.auto_reload_on_alarm || timer->alarm.alarm_count == 0) {
+        return ESP_ERR_INVALID_ARG;  // Shim only models periodic alarms
+    }
+
+    timer->running = true;
+    timer->thread = std::thread(runTimer, timer);
+    return ESP_OK;
+}
+
+esp_err_t gptimer_stop(gptimer_handle_t timer) {
+    if (!timer->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->running = false;
+    timer->thread.join();
+    return ESP_OK;
+}
@@ -0,0 +1,105 @@
+#include "driver/spi_master.h"
+#include "NativeShim.h"
+
+#include <string.h>
+
+struct spi_device_t {
+    spi_device_interface_config_t config;
+    spi_transaction_t* queue[8];
+    uint8_t queueHead;
+    uint8_t queueTail;
+};
+
+static const uint8_t SPI_QUEUE_CAPACITY = 8;
+
+static bool s_busInitialized[3];
+static ShimSpiFrameSource s_frameSource = nullptr;
+static void* s_frameSourceArg = nullptr;
+static bool s_stalled = false;
+
+void shimSetSpiFrameSource(ShimSpiFrameSource source, void* arg) {
+    s_frameSource = source;
+    s_frameSourceArg = arg;
+}
+
+void shimSpiStall(bool stalled) {
+    s_stalled = stalled;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t* /*busConfig*/, int /*dmaChan*/) {
+    if (host > SPI3_HOST || s_busInitialized[host]) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_busInitialized[host] = true;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host) {
+    if (host > SPI3_HOST) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_busInitialized[host] = false;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t* devConfig,
+                             spi_device_handle_t* handle) {
+    if (host > SPI3_HOST || !s_busInitialized[host]) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    spi_device_t* device = new spi_device_t();
+    device->config = *devConfig;
+    device->queueHead = 0;
+    device->queueTail = 0;
+    *handle = device;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle) {
+    delete handle;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans, TickType_t /*ticksToWait*/) {
+    uint8_t depth = (uint8_t)(handle->queueHead - handle->queueTail);
+    int capacity = handle->config.queue_size < SPI_QUEUE_CAPACITY ? handle->config.queue_size : SPI_QUEUE_CAPACITY;
+
+    if (depth >= capacity) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    handle->queue[handle->queueHead % SPI_QUEUE_CAPACITY] = trans;
+    handle->queueHead++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans, TickType_t /*ticksToWait*/) {
+    if (handle->queueHead == handle->queueTail || s_stalled) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    spi_transaction_t* t = handle->queue[handle->queueTail % SPI_QUEUE_CAPACITY];
+    handle->queueTail++;
+
+    // Transfer happens "now": pre_cb, clock in the frame, post_cb
+    if (handle->config.pre_cb) {
+        handle->config.pre_cb(t);
+    }
+
+    size_t rxBytes = (t->rxlength ? t->rxlength : t->length) / 8;
+    if (t->rx_buffer && rxBytes > 0) {
+        if (s_frameSource) {
+            s_frameSource((uint8_t*)t->rx_buffer, rxBytes, s_frameSourceArg);
+        } else {
+            memset(t->rx_buffer, 0, rxBytes);
+        }
+    }
+
+    if (handle->config.post_cb) {
+        handle->config.post_cb(t);
+    }
+
+    *trans = t;
+    return ESP_OK;
+}
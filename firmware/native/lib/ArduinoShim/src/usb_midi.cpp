@@ -0,0 +1,95 @@
+#include "usb_midi.h"
+
+usb_midi_class usbMIDI;
+
+usb_midi_class::usb_midi_class()
+    : m_sendHook(nullptr)
+    , m_sendCount(0)
+    , m_flushCount(0)
+    , m_transactionCount(0)
+    , m_txPending(0)
+    , m_rxHead(0)
+    , m_rxTail(0)
+    , m_rxType(InvalidType)
+    , m_rxChannel(0)
+    , m_rxData1(0)
+    , m_rxData2(0)
+    , m_rxCable(0)
+{
+}
+
+void usb_midi_class::send(uint8_t type, uint8_t data1, uint8_t data2, uint8_t channel, uint8_t cable) {
+    m_sendCount++;
+    if (m_sendHook) {
+        m_sendHook(type, data1, data2, channel, cable);
+    }
+}
+
+void usb_midi_class::send_now() {
+    flushOutput();
+}
+
+void usb_midi_class::writePacked(uint32_t packet) {
+    uint8_t status = (packet >> 8) & 0xFF;
+
+    m_sendCount++;
+    if (m_sendHook) {
+        m_sendHook(status & 0xF0, (packet >> 16) & 0x7F, (packet >> 24) & 0x7F,
+                   (status & 0x0F) + 1, (packet >> 4) & 0x0F);
+    }
+
+    // Full buffer goes out on its own
+    if (++m_txPending == TX_BUFFER_PACKETS) {
+        m_transactionCount++;
+        m_txPending = 0;
+    }
+}
+
+void usb_midi_class::flushOutput() {
+    m_flushCount++;
+    if (m_txPending > 0) {
+        m_transactionCount++;
+        m_txPending = 0;
+    }
+}
+
+void usb_midi_write_packed(uint32_t n) {
+    usbMIDI.writePacked(n);
+}
+
+void usb_midi_flush_output(void) {
+    usbMIDI.flushOutput();
+}
+
+bool usb_midi_class::read(uint8_t /*channel*/) {
+    if (m_rxHead == m_rxTail) {
+        return false;
+    }
+
+    const RxMessage& msg = m_rxQueue[m_rxTail];
+    m_rxType = msg.type;
+    m_rxData1 = msg.data1;
+    m_rxData2 = msg.data2;
+    m_rxChannel = msg.channel;
+    m_rxCable = msg.cable;
+    m_rxTail = (m_rxTail + 1) % RX_QUEUE_SIZE;
+    return true;
+}
+
+bool usb_midi_class::inject(uint8_t type, uint8_t data1, uint8_t data2, uint8_t channel, uint8_t cable) {
+    uint8_t nextHead = (m_rxHead + 1) % RX_QUEUE_SIZE;
+    if (nextHead == m_rxTail) {
+        return false;
+    }
+
+    m_rxQueue[m_rxHead] = {type, data1, data2, channel, cable};
+    m_rxHead = nextHead;
+    return true;
+}
+
+void usb_midi_class::resetStatistics() {
+    m_sendCount = 0;
+    m_flushCount = 0;
+    m_transactionCount = 0;
+    m_txPending = 0;
+}
@@ -0,0 +1,101 @@
+#ifndef USB_MIDI_SHIM_H
+#define USB_MIDI_SHIM_H
+
+/**
+ * usb_midi.h - Teensy usbMIDI shim for host builds
+ *
+ * Outgoing messages are counted (and optionally captured via a hook) instead
+ * of being transmitted. Incoming messages can be injected with inject().
+ *
+ * usb_midi_write_packed()/usb_midi_flush_output() mirror the Teensy core's
+ * packed path: packets collect in a transmit buffer (128 packets, one
+ * 512-byte high-speed USB packet) that goes out as one USB transaction
+ * when it fills or is flushed.
+ */
+
+#include <stdint.h>
+
+class usb_midi_class {
+public:
+    enum MidiType : uint8_t {
+        InvalidType = 0x00,
+        NoteOff = 0x80,
+        NoteOn = 0x90,
+        AfterTouchPoly = 0xA0,
+        ControlChange = 0xB0,
+        ProgramChange = 0xC0,
+        AfterTouchChannel = 0xD0,
+        PitchBend = 0xE0,
+        SystemExclusive = 0xF0,
+        Clock = 0xF8,
+        Start = 0xFA,
+        Continue = 0xFB,
+        Stop = 0xFC,
+        ActiveSensing = 0xFE,
+        SystemReset = 0xFF
+    };
+
+    typedef void (*SendHook)(uint8_t type, uint8_t data1, uint8_t data2, uint8_t channel, uint8_t cable);
+
+    usb_midi_class();
+
+    // Transmit
+    void send(uint8_t type, uint8_t data1, uint8_t data2, uint8_t channel, uint8_t cable);
+    void send_now();
+
+    // Packed USB-MIDI event packets (byte 0 = cable << 4 | CIN)
+    void writePacked(uint32_t packet);
+    void flushOutput();
+
+    // Receive
+    bool read(uint8_t channel = 0);
+    uint8_t getType() const { return m_rxType; }
+    uint8_t getChannel() const { return m_rxChannel; }
+    uint8_t getData1() const { return m_rxData1; }
+    uint8_t getData2() const { return m_rxData2; }
+    uint8_t getCable() const { return m_rxCable; }
+
+    // Host-only hooks and statistics
+    void setSendHook(SendHook hook) { m_sendHook = hook; }
+    bool inject(uint8_t type, uint8_t data1, uint8_t data2, uint8_t channel = 1, uint8_t cable = 0);
+    uint32_t getSendCount() const { return m_sendCount; }
+    uint32_t getFlushCount() const { return m_flushCount; }
+    uint32_t getTransactionCount() const { return m_transactionCount; }  // USB packets with data
+    void resetStatistics();
+
+private:
+    static const uint8_t RX_QUEUE_SIZE = 64;
+    static const uint8_t TX_BUFFER_PACKETS = 128;
+
+    struct RxMessage {
+        uint8_t type;
+        uint8_t data1;
+        uint8_t data2;
+        uint8_t channel;
+        uint8_t cable;
+    };
+
+    SendHook m_sendHook;
+    uint32_t m_sendCount;
+    uint32_t m_flushCount;
+    uint32_t m_transactionCount;
+    uint8_t m_txPending;
+
+    RxMessage m_rxQueue[RX_QUEUE_SIZE];
+    uint8_t m_rxHead;
+    uint8_t m_rxTail;
+
+    uint8_t m_rxType;
+    uint8_t m_rxChannel;
+    uint8_t m_rxData1;
+    uint8_t m_rxData2;
+    uint8_t m_rxCable;
+};
+
+extern usb_midi_class usbMIDI;
+
+// Teensy core C API
+void usb_midi_write_packed(uint32_t n);
+void usb_midi_flush_output(void);
+
+#endif // USB_MIDI_SHIM_H
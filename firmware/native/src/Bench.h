@@ -0,0 +1,74 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Arduino.h>
+#include <chrono>
+
+/**
+ * Bench - Minimal Microbenchmark Helpers for Host Builds
+ *
+ * Typical usage:
+ *   runBenchmark("EncoderDecoder::update", 100000, [&](uint32_t i) {
+ *       encoders.update(frames[i & 255]);
+ *   });
+ */
+
+struct BenchResult {
+    const char* name;
+    uint32_t iterations;
+    double nsPerOp;
+};
+
+/**
+ * Keep a value alive so the optimizer cannot drop the benchmarked work
+ */
+template<typename T>
+inline void benchSink(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * Print a section heading
+ */
+inline void benchSection(const char* title) {
+    Serial.println();
+    Serial.printf("=== %s ===\n", title);
+}
+
+/**
+ * Time `iterations` calls of fn(i) and print ns per call
+ * @param name - Benchmark label
+ * @param iterations - Number of calls
+ * @param fn - Callable taking the iteration index
+ * @return Timing result
+ */
+template<typename F>
+BenchResult runBenchmark(const char* name, uint32_t iterations, F&& fn) {
+    // Warm caches and branch predictors
+    uint32_t warmup = iterations / 10 + 1;
+    for (uint32_t i = 0; i < warmup; i++) {
+        fn(i);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        fn(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double totalNs = std::chrono::duration<double, std::nano>(end - start).count();
+    BenchResult result = {name, iterations, totalNs / iterations};
+
+    Serial.printf("  %-48s %10.1f ns/op  (%u iterations)\n", name, result.nsPerOp, iterations);
+    return result;
+}
+
+// Benchmark suites (one per source file)
+void runScanBenchmarks();
+void runEventBenchmarks();
+void runTimingBenchmarks();
+void runLinkBenchmarks();
+void runTransitionBenchmarks();
+void runSessionBenchmarks();
+
+#endif // BENCH_H
@@ -0,0 +1,453 @@
+/**
+ * Event-path benchmarks (Teensy work per received control event)
+ */
+
+#include "Bench.h"
+#include <NativeShim.h>
+#include <usb_midi.h>
+#include <Protocol.h>
+#include <StateManager.h>
+#include <MIDIEngine.h>
+#include <ValueEngine.h>
+#include <Diagnostics.h>
+
+// Last value sent per CC number (0xFF = none)
+static uint8_t s_lastCC[128];
+static uint32_t s_cable1SentAt;
+
+static void captureCC(uint8_t type, uint8_t data1, uint8_t data2, uint8_t /*channel*/, uint8_t cable) {
+    if ((type & 0xF0) == 0xB0) {
+        s_lastCC[data1 & 0x7F] = data2;
+    }
+    if (cable == 1 && s_cable1SentAt == 0) {
+        s_cable1SentAt = micros();
+    }
+}
+
+// Summed delta of relative CCs sent (s_relativeMode encoding)
+static uint8_t s_relativeMode;
+static int32_t s_relativeSum;
+
+static void captureRelative(uint8_t /*type*/, uint8_t /*data1*/, uint8_t data2, uint8_t /*channel*/, uint8_t /*cable*/) {
+    if (s_relativeMode == ENCODER_RELATIVE_1) {
+        s_relativeSum += (int32_t)data2 - 64;
+    } else if (s_relativeMode == ENCODER_RELATIVE_3) {
+        s_relativeSum += (data2 & 0x40) ? (int32_t)data2 - 128 : data2;
+    } else {
+        s_relativeSum += data2 == 127 ? 2 : (data2 == 0 ? -2 : (int32_t)data2 - 64);
+    }
+}
+
+void runEventBenchmarks() {
+    benchSection("Event path (619 controls)");
+
+    StateManager* state = new StateManager();
+    state->begin();
+
+    runBenchmark("StateManager::setValue", 1000000, [&](uint32_t i) {
+        benchSink(state->setValue(i % TOTAL_CONTROLS, (uint8_t)(i & 0x7F)));
+    });
+
+    runBenchmark("StateManager::setBank", 100000, [&](uint32_t i) {
+        state->setBank(i & 1);
+    });
+    state->setBank(false);
+
+    runBenchmark("Scan all 619 for dirty + clear", 20000, [&](uint32_t i) {
+        uint32_t count = 0;
+        for (uint16_t id = 0; id < TOTAL_CONTROLS; id++) {
+            if (state->isDirty(id)) {
+                state->clearDirty(id);
+                count++;
+            }
+        }
+        state->markDirty(i % TOTAL_CONTROLS);
+        benchSink(count);
+    });
+
+    runBenchmark("Walk dirty bitset + clear", 1000000, [&](uint32_t i) {
+        uint32_t count = 0;
+        state->getDirtyControls().forEach([&](uint16_t id) {
+            state->clearDirty(id);
+            count++;
+        });
+        state->markDirty(i % TOTAL_CONTROLS);
+        benchSink(count);
+    });
+    state->clearAllDirty();
+
+    // Advance the clock past the throttle interval so every message is sent
+    MIDIEngine midi;
+    shimUseManualClock(true);
+    midi.begin();
+    usbMIDI.resetStatistics();
+
+    runBenchmark("setValue + getRoute + processControl", 1000000, [&](uint32_t i) {
+        shimAdvanceMicros(500);
+        uint16_t id = i % TOTAL_CONTROLS;
+        uint8_t value = (uint8_t)(i & 0x7F);
+        state->setValue(id, value);
+        const ControlRoute* route = state->getRoute(id);
+        if (route && (route->flags & ROUTE_FLAG_ENABLED)) {
+            benchSink(midi.processControl(*route, value));
+        }
+    });
+
+    Serial.printf("  usbMIDI sends: %u, MIDIEngine coalesced: %u\n",
+        usbMIDI.getSendCount(), midi.getMessagesCoalesced());
+
+    // Compiled routes must match the configs they come from, in both banks
+    bool routesOk = true;
+    for (uint8_t bank = 0; bank < 2; bank++) {
+        state->setBank(bank == 1);
+        for (uint16_t id = 0; id < TOTAL_CONTROLS; id++) {
+            const ControlConfig* config = state->getConfig(id);
+            const ControlRoute* route = state->getRoute(id);
+            routesOk &= route->status == (0xB0 | (bank ? config->midiChannelB : config->midiChannel));
+            routesOk &= route->data1 == (bank ? config->ccNumberB : config->ccNumber);
+            routesOk &= route->cable == (bank ? config->virtualDeviceB : config->virtualDevice);
+        }
+    }
+    state->setBank(false);
+
+    // Per-panel bank: only that panel's controls move to Bank B
+    uint16_t panel0 = 0, panel1 = 0, panel2 = 0;
+    for (uint16_t id = 0; id < TOTAL_CONTROLS; id++) {
+        if (state->getPanel(id) == 0) {
+            panel0 = id;
+        } else if (state->getPanel(id) == 1) {
+            panel1 = id;
+        } else if (state->getPanel(id) == 2) {
+            panel2 = id;
+        }
+    }
+    ControlConfig bankB = *state->getConfig(panel1);
+    bankB.ccNumberB = 99;
+    state->setConfig(panel1, bankB);
+    state->setPanelBank(1, true);
+    routesOk &= state->isPanelBankB(1) && !state->isPanelBankB(0) && !state->isBankB();
+    routesOk &= state->getRoute(panel1)->data1 == 99;
+    routesOk &= state->getRoute(panel0)->data1 == state->getConfig(panel0)->ccNumber;
+    state->setPanelBank(1, false);
+    routesOk &= state->getRoute(panel1)->data1 == bankB.ccNumber;
+
+    ControlConfig original = *state->getConfig(5);
+    ControlConfig edited = original;
+    edited.ccNumber = 7;
+    edited.resolution = 1;
+    edited.virtualDevice = 2;
+    state->setConfig(5, edited);
+    routesOk &= state->getRoute(5)->data1 == 7 && state->getRoute(5)->cable == 2
+             && (state->getRoute(5)->flags & ROUTE_FLAG_14BIT);
+    edited.ccNumber = 40;  // No 14-bit pair above CC 31
+    state->setConfig(5, edited);
+    routesOk &= state->getRoute(5)->status == 0 && !midi.processControl(*state->getRoute(5), 64);
+    *state->getConfig(5) = original;  // Edited in place: recompile by hand
+    state->updateRoute(5);
+    routesOk &= state->getRoute(5)->data1 == 5 && state->getRoute(5)->status == 0xB0;
+    Serial.printf("  Routes match configs (both banks, per panel, edits): %s\n", routesOk ? "OK" : "FAILED");
+
+    // Snapshot recall: merged zero levels, only changed controls dirty
+    Snapshot* snapshot = new Snapshot();
+    memset(snapshot, 0, sizeof(Snapshot));
+    for (uint16_t id = 0; id < TOTAL_CONTROLS; id++) {
+        state->setValue(id, 64);
+        snapshot->values[id] = 64;
+    }
+    state->clearAllDirty();
+
+    runBenchmark("StateManager::loadSnapshot (no changes)", 100000, [&](uint32_t) {
+        benchSink(state->loadSnapshot(*snapshot));
+    });
+
+    ControlConfig flagged = *state->getConfig(panel0);
+    flagged.snapshotFlags = SNAPSHOT_FLAG_ZEROED;
+    state->setConfig(panel0, flagged);
+    ControlConfig sendOnLoad = *state->getConfig(panel2);
+    sendOnLoad.flags |= CONTROL_FLAG_SEND_ON_LOAD;
+    state->setConfig(panel2, sendOnLoad);
+
+    for (uint16_t id = 0; id < TOTAL_CONTROLS; id++) {
+        snapshot->values[id] = (id % 3 == 0) ? 64 : 100;  // A third unchanged
+    }
+    snapshot->values[panel2] = 64;                         // Unchanged, sent anyway
+    snapshot->zeroMask[38] = 0x0400;                       // Control 618
+    state->setPanelBank(1, true);
+    state->setZeroMasks(0, 0, 0x02);                       // Bank B: panel 1 out
+
+    uint16_t expected = 0;
+    for (uint16_t id = 0; id < TOTAL_CONTROLS; id++) {
+        bool excluded = id == 618 || id == panel0 || state->getPanel(id) == 1;
+        expected += (!excluded && snapshot->values[id] != 64) ? 1 : 0;
+    }
+
+    uint16_t changed = state->loadSnapshot(*snapshot);
+    bool recallOk = changed == expected;
+    recallOk &= state->getValue(618) == 64 && state->getValue(panel0) == 64 && state->getValue(panel1) == 64;
+    recallOk &= state->getDirtyControls().count() == changed + 1 && state->isDirty(panel2);
+
+    state->setZeroMasks(1, 0, 0);                          // Global zero: nothing recalled
+    for (uint16_t id = 0; id < TOTAL_CONTROLS; id++) {
+        snapshot->values[id] = 0;
+    }
+    recallOk &= state->loadSnapshot(*snapshot) == 0;
+
+    Serial.printf("  Snapshot recall (zero levels merged): %u changed of %u: %s\n",
+        changed, TOTAL_CONTROLS, recallOk ? "OK" : "FAILED");
+
+    state->setZeroMasks(0, 0, 0);
+    state->setPanelBank(1, false);
+    flagged.snapshotFlags = 0;
+    state->setConfig(panel0, flagged);
+    sendOnLoad.flags &= ~CONTROL_FLAG_SEND_ON_LOAD;
+    state->setConfig(panel2, sendOnLoad);
+    state->clearAllDirty();
+    delete snapshot;
+
+    // Sweep 4 knobs at 10k updates/s (4x the output rate); every final
+    // position must still arrive
+    midi.begin();
+    usbMIDI.resetStatistics();
+    memset(s_lastCC, 0xFF, sizeof(s_lastCC));
+    usbMIDI.setSendHook(captureCC);
+
+    for (uint16_t step = 0; step <= 127; step++) {
+        for (uint8_t knob = 0; knob < 4; knob++) {
+            shimAdvanceMicros(25);
+            midi.sendCC(0, 0, 20 + knob, knob & 1 ? 127 - step : step);
+        }
+        midi.update();
+    }
+    uint32_t sweepTime = 128 * 100;
+    while (midi.getPendingCount() > 0) {
+        shimAdvanceMicros(50);
+        sweepTime += 50;
+        midi.update();
+    }
+    usbMIDI.setSendHook(nullptr);
+
+    bool finalSent = s_lastCC[20] == 127 && s_lastCC[21] == 0 && s_lastCC[22] == 127 && s_lastCC[23] == 0;
+    uint32_t maxSends = sweepTime / 400 + 8;  // Rate plus one burst
+    Serial.printf("  Sweep: 512 updates -> %u sent, %u coalesced in %u us, final values %s: %s\n",
+        midi.getMessagesSent(), midi.getMessagesCoalesced(), sweepTime,
+        finalSent ? "sent" : "LOST",
+        (finalSent && midi.getMessagesSent() <= maxSends) ? "OK" : "FAILED");
+
+    // Full-panel sweep: every control moves once per 10 ms for 200 ms, main
+    // loop every 200 us (one message due per two loops at 2,500/s) or every
+    // 1 ms; compare USB transactions per flush policy
+    const MIDIFlushPolicy policies[] = {MIDI_FLUSH_IMMEDIATE, MIDI_FLUSH_LOOP, MIDI_FLUSH_LOOP, MIDI_FLUSH_DEADLINE, MIDI_FLUSH_DEADLINE};
+    const char* policyNames[] = {"immediate", "per loop", "per 1 ms loop", "1 ms deadline", "2 ms deadline"};
+    const uint32_t loopUs[] = {200, 200, 1000, 200, 200};
+    const uint32_t deadlineUs[] = {0, 0, 0, 1000, 2000};
+    for (uint8_t p = 0; p < 5; p++) {
+        midi.begin();
+        midi.setFlushPolicy(policies[p], deadlineUs[p]);
+        usbMIDI.resetStatistics();
+
+        uint32_t loops = 200000 / loopUs[p];
+        uint32_t sweepLoops = 10000 / loopUs[p];
+        for (uint32_t loop = 0; loop < loops; loop++) {
+            shimAdvanceMicros(loopUs[p]);
+            if (loop % sweepLoops == 0) {
+                for (uint16_t id = 0; id < TOTAL_CONTROLS; id++) {
+                    midi.processControl(*state->getRoute(id), (uint8_t)((loop / sweepLoops + id) & 0x7F));
+                }
+            }
+            midi.update();
+        }
+        midi.flush();
+
+        Serial.printf("  Panel sweep, %-13s: %u msgs in %u USB transactions (%.2f msgs/transaction)\n",
+            policyNames[p], midi.getUsbPackets(), usbMIDI.getTransactionCount(),
+            (float)midi.getUsbPackets() / usbMIDI.getTransactionCount());
+    }
+    midi.setFlushPolicy(MIDI_FLUSH_LOOP);
+
+    // Flood device 0 with 80k distinct CC updates/s; device 1 must not wait
+    midi.begin();
+    s_cable1SentAt = 0;
+    usbMIDI.setSendHook(captureCC);
+
+    uint32_t cable1QueuedAt = 0;
+    for (uint32_t loop = 0; loop < 500; loop++) {
+        shimAdvanceMicros(100);
+        for (uint8_t k = 0; k < 8; k++) {
+            midi.sendCC(0, loop & 0x0F, (uint8_t)((loop * 8 + k) & 0x7F), (uint8_t)(loop & 0x7F));
+        }
+        if (loop == 250) {
+            cable1QueuedAt = micros();
+            midi.sendCC(1, 0, 7, 100);
+        }
+        midi.update();
+    }
+    usbMIDI.setSendHook(nullptr);
+
+    uint32_t cable1Latency = s_cable1SentAt - cable1QueuedAt;
+    uint32_t device0Max = 50000 / 400 + 8;
+    Serial.printf("  Device isolation: device 0 sent %u (backlog %u), device 1 latency %u us: %s\n",
+        midi.getDeviceMessagesSent(0), midi.getDevicePendingCount(0), cable1Latency,
+        (s_cable1SentAt != 0 && cable1Latency < 400 && midi.getDeviceMessagesSent(0) <= device0Max) ? "OK" : "FAILED");
+
+    // Relative encoders at 10k detent events/s into a 1,000/s device: merged
+    // messages must still add up to every detent turned
+    ControlConfig encoderConfig;
+    memset(&encoderConfig, 0, sizeof(encoderConfig));
+    encoderConfig.controlType = CONTROL_ENCODER;
+    encoderConfig.flags = CONTROL_FLAG_ENABLED;
+    encoderConfig.ccNumber = 30;
+
+    const int8_t turns[] = {1, 1, 20, -1};
+    bool relativeOk = true;
+    uint32_t relativeSent = 0;
+    for (uint8_t mode = ENCODER_RELATIVE_1; mode <= ENCODER_RELATIVE_3; mode++) {
+        encoderConfig.encoderMode = (EncoderMode)mode;
+        ControlRoute route;
+        buildControlRoute(encoderConfig, false, route);
+
+        midi.begin();
+        midi.setDeviceRate(0, 1000, 1);
+        s_relativeMode = mode;
+        s_relativeSum = 0;
+        usbMIDI.setSendHook(captureRelative);
+
+        int32_t turned = 0;
+        for (uint32_t i = 0; i < 400; i++) {
+            shimAdvanceMicros(100);
+            int8_t delta = turns[i & 3];
+            uint8_t value;
+            if (mode == ENCODER_RELATIVE_1) {
+                value = (uint8_t)(64 + delta);
+            } else if (mode == ENCODER_RELATIVE_3) {
+                value = (uint8_t)(delta & 0x7F);
+            } else {
+                value = delta == 1 ? 65 : (delta == -1 ? 63 : 127);  // Fast = 2 detents
+                delta = delta == 20 ? 2 : delta;
+            }
+            turned += delta;
+            midi.processControl(route, value);
+            midi.update();
+        }
+        while (midi.getPendingCount() > 0) {
+            shimAdvanceMicros(100);
+            midi.update();
+        }
+        usbMIDI.setSendHook(nullptr);
+
+        relativeSent += midi.getMessagesSent();
+        relativeOk &= s_relativeSum == turned && midi.getMessagesCoalesced() > 0 && (route.flags & ROUTE_FLAG_14BIT) == 0;
+    }
+    Serial.printf("  Relative encoders throttled (3 modes, 1,200 events -> %u sent), detents preserved: %s\n",
+        relativeSent, relativeOk ? "OK" : "FAILED");
+    shimUseManualClock(false);
+
+    // Value engine: raw encoder deltas / button presses to CC values
+    ValueEngine* values = new ValueEngine();
+    values->begin(*state);
+
+    runBenchmark("ValueEngine::process (encoder delta)", 1000000, [&](uint32_t i) {
+        EventMessage event = {};
+        event.globalID = i % NUM_ENCODERS;
+        event.value = (i & 1) ? 1 : (uint8_t)-1;
+        event.timestamp = i * 250;
+        ValueResult result;
+        benchSink(values->process(event, 64, result) ? result.midiValue : 0);
+    });
+
+    // Mode checks on a scratch control
+    ControlConfig config = *state->getConfig(0);
+    config.flags = CONTROL_FLAG_ENABLED;
+    config.controlType = CONTROL_ENCODER;
+    config.minValue = 0;
+    config.maxValue = 100;
+    config.acceleration = 0;
+    config.threshold = 1;
+
+    EventMessage event = {};
+    event.globalID = 0;
+    ValueResult result = {};
+    bool ok = true;
+
+    config.encoderMode = ENCODER_ABSOLUTE;
+    values->configure(0, config);
+    event.value = 5;
+    ok &= values->process(event, 98, result) && result.value == 100 && result.midiValue == 100;
+    ok &= !values->process(event, 100, result);             // Pinned at max: nothing to send
+
+    config.encoderMode = ENCODER_RELATIVE_3;
+    values->configure(0, config);
+    event.value = (uint8_t)-1;
+    ok &= values->process(event, 50, result) && result.midiValue == 127 && result.value == 49;
+
+    config.encoderMode = ENCODER_RELATIVE_1;
+    values->configure(0, config);
+    event.value = 3;
+    ok &= values->process(event, 50, result) && result.midiValue == 67;
+
+    // CCW as a magnitude plus direction flag decodes like a signed delta
+    event.value = 3;
+    event.flags = EVENT_FLAG_ENCODER_CCW;
+    ok &= values->process(event, 50, result) && result.midiValue == 61 && result.value == 47;
+    event.value = (uint8_t)-3;
+    ok &= values->process(event, 50, result) && result.midiValue == 61;
+    event.flags = 0;
+
+    config.encoderMode = ENCODER_RELATIVE_2;
+    config.threshold = 3;
+    values->configure(0, config);
+    event.value = (uint8_t)-1;
+    ok &= !values->process(event, 50, result) && !values->process(event, 50, result);
+    ok &= values->process(event, 50, result) && result.midiValue == 0 && result.value == 47;
+
+    // Full acceleration at 40 detents/s: 8x
+    config.encoderMode = ENCODER_ABSOLUTE;
+    config.threshold = 1;
+    config.acceleration = 255;
+    values->configure(0, config);
+    event.value = 1;
+    event.timestamp = 100000;
+    ok &= values->process(event, 0, result) && result.value == 1;
+    event.timestamp += 25000;
+    ok &= values->process(event, 0, result) && result.value == 8;
+
+    config.controlType = CONTROL_BUTTON;
+    config.buttonAction = BUTTON_CC_TOGGLE;
+    values->configure(0, config);
+    event.flags = EVENT_FLAG_BUTTON_PRESSED;
+    ok &= values->process(event, 0, result) && result.value == 100;
+    event.flags = 0;
+    ok &= !values->process(event, 100, result);             // Release ignored
+    event.flags = EVENT_FLAG_BUTTON_PRESSED;
+    ok &= values->process(event, 100, result) && result.value == 0;
+
+    Serial.printf("  ValueEngine mode checks: %s\n", ok ? "OK" : "FAILED");
+
+    // Config edits through StateManager reach the compiled parameters
+    ControlConfig retuned = *state->getConfig(1);
+    retuned.flags |= CONTROL_FLAG_ENABLED;
+    retuned.controlType = CONTROL_ENCODER;
+    retuned.encoderMode = ENCODER_RELATIVE_1;
+    retuned.threshold = 1;
+    retuned.acceleration = 0;
+    state->setConfig(1, retuned);
+    event = {};
+    event.globalID = 1;
+    event.value = 2;
+    bool followed = values->process(event, 64, result) && result.midiValue == 66;
+
+    state->getConfig(1)->encoderMode = ENCODER_RELATIVE_3;
+    state->updateRoute(1);
+    event.value = (uint8_t)-2;
+    followed &= values->process(event, 64, result) && result.midiValue == 126;
+    Serial.printf("  ValueEngine follows setConfig / updateRoute: %s\n", followed ? "OK" : "FAILED");
+    delete values;
+
+    Diagnostics diagnostics;
+    diagnostics.begin();
+
+    runBenchmark("Diagnostics::recordScanCycle", 1000000, [&](uint32_t i) {
+        diagnostics.recordScanCycle(150 + (i & 63));
+    });
+
+    delete state;
+}
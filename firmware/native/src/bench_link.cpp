@@ -0,0 +1,309 @@
+/**
+ * I2C link benchmarks (batched event transfer, slave -> master)
+ *
+ * The slave and master talk over the shim's in-process Wire bus, so byte
+ * counts are exact and timings cover protocol work only (no bus clock).
+ */
+
+#include "Bench.h"
+#include <Wire.h>
+#include <NativeShim.h>
+#include <Protocol.h>
+#include <CRC32.h>
+#include <I2CSlave.h>
+#include <I2CMaster.h>
+#include <MultiI2CMaster.h>
+#include <ControlMap.h>
+
+static const uint8_t LINK_ADDRESS = 0x08;
+
+static void queueEvents(I2CSlave& slave, uint8_t count, uint32_t seed) {
+    for (uint8_t i = 0; i < count; i++) {
+        EventMessage event = {};
+        event.globalID = (uint16_t)((seed + i) % MAX_LOCAL_CONTROLS);  // Panel-local ID
+        event.value = (uint8_t)(seed & 0x7F);
+        event.flags = EVENT_FLAG_ENCODER_CW;
+        slave.queueEvent(event);
+    }
+}
+
+// Shared ready line: two panels' event outputs diode-OR'd onto one master pin
+static const uint8_t SHARED_PIN = 43;
+static const uint8_t SHARED_PIN_A = 41;
+static const uint8_t SHARED_PIN_B = 42;
+
+static uint32_t s_panelBPolls;
+
+static void mirrorSharedLine() {
+    digitalWrite(SHARED_PIN, digitalRead(SHARED_PIN_A) || digitalRead(SHARED_PIN_B));
+}
+
+// Panel B only needs to show when it is addressed (I2CSlave is one per
+// process); being polled services it
+static void onPanelBCommand(int) {
+    s_panelBPolls++;
+    digitalWrite(SHARED_PIN_B, LOW);
+}
+
+template<typename Master>
+static uint32_t drain(Master& master) {
+    uint32_t count = 0;
+    EventMessage event;
+    while (master.getEvent(event)) {
+        count++;
+    }
+    return count;
+}
+
+void runLinkBenchmarks() {
+    benchSection("I2C link (batched events)");
+
+    static const char* CHECK = "123456789";
+    uint32_t crc = CRC32::calculate(CHECK, 9);
+    uint32_t chained = CRC32::update(CRC32::calculate(CHECK, 4), CHECK + 4, 5);
+    Serial.printf("  CRC32(\"123456789\") = 0x%08X: %s\n", crc,
+        (crc == 0xCBF43926 && chained == crc) ? "OK" : "MISMATCH");
+
+    // Slice-by-8 must match byte-at-a-time updates across odd split points
+    static uint8_t block[32768];
+    for (uint32_t i = 0; i < sizeof(block); i++) {
+        block[i] = (uint8_t)(i * 131 + (i >> 7));
+    }
+    uint32_t whole = CRC32::calculate(block, sizeof(block));
+    uint32_t pieces = 0;
+    for (uint32_t offset = 0, step = 1; offset < sizeof(block); offset += step, step = step % 37 + 3) {
+        pieces = CRC32::update(pieces, block + offset, min(step, (uint32_t)sizeof(block) - offset));
+    }
+    uint32_t bytewise = 0;
+    for (uint32_t i = 0; i < sizeof(block); i++) {
+        bytewise = CRC32::update(bytewise, block + i, 1);
+    }
+    Serial.printf("  CRC32 32 KB slice-by-8 == split == bytewise: %s\n",
+        (whole == pieces && whole == bytewise) ? "OK" : "MISMATCH");
+
+    runBenchmark("CRC32::calculate (32 KB, slice-by-8)", 2000, [&](uint32_t i) {
+        block[0] = (uint8_t)i;
+        benchSink(CRC32::calculate(block, sizeof(block)));
+    });
+    runBenchmark("CRC32::update (32 KB, byte at a time)", 200, [&](uint32_t) {
+        uint32_t c = 0;
+        for (uint32_t b = 0; b < sizeof(block); b++) {
+            c = CRC32::update(c, block + b, 1);
+        }
+        benchSink(c);
+    });
+
+    BatchEventMessage batch = {};
+    runBenchmark("CRC32::calculate (full batch)", 1000000, [&](uint32_t i) {
+        batch.sequenceNumber = (uint8_t)i;
+        benchSink(CRC32::calculate(&batch, BATCH_HEADER_SIZE + sizeof(batch.events)));
+    });
+
+    // Slave on its own shim port so it does not share a TwoWire with a master
+    TwoWire slaveBus(3);
+    I2CSlave slave(LINK_ADDRESS, slaveBus);
+    slave.begin(-1, -1);
+
+    I2CMaster master(Wire);
+    master.addSlave(LINK_ADDRESS);
+    master.begin();
+
+    // Idle poll: command + 4-byte header (was command + full 49-byte struct)
+    Wire.resetStatistics();
+    master.poll();
+    Serial.printf("  Bytes per idle poll: %u (unbatched protocol: %u)\n",
+        Wire.getBytesTransferred(), 2 + 1 + 49);
+
+    Wire.resetStatistics();
+    queueEvents(slave, MAX_EVENTS_PER_BATCH, 0);
+    master.poll();
+    Serial.printf("  Bytes per full batch (%u events): %u, delivered: %u\n",
+        MAX_EVENTS_PER_BATCH, Wire.getBytesTransferred(), drain(master));
+
+    runBenchmark("I2CMaster::poll (idle)", 1000000, [&](uint32_t) {
+        master.poll();
+    });
+
+    runBenchmark("I2CMaster::poll (6 events)", 200000, [&](uint32_t i) {
+        queueEvents(slave, MAX_EVENTS_PER_BATCH, i);
+        master.poll();
+        benchSink(drain(master));
+    });
+
+    // Another reader takes one batch: the master sees a sequence gap
+    I2CLinkStats before;
+    master.getLinkStats(LINK_ADDRESS, before);
+
+    queueEvents(slave, 3, 1);
+    uint8_t stolen[sizeof(BatchEventMessage)];
+    Wire.beginTransmission(LINK_ADDRESS);
+    Wire.write(CMD_GET_EVENTS);
+    Wire.endTransmission();
+    Wire.requestFrom(LINK_ADDRESS, BATCH_HEADER_SIZE);
+    Wire.readBytes(stolen, BATCH_HEADER_SIZE);
+    Wire.requestFrom(LINK_ADDRESS, batchPayloadSize(3));
+    Wire.readBytes(stolen, batchPayloadSize(3));
+
+    queueEvents(slave, 2, 2);
+    master.poll();
+    drain(master);
+
+    I2CLinkStats after;
+    master.getLinkStats(LINK_ADDRESS, after);
+    Serial.printf("  Lost batch detection: lost=%u, crc errors=%u: %s\n",
+        after.batchesLost - before.batchesLost, after.checksumErrors,
+        (after.batchesLost - before.batchesLost == 1 && after.checksumErrors == 0) ? "OK" : "FAIL");
+
+    // Every panel control maps to a distinct global ID below the snapshot range
+    static uint8_t hits[TOTAL_CONTROLS];
+    memset(hits, 0, sizeof(hits));
+    bool unique = true;
+    for (uint8_t panel = 0; panel < NUM_PANELS; panel++) {
+        for (uint8_t local = 0; local < MAX_LOCAL_CONTROLS; local++) {
+            uint16_t id = mapControlID(panel, local);
+            if (id != CONTROL_MAP_INVALID) {
+                unique &= id < GLOBAL_SNAPSHOT_BASE && hits[id]++ == 0;
+            }
+        }
+    }
+    for (uint16_t id = 0; id < GLOBAL_SNAPSHOT_BASE; id++) {
+        unique &= hits[id] == 1;
+    }
+    Serial.printf("  ControlMap covers global IDs 0-%u once each: %s\n",
+        GLOBAL_SNAPSHOT_BASE - 1, unique ? "OK" : "FAIL");
+
+    runBenchmark("mapControlID", 10000000, [&](uint32_t i) {
+        benchSink(mapControlID(i % NUM_PANELS, i % MAX_LOCAL_CONTROLS));
+    });
+
+    // Three buses, one AsyncI2CBus transfer in flight on each. Only 0x08
+    // answers here; the other eight slaves NACK their command byte. Events
+    // come out with global IDs (panel 0 maps local N to ControlMap entry N).
+    MultiI2CMaster multi;
+    multi.begin();
+
+    uint32_t queued = 0;
+    uint32_t delivered = 0;
+    bool inOrder = true;
+    for (uint32_t round = 0; round < 1000; round++) {
+        uint8_t count = round % (MAX_EVENTS_PER_BATCH + 1);
+        queueEvents(slave, count, queued);
+        queued += count;
+
+        // 3 transfers per slave when it has events: command, header, payload
+        for (uint8_t i = 0; i < 3 * 3; i++) {
+            multi.poll();
+        }
+
+        EventMessage event;
+        while (multi.getEvent(event)) {
+            inOrder &= event.globalID == mapControlID(0, delivered % MAX_LOCAL_CONTROLS);
+            delivered++;
+        }
+    }
+    Serial.printf("  MultiI2CMaster delivered %u of %u events in order: %s\n",
+        delivered, queued, (delivered == queued && inOrder) ? "OK" : "FAIL");
+
+    runBenchmark("MultiI2CMaster::poll (3 buses)", 1000000, [&](uint32_t) {
+        multi.poll();
+    });
+
+    // Bus time for one idle poll of every slave at 1 MHz (9 clocks per
+    // byte): blocking Wire visits the 9 slaves one after another, the
+    // async engine visits the 3 slaves of each bus while the others run
+    Wire.resetStatistics();
+    master.poll();
+    uint32_t idleUs = Wire.getBytesTransferred() * 9;
+    Serial.printf("  Idle round, 9 slaves @ 1MHz: blocking %u us, parallel buses %u us\n",
+        idleUs * 9, idleUs * 3);
+
+    // Ready line: the slave's event pin raises the master's pin ISR, which
+    // only flags the slave. Nothing is polled until then; a backlog larger
+    // than one batch brings the master straight back.
+    static const uint8_t READY_PIN = 40;
+    shimUseManualClock(true);
+    shimSetMicros(0);
+    {
+        TwoWire readyBus(4);
+        I2CSlave readySlave(LINK_ADDRESS, readyBus, READY_PIN);
+        readySlave.begin(-1, -1);
+
+        MultiI2CMaster ready;
+        ready.begin();
+        ready.setPollInterval(1000000);  // Slaves without a line: once a second
+        ready.setEventPin(LINK_ADDRESS, READY_PIN);
+
+        for (uint32_t i = 0; i < 100; i++) {
+            ready.poll();
+        }
+        uint32_t idlePolls = ready.getPollCount();
+
+        auto pollsFor = [&](uint8_t count) {
+            uint32_t before = ready.getPollCount();
+            queueEvents(readySlave, count, 0);
+            readySlave.update();  // Drives READY_PIN high
+            for (uint32_t i = 0; i < 100; i++) {
+                ready.poll();
+                readySlave.update();
+            }
+            return ready.getPollCount() - before;
+        };
+
+        uint32_t smallPolls = pollsFor(3);
+        uint32_t smallEvents = drain(ready);
+        uint32_t largePolls = pollsFor(20);
+        uint32_t largeEvents = drain(ready);
+
+        Serial.printf("  Ready line: %u idle polls, 3 events in %u poll(s), 20 events in %u polls: %s\n",
+            idlePolls, smallPolls, largePolls,
+            (idlePolls == 0 && smallPolls == 1 && smallEvents == 3 &&
+             largePolls == 4 && largeEvents == 20) ? "OK" : "FAIL");
+    }
+
+    // Shared line: panel B raises its output while panel A still holds the
+    // line high, so no edge comes; B must be polled when A finishes, not at
+    // the next safety poll
+    {
+        TwoWire busA(5);
+        TwoWire busB(6);
+        I2CSlave slaveA(0x08, busA, SHARED_PIN_A);
+        slaveA.begin(-1, -1);
+        busB.begin(0x0B, -1, -1, 1000000);  // Other bus: polled alongside A
+        busB.onReceive(onPanelBCommand);
+        digitalWrite(SHARED_PIN_B, LOW);
+        attachInterrupt(digitalPinToInterrupt(SHARED_PIN_A), mirrorSharedLine, CHANGE);
+        attachInterrupt(digitalPinToInterrupt(SHARED_PIN_B), mirrorSharedLine, CHANGE);
+
+        MultiI2CMaster shared;
+        shared.begin();
+        shared.setPollInterval(1000000);
+        shared.setSharedEventPin(SHARED_PIN);
+
+        auto run = [&](uint32_t polls) {
+            for (uint32_t i = 0; i < polls; i++) {
+                shared.poll();
+                slaveA.update();
+            }
+        };
+
+        queueEvents(slaveA, 20, 0);
+        slaveA.update();
+        run(6);                 // Both flagged by the edge and polled once
+        bool aBusy = digitalRead(SHARED_PIN_A);
+        uint32_t bPolls = s_panelBPolls;
+        digitalWrite(SHARED_PIN_B, HIGH);  // Line already high: no edge
+        run(100);
+        uint32_t sharedEvents = drain(shared);
+        bool bServiced = s_panelBPolls > bPolls;
+        bool lineIdle = !digitalRead(SHARED_PIN);
+
+        Serial.printf("  Shared ready line, 2 panels: A %u of 20 events, B %s, line %s: %s\n",
+            sharedEvents, bServiced ? "polled" : "MISSED", lineIdle ? "idle" : "HIGH",
+            (aBusy && sharedEvents == 20 && bServiced && lineIdle) ? "OK" : "FAIL");
+
+        detachInterrupt(digitalPinToInterrupt(SHARED_PIN_A));
+        detachInterrupt(digitalPinToInterrupt(SHARED_PIN_B));
+        detachInterrupt(digitalPinToInterrupt(SHARED_PIN));
+    }
+    shimUseManualClock(false);
+}
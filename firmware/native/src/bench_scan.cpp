@@ -0,0 +1,330 @@
+/**
+ * Scan-path benchmarks (ESP32 peripheral Core 0 work per scan cycle)
+ */
+
+#include "Bench.h"
+#include <NativeShim.h>
+#include <Protocol.h>
+#include <EncoderDecoder.h>
+#include <ButtonHandler.h>
+#include <ShiftRegisterDMA.h>
+#include <FrameDiff.h>
+#include <LockFreeQueue.h>
+
+// Same layout as esp32_peripheral: 32 encoders (64 bits) + 36 buttons, 13 chips
+static const uint8_t SCAN_NUM_CHIPS = 13;
+static const uint16_t SCAN_NUM_ENCODERS = 32;
+static const uint16_t SCAN_NUM_BUTTONS = 36;
+static const uint16_t SCAN_BUTTON_OFFSET = 64;
+
+static const uint16_t NUM_FRAMES = 256;
+static uint8_t s_idleFrames[NUM_FRAMES][SCAN_NUM_CHIPS];
+static uint8_t s_busyFrames[NUM_FRAMES][SCAN_NUM_CHIPS];
+
+// Clockwise Gray sequence for (CLK | DT << 1): 00 -> 01 -> 11 -> 10
+static const uint8_t GRAY_CW[4] = {0x0, 0x1, 0x3, 0x2};
+
+static void setEncoderBits(uint8_t* frame, uint16_t encoder, uint8_t bits) {
+    uint16_t bitIndex = encoder * 2;
+    frame[bitIndex / 8] &= ~(0x03 << (bitIndex % 8));
+    frame[bitIndex / 8] |= (bits & 0x03) << (bitIndex % 8);
+}
+
+static void buildFrames() {
+    for (uint16_t f = 0; f < NUM_FRAMES; f++) {
+        // Idle: all encoders parked on a detent, all buttons released (active low)
+        memset(s_idleFrames[f], 0, SCAN_NUM_CHIPS);
+        for (uint16_t b = 0; b < SCAN_NUM_BUTTONS; b++) {
+            uint16_t bit = SCAN_BUTTON_OFFSET + b;
+            s_idleFrames[f][bit / 8] |= 1 << (bit % 8);
+        }
+
+        // Busy: 8 encoders turning (alternating direction), 4 buttons toggling
+        memcpy(s_busyFrames[f], s_idleFrames[f], SCAN_NUM_CHIPS);
+        for (uint16_t e = 0; e < 8; e++) {
+            uint16_t encoder = e * 4;
+            uint8_t phase = (e & 1) ? (uint8_t)(3 - (f & 3)) : (uint8_t)(f & 3);
+            setEncoderBits(s_busyFrames[f], encoder, GRAY_CW[phase]);
+        }
+        for (uint16_t b = 0; b < 4; b++) {
+            if ((f >> 4) & 1) {
+                uint16_t bit = SCAN_BUTTON_OFFSET + b * 9;
+                s_busyFrames[f][bit / 8] &= ~(1 << (bit % 8));
+            }
+        }
+    }
+}
+
+// SPI frame source: play back the busy frames in order
+static uint32_t s_nextFrame = 0;
+
+static void busyFrameSource(uint8_t* buffer, size_t length, void* /*arg*/) {
+    memcpy(buffer, s_busyFrames[s_nextFrame++ & (NUM_FRAMES - 1)], length);
+}
+
+static void countFrameReady(const uint8_t* /*frame*/, void* arg) {
+    (*(uint32_t*)arg)++;
+}
+
+void runScanBenchmarks() {
+    buildFrames();
+
+    benchSection("Scan path (32 encoders + 36 buttons)");
+
+    EncoderDecoder encoders(SCAN_NUM_ENCODERS);
+    encoders.begin();
+
+    encoders.setDecodeMode(EncoderDecoder::DECODE_TABLE);
+    runBenchmark("EncoderDecoder::update table (idle)", 200000, [&](uint32_t i) {
+        encoders.update(s_idleFrames[i & (NUM_FRAMES - 1)]);
+    });
+
+    runBenchmark("EncoderDecoder::update table (8 turning)", 200000, [&](uint32_t i) {
+        encoders.update(s_busyFrames[i & (NUM_FRAMES - 1)]);
+    });
+
+    encoders.setDecodeMode(EncoderDecoder::DECODE_PARALLEL);
+    runBenchmark("EncoderDecoder::update parallel (idle)", 200000, [&](uint32_t i) {
+        encoders.update(s_idleFrames[i & (NUM_FRAMES - 1)]);
+    });
+
+    runBenchmark("EncoderDecoder::update parallel (8 turning)", 200000, [&](uint32_t i) {
+        encoders.update(s_busyFrames[i & (NUM_FRAMES - 1)]);
+    });
+
+    runBenchmark("EncoderDecoder::getDelta x32", 200000, [&](uint32_t) {
+        int32_t sum = 0;
+        for (uint16_t e = 0; e < SCAN_NUM_ENCODERS; e++) {
+            sum += encoders.getDelta(e);
+        }
+        benchSink(sum);
+    });
+
+    runBenchmark("EncoderDecoder::getPendingMask + getDelta", 200000, [&](uint32_t) {
+        int32_t sum = 0;
+        for (uint8_t w = 0; w < encoders.getNumWords(); w++) {
+            uint32_t pending = encoders.getPendingMask(w);
+            while (pending) {
+                uint8_t bit = __builtin_ctz(pending);
+                pending &= pending - 1;
+                sum += encoders.getDelta(w * 32 + bit);
+            }
+        }
+        benchSink(sum);
+    });
+
+    // Both decode paths must agree on every position for random input
+    EncoderDecoder tableDecoder(SCAN_NUM_ENCODERS);
+    EncoderDecoder parallelDecoder(SCAN_NUM_ENCODERS);
+    tableDecoder.begin();
+    parallelDecoder.begin();
+    tableDecoder.setDecodeMode(EncoderDecoder::DECODE_TABLE);
+
+    uint32_t seed = 12345;
+    uint8_t randomFrame[SCAN_NUM_CHIPS];
+    for (uint32_t f = 0; f < 10000; f++) {
+        for (uint8_t b = 0; b < SCAN_NUM_CHIPS; b++) {
+            seed = seed * 1664525 + 1013904223;
+            randomFrame[b] = (uint8_t)(seed >> 24);
+        }
+        tableDecoder.update(randomFrame);
+        parallelDecoder.update(randomFrame);
+    }
+
+    bool match = true;
+    for (uint16_t e = 0; e < SCAN_NUM_ENCODERS; e++) {
+        match &= tableDecoder.getPosition(e) == parallelDecoder.getPosition(e);
+    }
+    Serial.printf("  Table vs parallel decode (10000 random frames): %s\n", match ? "MATCH" : "MISMATCH");
+
+    ButtonHandler buttons(SCAN_NUM_BUTTONS);
+    buttons.begin(true);
+
+    runBenchmark("ButtonHandler::update history (idle)", 200000, [&](uint32_t i) {
+        buttons.update(s_idleFrames[i & (NUM_FRAMES - 1)], SCAN_BUTTON_OFFSET);
+    });
+
+    runBenchmark("ButtonHandler::update history (4 toggling)", 200000, [&](uint32_t i) {
+        buttons.update(s_busyFrames[i & (NUM_FRAMES - 1)], SCAN_BUTTON_OFFSET);
+    });
+
+    runBenchmark("ButtonHandler::isPressed/isReleased x36", 200000, [&](uint32_t) {
+        uint32_t count = 0;
+        for (uint16_t b = 0; b < SCAN_NUM_BUTTONS; b++) {
+            count += buttons.isPressed(b);
+            count += buttons.isReleased(b);
+        }
+        benchSink(count);
+    });
+
+    buttons.begin(true, ButtonHandler::DEBOUNCE_VERTICAL);
+
+    runBenchmark("ButtonHandler::update vertical (idle)", 200000, [&](uint32_t i) {
+        buttons.update(s_idleFrames[i & (NUM_FRAMES - 1)], SCAN_BUTTON_OFFSET);
+    });
+
+    runBenchmark("ButtonHandler::update vertical (4 toggling)", 200000, [&](uint32_t i) {
+        buttons.update(s_busyFrames[i & (NUM_FRAMES - 1)], SCAN_BUTTON_OFFSET);
+    });
+
+    runBenchmark("ButtonHandler::take*Mask + ctz", 200000, [&](uint32_t) {
+        uint32_t count = 0;
+        for (uint8_t w = 0; w < buttons.getNumWords(); w++) {
+            uint32_t edges = buttons.takePressedMask(w) | buttons.takeReleasedMask(w);
+            while (edges) {
+                count += __builtin_ctz(edges);
+                edges &= edges - 1;
+            }
+        }
+        benchSink(count);
+    });
+
+    // A press must appear after exactly 8 consistent samples, in both engines
+    ButtonHandler history(SCAN_NUM_BUTTONS);
+    ButtonHandler vertical(SCAN_NUM_BUTTONS);
+    history.begin(true);
+    vertical.begin(true, ButtonHandler::DEBOUNCE_VERTICAL);
+
+    uint8_t pressedFrame[SCAN_NUM_CHIPS];
+    memcpy(pressedFrame, s_idleFrames[0], SCAN_NUM_CHIPS);
+    pressedFrame[(SCAN_BUTTON_OFFSET + 35) / 8] &= ~(1 << ((SCAN_BUTTON_OFFSET + 35) % 8));
+
+    int historySample = -1;
+    int verticalSample = -1;
+    for (int sample = 1; sample <= 10; sample++) {
+        history.update(pressedFrame, SCAN_BUTTON_OFFSET);
+        vertical.update(pressedFrame, SCAN_BUTTON_OFFSET);
+        if (historySample < 0 && history.isPressed(35)) historySample = sample;
+        if (verticalSample < 0 && (vertical.takePressedMask(1) & (1UL << 3))) verticalSample = sample;
+    }
+    Serial.printf("  Press detected after sample: history=%d vertical=%d\n", historySample, verticalSample);
+
+    // Full scan front end as run by core0_scanner_task
+    FrameDiff frameDiff(SCAN_NUM_CHIPS);
+    auto scanCycle = [&](const uint8_t* data, bool useDiff) {
+        if (!useDiff) {
+            encoders.update(data);
+            buttons.update(data, SCAN_BUTTON_OFFSET);
+        } else if (frameDiff.compare(data) || !buttons.isSettled()) {
+            encoders.update(data, frameDiff.getDiff());
+            buttons.update(data, SCAN_BUTTON_OFFSET, frameDiff.getDiff());
+        }
+    };
+
+    runBenchmark("FrameDiff::compare (13 bytes)", 1000000, [&](uint32_t i) {
+        benchSink(frameDiff.compare(s_busyFrames[i & (NUM_FRAMES - 1)]));
+    });
+
+    runBenchmark("Scan decode, no frame diff (idle)", 200000, [&](uint32_t i) {
+        scanCycle(s_idleFrames[i & (NUM_FRAMES - 1)], false);
+    });
+
+    frameDiff.begin();
+    runBenchmark("Scan decode, frame diff (idle)", 200000, [&](uint32_t i) {
+        scanCycle(s_idleFrames[i & (NUM_FRAMES - 1)], true);
+    });
+    Serial.printf("  Idle cycles skipped: %u of %u\n",
+        frameDiff.getUnchangedCount(), frameDiff.getUnchangedCount() + frameDiff.getChangedCount());
+
+    runBenchmark("Scan decode, no frame diff (busy)", 200000, [&](uint32_t i) {
+        scanCycle(s_busyFrames[i & (NUM_FRAMES - 1)], false);
+    });
+
+    frameDiff.begin();
+    runBenchmark("Scan decode, frame diff (busy)", 200000, [&](uint32_t i) {
+        scanCycle(s_busyFrames[i & (NUM_FRAMES - 1)], true);
+    });
+
+    // Diff-driven decode must give the same positions and button edges as a
+    // full decode of every frame (sparse random changes, bouncing buttons)
+    EncoderDecoder fullEncoders(SCAN_NUM_ENCODERS);
+    ButtonHandler fullButtons(SCAN_NUM_BUTTONS);
+    fullEncoders.begin();
+    fullButtons.begin(true, ButtonHandler::DEBOUNCE_VERTICAL);
+    encoders.begin();
+    buttons.begin(true, ButtonHandler::DEBOUNCE_VERTICAL);
+    frameDiff.begin();
+
+    uint8_t sparseFrame[SCAN_NUM_CHIPS];
+    memcpy(sparseFrame, s_idleFrames[0], SCAN_NUM_CHIPS);
+    bool diffMatch = true;
+    for (uint32_t f = 0; f < 20000; f++) {
+        seed = seed * 1664525 + 1013904223;
+        if ((seed >> 28) == 0) {
+            uint16_t bit = (seed >> 8) % (SCAN_BUTTON_OFFSET + SCAN_NUM_BUTTONS);
+            sparseFrame[bit / 8] ^= 1 << (bit % 8);
+        }
+        scanCycle(sparseFrame, true);
+        fullEncoders.update(sparseFrame);
+        fullButtons.update(sparseFrame, SCAN_BUTTON_OFFSET);
+
+        for (uint8_t w = 0; w < buttons.getNumWords(); w++) {
+            diffMatch &= buttons.takePressedMask(w) == fullButtons.takePressedMask(w);
+            diffMatch &= buttons.takeReleasedMask(w) == fullButtons.takeReleasedMask(w);
+        }
+    }
+    for (uint16_t e = 0; e < SCAN_NUM_ENCODERS; e++) {
+        diffMatch &= encoders.getPosition(e) == fullEncoders.getPosition(e);
+    }
+    Serial.printf("  Frame diff vs full decode (20000 sparse frames): %s, %u skipped\n",
+        diffMatch ? "MATCH" : "MISMATCH", frameDiff.getUnchangedCount());
+
+    // DMA front end: single-shot (latch, transfer, wait) vs ping-pong. The
+    // host shim completes transfers instantly, so this measures driver and
+    // bookkeeping overhead; on the ESP32 ping-pong also hides the transfer.
+    ShiftRegisterDMA shiftReg(VSPI_HOST, 12, 14, 27, SCAN_NUM_CHIPS);
+    shiftReg.begin(1000000);
+    shimSetSpiFrameSource(busyFrameSource, nullptr);
+    shimUseManualClock(true);  // Latch pulse delays advance virtual time only
+
+    runBenchmark("ShiftRegisterDMA single-shot + decode", 200000, [&](uint32_t) {
+        shiftReg.startDMA();
+        shiftReg.waitForDMA();
+        encoders.update(shiftReg.getDMABuffer());
+    });
+
+    // Overrun: a transfer outlives waitForDMA(); tick latches are skipped
+    // while it shifts, and the next startDMA() collects it and latches
+    shimSpiStall(true);
+    bool overrunOk = shiftReg.startDMA() && !shiftReg.waitForDMA(1);
+    overrunOk &= !shiftReg.latchIfIdle() && !shiftReg.startDMA(false);
+    shimSpiStall(false);
+    overrunOk &= shiftReg.startDMA(false) && shiftReg.waitForDMA() && shiftReg.latchIfIdle();
+    Serial.printf("  DMA timeout recovery: %s\n", overrunOk ? "OK" : "FAILED");
+
+    uint32_t readyCount = 0;
+    shiftReg.setFrameReadyCallback(countFrameReady, &readyCount);
+    shiftReg.startContinuous();
+    runBenchmark("ShiftRegisterDMA ping-pong + decode", 200000, [&](uint32_t) {
+        const uint8_t* data = shiftReg.waitForFrame();
+        encoders.update(data);
+        shiftReg.releaseFrame();
+    });
+
+    // Frames must come back in order, alternating buffers
+    bool inOrder = true;
+    const uint8_t* lastBuffer = nullptr;
+    for (uint32_t f = 0; f < 1000; f++) {
+        uint32_t expected = s_nextFrame;
+        const uint8_t* data = shiftReg.waitForFrame();
+        inOrder &= data != nullptr && data != lastBuffer &&
+            memcmp(data, s_busyFrames[expected & (NUM_FRAMES - 1)], SCAN_NUM_CHIPS) == 0;
+        lastBuffer = data;
+        shiftReg.releaseFrame();
+    }
+    shiftReg.stopContinuous();
+    shimUseManualClock(false);
+    shimSetSpiFrameSource(nullptr, nullptr);
+
+    Serial.printf("  Ping-pong frame order: %s, %u frame-ready callbacks\n",
+        inOrder ? "OK" : "WRONG", readyCount);
+
+    LockFreeQueue<EventMessage> queue(128);
+
+    runBenchmark("LockFreeQueue push+pop", 1000000, [&](uint32_t i) {
+        EventMessage event = {(uint16_t)(i & 0x3F), 1, EVENT_FLAG_ENCODER_CW, i};
+        queue.push(event);
+        queue.pop(event);
+        benchSink(event);
+    });
+}
@@ -0,0 +1,328 @@
+/**
+ * Session storage benchmarks (ESP32 WiFi node, simulated SPI SD card)
+ */
+
+#include "Bench.h"
+#include <NativeShim.h>
+#include <Protocol.h>
+#include <SessionManager.h>
+
+// Typical SPI-mode SD card on the ESP32 (20 MHz bus)
+static const uint32_t SD_COMMAND_US = 250;
+static const uint32_t SD_READ_KBPS = 900;
+static const uint32_t SD_WRITE_KBPS = 450;
+
+static const char* SECTION_NAMES[SESSION_SECTION_COUNT] = {"header", "controls", "snapshot", "masks"};
+
+static void fillSession(SessionFile& session, uint32_t seed) {
+    memset(&session, 0, sizeof(SessionFile));
+
+    uint32_t x = seed;
+    uint8_t* bytes = (uint8_t*)&session;
+    for (uint32_t i = 0; i < SessionManager::getLegacySize(); i++) {
+        x = x * 1664525 + 1013904223;
+        bytes[i] = x >> 24;
+    }
+
+    // Not stored: reserved bytes and padding load as zero
+    memset(session.reserved, 0, sizeof(session.reserved));
+    for (uint8_t s = 0; s < NUM_SNAPSHOTS; s++) {
+        memset(session.snapshots[s].reserved, 0, sizeof(session.snapshots[s].reserved));
+    }
+    memset(session.padding, 0, sizeof(session.padding));
+}
+
+void runSessionBenchmarks() {
+    benchSection("Session storage (SD, 250 us/cmd, 900/450 KB/s)");
+
+    shimSdFormat();
+    SessionManager* sessions = new SessionManager();
+    bool beginOk = sessions->begin();
+
+    SessionFile* session = new SessionFile();
+    SessionFile* loaded = new SessionFile();
+    fillSession(*session, 12345);
+
+    shimUseManualClock(true);
+    shimSdSetTiming(SD_COMMAND_US, SD_READ_KBPS, SD_WRITE_KBPS);
+
+    // Full save in the compact format
+    shimSdResetStats();
+    bool saveOk = beginOk && sessions->save(3, *session);
+    ShimSdStats saveStats = shimSdGetStats();
+    File file = SD.open("/sessions/session003.bin", FILE_READ);
+    uint32_t fileSize = file.size();
+    file.close();
+    saveOk &= fileSize == SessionManager::getCompactSize(*session);
+    saveOk &= sessions->getFormatVersion(3) == SESSION_FORMAT_VERSION;
+    Serial.printf("  Save: %u bytes (%s), %u writes, %u sectors, %.1f ms\n",
+                  fileSize, saveOk ? "OK" : "FAILED",
+                  saveStats.writeCalls, saveStats.sectorsWritten, sessions->getLastSaveUs() / 1000.0f);
+
+    // Size per session and for all 128 slots: fixed struct vs compact
+    SessionFile* sparse = new SessionFile();
+    fillSession(*sparse, 777);
+    for (uint8_t s = 4; s < NUM_SNAPSHOTS; s++) {
+        memset(&sparse->snapshots[s], 0, sizeof(Snapshot));
+    }
+    uint32_t fullSize = SessionManager::getCompactSize(*session);
+    uint32_t sparseSize = SessionManager::getCompactSize(*sparse);
+    Serial.printf("  Size: fixed %u B, compact %u B (16 snapshots), %u B (4 snapshots)\n",
+                  (uint32_t)sizeof(SessionFile), fullSize, sparseSize);
+    Serial.printf("  128 sessions: fixed %.1f MB, compact %.1f-%.1f MB\n",
+                  NUM_SESSIONS * (float)sizeof(SessionFile) / 1048576.0f,
+                  NUM_SESSIONS * (float)sparseSize / 1048576.0f,
+                  NUM_SESSIONS * (float)fullSize / 1048576.0f);
+
+    // Full load round trip
+    memset(loaded, 0xA5, sizeof(SessionFile));
+    shimSdResetStats();
+    bool loadOk = sessions->load(3, *loaded);
+    ShimSdStats loadStats = shimSdGetStats();
+    loadOk &= memcmp(session, loaded, sizeof(SessionFile)) == 0;
+    Serial.printf("  Load: round trip %s, %u reads, %u sectors, %.1f ms\n",
+                  loadOk ? "OK" : "FAILED",
+                  loadStats.readCalls, loadStats.sectorsRead, sessions->getLastLoadUs() / 1000.0f);
+
+    // Old fixed layout: raw struct written whole, read section by section, converted
+    sessions->save(10, *sparse);    // Fills its CRCs, as conversion will
+    file = SD.open("/sessions/session009.bin", FILE_WRITE);
+    file.write((const uint8_t*)sparse, sizeof(SessionFile));
+    file.close();
+    memset(loaded, 0xA5, sizeof(SessionFile));
+    uint32_t start = micros();
+    bool legacyOk = sessions->getFormatVersion(9) == 1 && sessions->load(9, *loaded);
+    uint32_t legacyUs = micros() - start;
+    legacyOk &= memcmp(sparse, loaded, sizeof(SessionFile)) == 0;
+
+    bool convertOk = sessions->convert(9, *loaded) && sessions->getFormatVersion(9) == SESSION_FORMAT_VERSION;
+    memset(loaded, 0xA5, sizeof(SessionFile));
+    start = micros();
+    convertOk &= sessions->load(9, *loaded);
+    uint32_t compactUs = micros() - start;
+    convertOk &= memcmp(sparse, loaded, sizeof(SessionFile)) == 0;
+    Serial.printf("  Fixed-layout load %s (%.1f ms), converted %s, compact load %.1f ms\n",
+                  legacyOk ? "OK" : "FAILED", legacyUs / 1000.0f,
+                  convertOk ? "OK" : "FAILED", compactUs / 1000.0f);
+
+    // Single-section loads touch only their sectors (layout from the index)
+    sessions->load(3, *loaded);
+    shimSdResetStats();
+    start = micros();
+    bool sectionOk = sessions->loadSection(3, SESSION_SECTION_SNAPSHOT, *loaded, 5);
+    uint32_t sectionUs = micros() - start;
+    ShimSdStats snapshotStats = shimSdGetStats();
+    sectionOk &= memcmp(&session->snapshots[5], &loaded->snapshots[5], sizeof(Snapshot)) == 0;
+    sectionOk &= snapshotStats.sectorsRead <= 2;
+    Serial.printf("  Snapshot 5 alone: %u sectors, %.2f ms (%s)\n",
+                  snapshotStats.sectorsRead, sectionUs / 1000.0f, sectionOk ? "OK" : "FAILED");
+
+    // In-place section save (read-modify-write of the edge sectors)
+    session->snapshots[7].values[100] ^= 0xFF;
+    session->globalZeroMask ^= 1;
+    bool inPlaceOk = sessions->saveSection(3, SESSION_SECTION_SNAPSHOT, *session, 7)
+                  && sessions->saveSection(3, SESSION_SECTION_MASKS, *session);
+    inPlaceOk &= sessions->load(3, *loaded) && memcmp(session, loaded, sizeof(SessionFile)) == 0;
+    Serial.printf("  In-place section saves: %s\n", inPlaceOk ? "OK" : "FAILED");
+
+    // A flipped byte on the card fails the load
+    file = SD.open("/sessions/session003.bin", "r+");
+    file.seek(20000);
+    uint8_t byte = file.read() ^ 0x10;
+    file.seek(20000);
+    file.write(byte);
+    file.close();
+    uint32_t crcErrors = sessions->getCrcErrorCount();
+    bool corruptOk = !sessions->load(3, *loaded) && sessions->getCrcErrorCount() == crcErrors + 1;
+    corruptOk &= sessions->save(3, *session) && sessions->load(3, *loaded);
+    Serial.printf("  Corrupted byte detected by CRC: %s\n", corruptOk ? "OK" : "FAILED");
+
+    // Per-section timing (one snapshot)
+    for (uint8_t s = 0; s < SESSION_SECTION_COUNT; s++) {
+        sessions->loadSection(3, (SessionSection)s, *loaded, 2);
+        sessions->saveSection(3, (SessionSection)s, *session, 2);
+        const SessionSectionStats& stats = sessions->getSectionStats((SessionSection)s);
+        Serial.printf("  Section %-9s %6u bytes  load %7.2f ms  save %7.2f ms\n",
+                      SECTION_NAMES[s], stats.bytes, stats.lastLoadUs / 1000.0f, stats.lastSaveUs / 1000.0f);
+    }
+
+    // Differential autosave: only the edits go out
+    sessions->save(3, *session);
+    sessions->attach(3, session);
+    struct { const char* name; uint16_t controls; bool snapshot; } edits[] = {
+        {"1 control   ", 1, false},
+        {"10 controls ", 10, false},
+        {"1 snapshot  ", 0, true},
+    };
+    bool deltaOk = true;
+    for (const auto& edit : edits) {
+        for (uint16_t c = 0; c < edit.controls; c++) {
+            uint16_t id = 37 + c * 53;
+            session->controls[id].ccNumber ^= 1;
+            sessions->markControlChanged(id);
+        }
+        if (edit.snapshot) {
+            session->snapshots[4].values[9] ^= 0x33;
+            sessions->markSnapshotChanged(4);
+        }
+        shimSdResetStats();
+        deltaOk &= sessions->saveChanges() && !sessions->isModified();
+        ShimSdStats deltaStats = shimSdGetStats();
+        uint32_t deltaUs = sessions->getLastSaveUs();
+        deltaOk &= sessions->load(3, *loaded) && memcmp(session, loaded, sizeof(SessionFile)) == 0;
+        Serial.printf("  Autosave %s %5u bytes, %3u sectors, %6.1f ms\n",
+                      edit.name, sessions->getLastSaveBytes(), deltaStats.sectorsWritten, deltaUs / 1000.0f);
+    }
+    shimSdResetStats();
+    sessions->save(3, *session);
+    ShimSdStats fullStats = shimSdGetStats();
+    sessions->attach(3, nullptr);
+    Serial.printf("  Full save    %6u bytes, %3u sectors, %6.1f ms (autosave %s)\n",
+                  sessions->getLastSaveBytes(), fullStats.sectorsWritten,
+                  sessions->getLastSaveUs() / 1000.0f, deltaOk ? "OK" : "FAILED");
+
+    // Session switch budget
+    sessions->setBudgetUs(250000);
+    sessions->load(3, *loaded);
+    Serial.printf("  Session switch %.1f ms vs 250 ms budget: %s\n",
+                  sessions->getLastLoadUs() / 1000.0f,
+                  sessions->getOverBudgetCount() == 0 ? "OK" : "OVER");
+
+    // Index: 32 sessions listed at boot without opening their files
+    for (uint8_t slot = 32; slot < 64; slot++) {
+        snprintf(sparse->name, sizeof(sparse->name), "Song %u", slot);
+        sparse->modifiedTime = 1700000000 + slot;
+        sessions->save(slot, *sparse);
+    }
+    uint8_t count = sessions->getSessionCount();
+    SessionManager* booted = new SessionManager();
+    shimSdResetStats();
+    start = micros();
+    bool indexOk = booted->begin() && booted->getIndexScanCount() == 0 && booted->getSessionCount() == count;
+    uint32_t indexUs = micros() - start;
+    ShimSdStats indexStats = shimSdGetStats();
+    const SessionIndexEntry* info = booted->getSessionInfo(63);
+    indexOk &= info && strcmp(info->name, "Song 63") == 0 && info->modifiedTime == 1700000063
+            && info->sessionCrc == sparse->crc32 && !booted->getSessionInfo(100);
+    delete booted;
+
+    SD.remove("/sessions/index.bin");
+    booted = new SessionManager();
+    start = micros();
+    indexOk &= booted->begin() && booted->getIndexScanCount() == count && booted->getSessionCount() == count;
+    uint32_t scanUs = micros() - start;
+    info = booted->getSessionInfo(63);
+    indexOk &= info && strcmp(info->name, "Song 63") == 0 && info->modifiedTime == 1700000063
+            && info->sessionCrc == sparse->crc32;
+    delete booted;
+    Serial.printf("  Boot listing %u sessions: index %.1f ms (%u reads), rescan %.1f ms (%s)\n",
+                  count, indexUs / 1000.0f, indexStats.readCalls, scanUs / 1000.0f, indexOk ? "OK" : "FAILED");
+
+    // Preload cache: a set-list switch is a copy out of PSRAM
+    bool cacheOk = sessions->setCacheSize(2) == 2 && sessions->preload(3);
+    sessions->setBudgetUs(0);
+    shimSdResetStats();
+    cacheOk &= sessions->load(3, *loaded) && memcmp(session, loaded, sizeof(SessionFile)) == 0;
+    cacheOk &= shimSdGetStats().readCalls == 0 && sessions->getCacheHits() == 1;
+
+    // Saves keep the cached copy in step with the card
+    session->controls[200].ccNumber ^= 3;
+    session->snapshots[11].values[5] ^= 0x77;
+    cacheOk &= sessions->saveSection(3, SESSION_SECTION_CONTROLS, *session)
+            && sessions->saveSection(3, SESSION_SECTION_SNAPSHOT, *session, 11);
+    cacheOk &= sessions->load(3, *loaded) && memcmp(session, loaded, sizeof(SessionFile)) == 0;
+
+    // Least recently used goes first
+    sessions->load(32, *loaded);
+    sessions->load(33, *loaded);
+    cacheOk &= !sessions->isCached(3) && sessions->isCached(32) && sessions->isCached(33);
+    sessions->preload(3);
+    cacheOk &= sessions->isCached(3) && !sessions->isCached(32);
+    Serial.printf("  Preloaded switch: 0 reads vs %.1f ms from SD (%s)\n",
+                  sessions->getLastLoadUs() / 1000.0f, cacheOk ? "OK" : "FAILED");
+
+    shimSdSetTiming(0, 0, 0);
+    shimUseManualClock(false);
+
+    // Power loss at every mutation of a full save and a section save: after
+    // recovery the slot holds the old or the new session, nothing else
+    SessionFile* before = new SessionFile();
+    SessionFile* after = new SessionFile();
+    for (uint8_t mode = 0; mode < 3; mode++) {
+        memcpy(before, session, sizeof(SessionFile));
+        memcpy(after, session, sizeof(SessionFile));
+        after->snapshots[2].values[7] ^= 0x5A;
+        after->globalZeroMask ^= 4;
+        sessions->save(5, *before);
+        sessions->save(6, *after);      // Fills the new CRCs
+
+        uint32_t cuts = 0;
+        uint32_t failures = 0;
+        for (uint32_t n = 0; ; n++) {
+            shimSdPowerRestore();
+            sessions->save(5, *before);
+
+            shimSdPowerLossAfter(n);
+            if (mode == 0) {
+                sessions->save(5, *after);
+            } else if (mode == 1) {
+                sessions->saveSection(5, SESSION_SECTION_SNAPSHOT, *after, 2);
+                sessions->saveSection(5, SESSION_SECTION_MASKS, *after);
+            } else {
+                memcpy(loaded, before, sizeof(SessionFile));
+                sessions->attach(5, loaded);
+                loaded->snapshots[2].values[7] = after->snapshots[2].values[7];
+                loaded->globalZeroMask = after->globalZeroMask;
+                sessions->markSnapshotChanged(2);
+                sessions->markMasksChanged();
+                sessions->saveChanges();
+                sessions->attach(5, nullptr);
+            }
+            bool lost = shimSdPowerLost();
+            shimSdPowerRestore();
+            if (!lost) {
+                break;
+            }
+            cuts++;
+
+            SessionManager rebooted;
+            rebooted.begin();
+            bool ok = rebooted.load(5, *loaded)
+                   && (memcmp(loaded, before, sizeof(SessionFile)) == 0 ||
+                       memcmp(loaded, after, sizeof(SessionFile)) == 0);
+            ok &= !SD.exists("/sessions/session005.tmp") && !SD.exists("/sessions/session005.bak")
+               && !SD.exists("/sessions/session005.jnl");
+
+            // The index entry follows whichever session survived
+            SessionManager relisted;
+            relisted.begin();
+            const SessionIndexEntry* entry = relisted.getSessionInfo(5);
+            ok &= entry && entry->sessionCrc == loaded->crc32 && relisted.getIndexScanCount() == 0;
+            failures += ok ? 0 : 1;
+        }
+        Serial.printf("  Power loss during %s: %u cut points, %s\n",
+                      mode == 0 ? "full save   " : mode == 1 ? "section save" : "autosave    ", cuts,
+                      failures == 0 ? "always old or new (OK)" : "CORRUPTED");
+    }
+    delete after;
+    delete before;
+
+    // Host CPU cost without card latency
+    sessions->setCacheSize(0);
+    runBenchmark("SessionManager::load (CPU only)", 2000, [&](uint32_t) {
+        sessions->load(3, *loaded);
+    });
+    runBenchmark("SessionManager::loadSection (snapshot)", 20000, [&](uint32_t i) {
+        sessions->loadSection(3, SESSION_SECTION_SNAPSHOT, *loaded, i & 15);
+    });
+    sessions->setCacheSize(1);
+    sessions->preload(3);
+    runBenchmark("SessionManager::load (preloaded)", 20000, [&](uint32_t) {
+        sessions->load(3, *loaded);
+    });
+
+    delete sparse;
+    delete loaded;
+    delete session;
+    delete sessions;
+}
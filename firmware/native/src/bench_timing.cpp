@@ -0,0 +1,87 @@
+/**
+ * Scan timing model (ESP32 scan pacing: ScanScheduler vs vTaskDelayUntil)
+ */
+
+#include "Bench.h"
+#include <ScanScheduler.h>
+
+static const uint32_t SCAN_RATES[] = {1000, 3000, 5000, 7777, 8000, 10000};
+
+void runTimingBenchmarks() {
+    benchSection("Scan timing (ScanScheduler)");
+
+    // Rate accuracy: gptimer alarm counts vs whole-tick vTaskDelayUntil pacing
+    Serial.printf("  %-10s %-28s %s\n", "Requested", "gptimer @ 10MHz", "vTaskDelayUntil @ 1kHz tick");
+    for (uint32_t rate : SCAN_RATES) {
+        uint64_t alarmCount = ScanScheduler::alarmCountFor(rate, ScanScheduler::TIMER_RESOLUTION_HZ);
+        float actual = ScanScheduler::actualRateHz(alarmCount, ScanScheduler::TIMER_RESOLUTION_HZ);
+        float errorPpm = (actual - rate) * 1e6f / rate;
+
+        TickType_t ticks = pdMS_TO_TICKS(1000 / rate);
+        char tickRate[32];
+        if (ticks == 0) {
+            snprintf(tickRate, sizeof(tickRate), "0 ticks (unpaced)");
+        } else {
+            snprintf(tickRate, sizeof(tickRate), "%.1f Hz", (float)configTICK_RATE_HZ / ticks);
+        }
+
+        char timerRate[40];
+        snprintf(timerRate, sizeof(timerRate), "%.2f Hz (%+.0f ppm)", actual, errorPpm);
+        Serial.printf("  %-10u %-28s %s\n", rate, timerRate, tickRate);
+    }
+
+    // Statistics against a simulated clock: 5kHz with up to +/-3us ISR jitter
+    // and one late task wake (two ticks taken at once)
+    ScanScheduler model;
+    model.begin(5000);  // Timer created but never started
+    uint32_t seed = 4242;
+    uint32_t firstTick = 0, lastTick = 0;
+    uint32_t expectedMin = 0xFFFFFFFF, expectedMax = 0, expectedJitter = 0;
+    for (uint32_t i = 0; i < 10000; i++) {
+        seed = seed * 1664525 + 1013904223;
+        uint32_t tick = 1000 + i * 200 + (seed >> 29);  // 0..7us late
+        if (i == 0) {
+            firstTick = tick;
+        } else {
+            uint32_t interval = tick - lastTick;
+            uint32_t jitter = interval > 200 ? interval - 200 : 200 - interval;
+            expectedMin = interval < expectedMin ? interval : expectedMin;
+            expectedMax = interval > expectedMax ? interval : expectedMax;
+            expectedJitter = jitter > expectedJitter ? jitter : expectedJitter;
+        }
+        lastTick = tick;
+
+        model.recordTick(tick);
+        model.recordWake((i % 100 == 50) ? 2 : 1, tick + ((i % 100 == 50) ? 12 : 5));
+    }
+
+    ScanSchedulerStats stats = model.getStats();
+    bool statsOk = stats.tickCount == 10000 && stats.minInterval == expectedMin &&
+                   stats.maxInterval == expectedMax && stats.maxJitter == expectedJitter &&
+                   stats.avgInterval == (lastTick - firstTick) / 9999 &&
+                   stats.overruns == 100 && stats.maxWakeLatency == 12;
+    Serial.printf("  Simulated 5kHz stats: interval %u-%u us (avg %u), jitter %u us, overruns %u, wake %u us: %s\n",
+        stats.minInterval, stats.maxInterval, stats.avgInterval, stats.maxJitter, stats.overruns,
+        stats.maxWakeLatency, statsOk ? "OK" : "WRONG");
+
+    // Real-time run of the shim timer (host scheduling jitter, not device timing)
+    ScanScheduler scheduler;
+    uint32_t ticksTaken = 0;
+    if (scheduler.begin(5000) && scheduler.start()) {
+        uint32_t startUs = micros();
+        while (micros() - startUs < 200000) {
+            ticksTaken += scheduler.waitForTick();
+        }
+        uint32_t elapsedUs = micros() - startUs;
+        scheduler.stop();
+
+        ScanSchedulerStats live = scheduler.getStats();
+        Serial.printf("  Host timer 5kHz for %ums: %.1f Hz measured, interval %u-%u us (avg %u), jitter %u us, overruns %u\n",
+            elapsedUs / 1000, ticksTaken * 1e6f / elapsedUs, live.minInterval, live.maxInterval,
+            live.avgInterval, live.maxJitter, live.overruns);
+    }
+
+    runBenchmark("ScanScheduler::recordTick", 1000000, [&](uint32_t i) {
+        model.recordTick(i * 200);
+    });
+}
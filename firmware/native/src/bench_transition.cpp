@@ -0,0 +1,154 @@
+/**
+ * Snapshot transition benchmarks (Teensy morph of all 619 controls)
+ */
+
+#include "Bench.h"
+#include <NativeShim.h>
+#include <Protocol.h>
+#include <StateManager.h>
+#include <TransitionEngine.h>
+#include <MIDIClock.h>
+
+static uint32_t s_emitted14bit;
+
+static void countOutput(uint16_t globalID, uint16_t /*value14*/, void* /*arg*/) {
+    if (globalID == 0) {
+        s_emitted14bit++;
+    }
+}
+
+void runTransitionBenchmarks() {
+    benchSection("Snapshot transitions (619 controls)");
+
+    // Curve endpoints and monotonicity
+    bool curvesOk = true;
+    for (uint8_t type = TRANSITION_LINEAR; type <= TRANSITION_STEPPED; type++) {
+        uint16_t previous = 0;
+        for (uint32_t p = 0; p <= 65536; p += 64) {
+            uint16_t y = TransitionEngine::ease((TransitionType)type, p);
+            curvesOk &= (y >= previous);
+            previous = y;
+        }
+        curvesOk &= TransitionEngine::ease((TransitionType)type, 0) == 0;
+        curvesOk &= TransitionEngine::ease((TransitionType)type, 65536) == 32768;
+    }
+    Serial.printf("  Easing curves monotonic, 0 -> 32768: %s\n", curvesOk ? "OK" : "FAILED");
+
+    runBenchmark("TransitionEngine::ease (LUT lookup)", 1000000, [&](uint32_t i) {
+        benchSink(TransitionEngine::ease(TRANSITION_EASE_IN_OUT, (i * 97) & 0xFFFF));
+    });
+
+    StateManager* state = new StateManager();
+    state->begin();
+
+    // Control 0 is 14-bit; control 1 is zeroed in the snapshot
+    ControlConfig config = *state->getConfig(0);
+    config.resolution = 1;
+    state->setConfig(0, config);
+
+    Snapshot* snapshot = new Snapshot();
+    memset(snapshot, 0, sizeof(Snapshot));
+    for (uint16_t i = 0; i < TOTAL_CONTROLS; i++) {
+        snapshot->values[i] = 127;
+        state->setValue(i, 0);
+    }
+    snapshot->zeroMask[0] = 0x0002;
+    snapshot->transition.type = TRANSITION_LINEAR;
+    snapshot->transition.timebase = TIMEBASE_MILLISECONDS;
+    snapshot->transition.duration = 1000;
+
+    TransitionEngine* transitions = new TransitionEngine();
+    transitions->begin(*state);
+    transitions->setOutputCallback(countOutput);
+    s_emitted14bit = 0;
+
+    // All controls morph 0 -> 127 over 1 s with a 1 ms loop
+    shimUseManualClock(true);
+    uint16_t moving = transitions->start(*snapshot);
+
+    auto start = std::chrono::steady_clock::now();
+    double worstNs = 0;
+    uint32_t ticks = 0;
+    while (transitions->isActive() && ticks < 2000) {
+        shimAdvanceMicros(1000);
+        auto tickStart = std::chrono::steady_clock::now();
+        transitions->update();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - tickStart).count();
+        if (ns > worstNs) {
+            worstNs = ns;
+        }
+        ticks++;
+    }
+    double totalNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    shimUseManualClock(false);
+
+    bool landed = true;
+    for (uint16_t i = 0; i < TOTAL_CONTROLS; i++) {
+        uint8_t expected = (i == 1) ? 0 : 127;
+        landed &= state->getValue(i) == expected;
+        landed &= (state->getState(i)->stateFlags & STATE_FLAG_TRANSITIONING) == 0;
+    }
+
+    landed &= !state->getTransitioningControls().any();
+
+    // 617 7-bit controls emit each of 127 steps once; the 14-bit one more often
+    uint32_t expected7bit = 617 * 127;
+    bool emittedOk = transitions->getEmittedCount() == expected7bit + s_emitted14bit && s_emitted14bit > 127;
+
+    Serial.printf("  Morph 618 controls over 1 s: %u ticks, avg %.0f ns/tick, worst %.0f ns/tick\n",
+        ticks, totalNs / ticks, worstNs);
+    Serial.printf("  Emitted %u values (14-bit control: %u), moving %u, landed on targets: %s\n",
+        transitions->getEmittedCount(), s_emitted14bit, moving,
+        (moving == 618 && landed && emittedOk) ? "OK" : "FAILED");
+
+    // MIDI clock at 120 BPM (20833 us/tick) with +/-2 ms of USB jitter
+    MIDIClock clock;
+    clock.begin();
+    shimUseManualClock(true);
+    for (uint16_t i = 0; i < 96; i++) {
+        int32_t jitter = (i % 3 == 0) ? 2000 : (i % 3 == 1) ? -2000 : 0;
+        shimAdvanceMicros(20833 + jitter);
+        clock.handleClock(micros());
+    }
+    uint32_t bpm = clock.getBPMx100();
+    bool tempoOk = (bpm > 11900 && bpm < 12100);
+    Serial.printf("  MIDI clock with +/-2 ms jitter: %u.%02u BPM (%u steps clamped): %s\n",
+        bpm / 100, bpm % 100, clock.getJitterLimitedCount(), tempoOk ? "OK" : "FAILED");
+
+    // 1-bar morph started at tick 120 runs at least a bar, to the bar line at tick 288
+    clock.handleStart();
+    for (uint16_t i = 0; i <= 120; i++) {
+        shimAdvanceMicros(20833);
+        clock.handleClock(micros());
+    }
+    for (uint16_t i = 0; i < TOTAL_CONTROLS; i++) {
+        state->setValue(i, 0);
+    }
+    snapshot->transition.timebase = TIMEBASE_MIDI_CLOCK;
+    snapshot->transition.duration = MUSICAL_TIME_1_BAR;
+    transitions->setClock(&clock);
+    transitions->start(*snapshot);
+    bool synced = transitions->isClockSynced();
+
+    uint32_t landedTick = 0;
+    bool midTickOk = true;
+    while (transitions->isActive() && clock.getTicks() < 400) {
+        // Progress advances between ticks, without waiting for the next one
+        uint32_t before = transitions->getProgress();
+        shimAdvanceMicros(10000);
+        transitions->update();
+        midTickOk &= !transitions->isActive() || transitions->getProgress() > before;
+        shimAdvanceMicros(10833);
+        clock.handleClock(micros());
+        transitions->update();
+        landedTick = clock.getTicks();
+    }
+    shimUseManualClock(false);
+
+    Serial.printf("  Clock-synced 1-bar morph from tick 120: landed at tick %u: %s\n",
+        landedTick, (synced && midTickOk && landedTick == 288 && state->getValue(0) == 127) ? "OK" : "FAILED");
+
+    delete transitions;
+    delete snapshot;
+    delete state;
+}
@@ -0,0 +1,35 @@
+/**
+ * Native (Host) Benchmark Runner
+ *
+ * Builds the shared firmware libraries against the Arduino/FreeRTOS shim
+ * and microbenchmarks the per-scan (ESP32) and per-event (Teensy) hot paths,
+ * plus a model of the ESP32 scan timer pacing, the batched I2C link,
+ * snapshot transitions and session storage on a simulated SD card.
+ * Run after changes to these paths to catch performance regressions
+ * without hardware:
+ *
+ *   cd firmware/native
+ *   pio run -e native -t exec
+ *
+ * Numbers are host ns/op; compare runs on the same machine only.
+ */
+
+#include <Arduino.h>
+#include "Bench.h"
+
+int main() {
+    Serial.begin(115200);
+
+    Serial.println("MIDI Kraken - Native Benchmarks");
+    Serial.println("===============================");
+
+    runScanBenchmarks();
+    runTimingBenchmarks();
+    runLinkBenchmarks();
+    runEventBenchmarks();
+    runTransitionBenchmarks();
+    runSessionBenchmarks();
+
+    Serial.println();
+    return 0;
+}
@@ -19,8 +19,12 @@
 #include <Arduino.h>
 #include <usb_midi.h>
 #include <Protocol.h>
+#include <ControlMap.h>
 #include <MultiI2CMaster.h>
 #include <StateManager.h>
+#include <ValueEngine.h>
+#include <TransitionEngine.h>
+#include <MIDIClock.h>
 #include <MIDIEngine.h>
 #include <Joystick.h>
 #include <Diagnostics.h>
@@ -34,8 +38,10 @@
 #define JOYSTICK_Y_PIN A1
 #define JOYSTICK_BTN_PIN 2
 
-// Event Interrupt Pin
-#define EVENT_INT_PIN 3
+// Event ready lines, one per ESP32 panel (index 0 = 0x08 ... 8 = 0x10).
+// A panel wired to -1 is polled on SLAVE_POLL_INTERVAL_US instead.
+const int EVENT_PINS[9] = {3, 4, 5, 6, 7, 8, 9, 22, 23};
+#define SLAVE_POLL_INTERVAL_US 1000
 
 // LED Pin
 #define LED_PIN 13
@@ -46,22 +52,56 @@
 
 MultiI2CMaster i2cMaster;
 StateManager stateManager;
+ValueEngine valueEngine;
+TransitionEngine transitionEngine;
+MIDIClock midiClock;
 MIDIEngine midiEngine;
 Joystick joystick(JOYSTICK_X_PIN, JOYSTICK_Y_PIN, JOYSTICK_BTN_PIN);
 Diagnostics diagnostics;
 
 // Statistics
 uint32_t eventsProcessed = 0;
-uint32_t midiMessagesSent = 0;
 uint32_t lastStatsTime = 0;
 
 // ============================================================================
-// INTERRUPT HANDLER
+// CALLBACKS
 // ============================================================================
 
-void onEventInterrupt() {
-    // ESP32 has events ready - poll immediately
-    i2cMaster.poll();
+/**
+ * Snapshot transition output (one changed value)
+ */
+void sendTransitionValue(uint16_t globalID, uint16_t value14, void* arg) {
+    const ControlRoute* route = stateManager.getRoute(globalID);
+    if (route && (route->flags & ROUTE_FLAG_ENABLED)) {
+        midiEngine.processControl14bit(*route, value14);
+    }
+}
+
+/**
+ * Button press with an action that produces no CC value
+ */
+void handleButtonAction(uint16_t globalID) {
+    ButtonAction action;
+    if (!valueEngine.getButtonAction(globalID, action)) {
+        return;
+    }
+
+    switch (action) {
+        case BUTTON_BANK_SWITCH: {
+            // A panel's bank button flips that panel; one on the snapshot
+            // panel flips every panel. Either way only route pointers change.
+            uint8_t panel = stateManager.getPanel(globalID);
+            if (panel == PANEL_SNAPSHOT) {
+                stateManager.setBank(!stateManager.isBankB());
+            } else {
+                stateManager.setPanelBank(panel, !stateManager.isPanelBankB(panel));
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
 }
 
 // ============================================================================
@@ -89,16 +129,37 @@ void setup() {
     }
     Serial.println("I2C master initialized (3 buses)");
 
-    // Attach interrupt for event notifications
-    i2cMaster.attachInterrupt(EVENT_INT_PIN, onEventInterrupt);
-    Serial.println("Event interrupt attached");
+    // Ready lines: the pin ISRs only flag slaves; poll() services them
+    i2cMaster.setPollInterval(SLAVE_POLL_INTERVAL_US);
+    for (uint8_t i = 0; i < 9; i++) {
+        if (EVENT_PINS[i] >= 0) {
+            i2cMaster.setEventPin(0x08 + i, EVENT_PINS[i]);
+        }
+    }
+    Serial.println("Event ready lines attached");
 
     // Initialize state manager
     stateManager.begin();
     Serial.println("State manager initialized (619 controls)");
 
+    // Precompute per-control value parameters from the configs
+    valueEngine.begin(stateManager);
+    Serial.println("Value engine initialized");
+
+    // Snapshot morphing (values go out through MIDIEngine as they change)
+    transitionEngine.begin(stateManager);
+    transitionEngine.setOutputCallback(sendTransitionValue);
+
+    // Clock-synced morphs follow the incoming MIDI clock
+    midiClock.begin();
+    transitionEngine.setClock(&midiClock);
+    Serial.println("Transition engine initialized");
+
     // Initialize MIDI engine
     midiEngine.begin();
+    // Batch USB packets for at most 1 ms: the main loop is much faster
+    // than the output rate, so per-loop flushes carry ~1 message each
+    midiEngine.setFlushPolicy(MIDI_FLUSH_DEADLINE, 1000);
     Serial.println("MIDI engine initialized (4 virtual devices)");
 
     // Initialize joystick
@@ -140,28 +201,30 @@ void setup() {
 void loop() {
     uint32_t loopStart = micros();
 
-    // Poll I2C buses for events (if not triggered by interrupt)
-    static uint32_t lastPoll = 0;
-    if (micros() - lastPoll > 1000) {  // Poll every 1ms if no interrupts
-        i2cMaster.poll();
-        lastPoll = micros();
-    }
+    // Advance the I2C poll engines (non-blocking; services only the slaves
+    // whose ready line fired, busiest first, on all 3 buses at once)
+    i2cMaster.poll();
 
     // Process events from I2C master
     EventMessage event;
     while (i2cMaster.getEvent(event)) {
         eventsProcessed++;
 
-        // Update state
-        stateManager.setValue(event.globalID, event.value);
+        // Moving a control by hand takes it out of a running transition
+        transitionEngine.cancel(event.globalID);
+
+        // Turn the raw delta/press into a value (disabled controls return false)
+        ValueResult result;
+        if (valueEngine.process(event, stateManager.getValue(event.globalID), result)) {
+            stateManager.setValue(event.globalID, result.value);
 
-        // Get control configuration
-        const ControlConfig* config = stateManager.getConfig(event.globalID);
-        if (config && (config->flags & CONTROL_FLAG_ENABLED)) {
-            // Send MIDI
-            if (midiEngine.processControl(*config, event.value)) {
-                midiMessagesSent++;
+            // Send MIDI (compiled route for the panel's active bank)
+            const ControlRoute* route = stateManager.getRoute(event.globalID);
+            if (route) {
+                midiEngine.processControl(*route, result.midiValue);
             }
+        } else if (event.flags & EVENT_FLAG_BUTTON_PRESSED) {
+            handleButtonAction(event.globalID);
         }
 
         diagnostics.recordEvent(false);
@@ -176,7 +239,6 @@ void loop() {
     if (abs((int)currentPitch - (int)lastPitch) > 50) {  // Threshold
         midiEngine.sendPitchBend(0, 0, currentPitch);  // Device 0, Channel 0
         lastPitch = currentPitch;
-        midiMessagesSent++;
     }
 
     // Send modulation from joystick Y-axis
@@ -185,7 +247,6 @@ void loop() {
     if (abs((int)currentMod - (int)lastMod) > 2) {  // Threshold
         midiEngine.sendCC(0, 0, 1, currentMod);  // CC 1 = Modulation
         lastMod = currentMod;
-        midiMessagesSent++;
     }
 
     // Joystick button - send all notes off (panic)
@@ -196,11 +257,19 @@ void loop() {
         }
     }
 
-    // Read MIDI from USB (for MIDI learn, etc.)
+    // Read MIDI from USB: clock/transport feeds the clock tracker
+    // (everything else: MIDI learn, etc.)
     while (usbMIDI.read()) {
-        // Handle incoming MIDI if needed
+        midiClock.processMessage(usbMIDI.getType(), usbMIDI.getData1(), usbMIDI.getData2(), micros());
     }
 
+    // Advance snapshot transitions (only controls still in flight)
+    transitionEngine.update();
+
+    // Send queued CC / pitch bend values at the output rate (latest value wins)
+    // and flush this iteration's USB-MIDI packets as one USB transaction
+    midiEngine.update();
+
     // Update diagnostics
     uint32_t loopTime = micros() - loopStart;
     diagnostics.recordScanCycle(loopTime);
@@ -210,10 +279,34 @@ void loop() {
     if (millis() - lastStatsTime > 5000) {
         Serial.println("=== Statistics ===");
         Serial.printf("Events processed: %u\n", eventsProcessed);
-        Serial.printf("MIDI messages sent: %u\n", midiMessagesSent);
+        Serial.printf("MIDI messages sent: %u (coalesced %u, pending %u)\n",
+            midiEngine.getMessagesSent(), midiEngine.getMessagesCoalesced(),
+            midiEngine.getPendingCount());
         Serial.printf("MIDI message rate: %.1f msg/sec\n", midiEngine.getMessageRate());
+        if (midiEngine.getUsbTransactions() > 0) {
+            Serial.printf("MIDI messages per USB transaction: %.2f\n",
+                (float)midiEngine.getUsbPackets() / midiEngine.getUsbTransactions());
+        }
+        Serial.printf("Transition: %u controls in flight\n", transitionEngine.getActiveCount());
+        if (midiClock.hasTempo()) {
+            uint32_t bpm = midiClock.getBPMx100();
+            Serial.printf("MIDI clock: %u.%02u BPM, %s, tick %u\n", bpm / 100, bpm % 100,
+                midiClock.isRunning(micros()) ? "running" : "stopped", midiClock.getTicks());
+        }
         Serial.printf("I2C event queue: %u\n", i2cMaster.getQueuedEventCount());
+        Serial.printf("I2C slave polls: %u\n", i2cMaster.getPollCount());
         Serial.printf("Loop time: %u us\n", loopTime);
+
+        // Batch link health (only slaves with problems)
+        for (uint8_t addr = 0x08; addr <= 0x10; addr++) {
+            I2CLinkStats link;
+            if (i2cMaster.getLinkStats(addr, link) &&
+                (link.batchesLost || link.batchesDuplicated || link.checksumErrors)) {
+                Serial.printf("  0x%02X: %u batches, %u lost, %u duplicate, %u CRC errors\n",
+                    addr, link.batchesReceived, link.batchesLost,
+                    link.batchesDuplicated, link.checksumErrors);
+            }
+        }
         Serial.println();
 
         diagnostics.printDiagnostics();